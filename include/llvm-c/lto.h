@@ -401,6 +401,27 @@ lto_codegen_compile(lto_code_gen_t cg, size_t* length);
 extern bool
 lto_codegen_compile_to_file(lto_code_gen_t cg, const char** name);
 
+/* @LOCALMOD-BEGIN */
+/**
+ * Sets the number of partitions the optimized merged module is split into
+ * by lto_codegen_compile_to_files(). The default is 1.
+ */
+extern void
+lto_codegen_set_num_partitions(lto_code_gen_t cg, unsigned num);
+
+/**
+ * Generates code for all added modules into one native object file per
+ * partition, each on a thread of its own. The objects are the same for a
+ * given number of partitions. Fewer objects are generated when the module
+ * has fewer functions than partitions or can not be split. The names of the
+ * files are written to names and their number to num. The names are owned
+ * by the lto_code_gen_t. Returns true on error.
+ */
+extern bool
+lto_codegen_compile_to_files(lto_code_gen_t cg, const char*** names,
+                             unsigned* num);
+/* @LOCALMOD-END */
+
 
 /**
  * Sets options to help debug codegen bugs.
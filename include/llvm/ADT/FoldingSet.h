@@ -147,6 +147,14 @@ public:
   /// clear - Remove all nodes from the folding set.
   void clear();
 
+  // @LOCALMOD-BEGIN
+  /// clearAndResize - Remove all nodes from the folding set and size the hash
+  /// table for EltCount nodes, shrinking it if it is larger than that. This
+  /// keeps clear() cheap for sets that are refilled many times and only
+  /// occasionally grow large.
+  void clearAndResize(unsigned EltCount);
+  // @LOCALMOD-END
+
   /// RemoveNode - Remove a node from the folding set, returning true if one
   /// was removed or false if the node was not in the folding set.
   bool RemoveNode(Node *N);
@@ -180,6 +188,12 @@ public:
   /// empty - Returns true if there are no nodes in the folding set.
   bool empty() const { return NumNodes == 0; }
 
+  // @LOCALMOD-BEGIN
+  /// capacity - Returns the number of nodes the folding set can hold before
+  /// the hash table has to grow.
+  unsigned capacity() const { return NumBuckets * 2; }
+  // @LOCALMOD-END
+
 private:
 
   /// GrowHashTable - Double the size of the hash table and rehash everything.
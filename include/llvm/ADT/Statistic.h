@@ -28,83 +28,99 @@
 
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Valgrind.h"
+#include <vector> // @LOCALMOD
 
 namespace llvm {
 class raw_ostream;
 
+// @LOCALMOD-BEGIN
+// Threads bump the statistic in one of a fixed number of shards, so concurrent
+// compilations rarely share the cache line of a counter. The shards are summed
+// whenever the value is read; reads taken while other threads are still
+// counting are only approximate, but no update is ever lost.
+// @LOCALMOD-END
 class Statistic {
 public:
   const char *Name;
   const char *Desc;
   volatile llvm::sys::cas_flag Value;
   bool Initialized;
+  unsigned Slot;  // @LOCALMOD: 1 + index of this statistic in each shard.
 
-  llvm::sys::cas_flag getValue() const { return Value; }
+  llvm::sys::cas_flag getValue() const; // @LOCALMOD
   const char *getName() const { return Name; }
   const char *getDesc() const { return Desc; }
 
   /// construct - This should only be called for non-global statistics.
   void construct(const char *name, const char *desc) {
     Name = name; Desc = desc;
-    Value = 0; Initialized = 0;
+    Value = 0; Initialized = 0; Slot = 0;
   }
 
+  // @LOCALMOD-BEGIN
   // Allow use of this class as the value itself.
-  operator unsigned() const { return Value; }
+  operator unsigned() const { return getValue(); }
   const Statistic &operator=(unsigned Val) {
-    Value = Val;
-    return init();
+    init();
+    set(Val);
+    return *this;
   }
 
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
-    sys::AtomicIncrement(&Value);
-    return init();
+    // The return value of this function and all those that follow is the
+    // statistic itself; reading it sums all shards and is only exact once
+    // the other threads have stopped counting.
+    init();
+    add(1);
+    return *this;
   }
 
   unsigned operator++(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
+    unsigned OldValue = getValue();
+    add(1);
     return OldValue;
   }
 
   const Statistic &operator--() {
-    sys::AtomicDecrement(&Value);
-    return init();
+    init();
+    add(-1U);
+    return *this;
   }
 
   unsigned operator--(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
+    unsigned OldValue = getValue();
+    add(-1U);
     return OldValue;
   }
 
   const Statistic &operator+=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, V);
-    return init();
+    init();
+    add(V);
+    return *this;
   }
 
   const Statistic &operator-=(const unsigned &V) {
     if (!V) return *this;
-    sys::AtomicAdd(&Value, -V);
-    return init();
+    init();
+    add(-V);
+    return *this;
   }
 
   const Statistic &operator*=(const unsigned &V) {
-    sys::AtomicMul(&Value, V);
-    return init();
+    init();
+    scale(V, 1);
+    return *this;
   }
 
   const Statistic &operator/=(const unsigned &V) {
-    sys::AtomicDiv(&Value, V);
-    return init();
+    init();
+    scale(1, V);
+    return *this;
   }
+  // @LOCALMOD-END
 
 protected:
   Statistic &init() {
@@ -115,12 +131,21 @@ protected:
     return *this;
   }
   void RegisterStatistic();
+  // @LOCALMOD-BEGIN
+  /// add - Atomically add V to the calling thread's shard of this statistic.
+  void add(unsigned V);
+  /// set - Make V the value of this statistic, clearing every shard.
+  void set(unsigned V);
+  /// scale - Multiply the value of this statistic by Mul and divide it by
+  /// Div. Updates made by other threads meanwhile are kept unscaled.
+  void scale(unsigned Mul, unsigned Div);
+  // @LOCALMOD-END
 };
 
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
 #define STATISTIC(VARNAME, DESC) \
-  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, 0, 0 }
+  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, 0, 0, 0 }
 
 /// \brief Enable the collection and printing of statistics.
 void EnableStatistics();
@@ -134,6 +159,26 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+// @LOCALMOD-BEGIN
+/// \brief The value of one statistic, as captured by GetStatistics().
+struct StatisticSnapshot {
+  const char *Name;
+  const char *Desc;
+  unsigned Value;
+};
+
+/// \brief Capture the value of every statistic that is currently non-zero,
+/// sorted by name. Unlike the -stats report this works whether or not
+/// statistics output was enabled, so a long-lived process can collect the
+/// statistics of each job.
+void GetStatistics(std::vector<StatisticSnapshot> &Values);
+
+/// \brief Reset every statistic to zero, e.g. between two translations in
+/// the same process. Updates made by other threads while this runs are
+/// either cleared or kept, never torn.
+void ResetStatistics();
+// @LOCALMOD-END
+
 } // End llvm namespace
 
 #endif
@@ -17,6 +17,7 @@
 #ifndef LLVM_BITCODE_ARCHIVE_H
 #define LLVM_BITCODE_ARCHIVE_H
 
+#include "llvm/ADT/StringRef.h" // @LOCALMOD
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/Support/Path.h"
@@ -53,7 +54,8 @@ class ArchiveMember : public ilist_node<ArchiveMember> {
       BitcodeFlag         = 8,     ///< Member is bitcode
       HasPathFlag         = 16,    ///< Member has a full or partial path
       HasLongFilenameFlag = 32,    ///< Member uses the long filename syntax
-      StringTableFlag     = 64     ///< Member is an ar(1) format string table
+      StringTableFlag     = 64,    ///< Member is an ar(1) format string table
+      LLVMSymbolIndexFlag = 128    ///< Member is an LLVM symbol index @LOCALMOD
     };
 
   /// @}
@@ -124,6 +126,12 @@ class ArchiveMember : public ilist_node<ArchiveMember> {
     /// @brief Determine if this member is the ar(1) string table.
     bool isStringTable() const { return flags&StringTableFlag; }
 
+    // @LOCALMOD-BEGIN
+    /// @returns true iff the archive member is the hashed LLVM symbol index
+    /// @brief Determine if this member is the LLVM symbol index.
+    bool isLLVMSymbolIndex() const { return flags&LLVMSymbolIndexFlag; }
+    // @LOCALMOD-END
+
     /// @returns true iff the archive member is a bitcode file.
     /// @brief Determine if this member is a bitcode file.
     bool isBitcode() const { return flags&BitcodeFlag; }
@@ -342,7 +350,7 @@ class Archive {
     /// findModuleDefiningSymbol methods instead.
     /// @returns the Archive's symbol table.
     /// @brief Get the archive's symbol table
-    const SymTabType& getSymbolTable() { return symTab; }
+    const SymTabType& getSymbolTable(); // @LOCALMOD
 
     /// This method returns the offset in the archive file to the first "real"
     /// file member. Archive files, on disk, have a signature and might have a
@@ -415,13 +423,21 @@ class Archive {
     /// name will be truncated at 15 characters. If \p Compress is specified,
     /// all archive members will be compressed before being written. If
     /// \p PrintSymTab is true, the symbol table will be printed to std::cout.
+    // @LOCALMOD-BEGIN
+    /// Bitcode members are scanned for symbols on up to \p NumThreads
+    /// threads, each with its own LLVMContext; the archive written does not
+    /// depend on \p NumThreads.
+    // @LOCALMOD-END
     /// @returns true if an error occurred, \p error set to error message;
     /// returns false if the writing succeeded.
     /// @brief Write (possibly modified) archive contents to disk
     bool writeToDisk(
       bool CreateSymbolTable=false,   ///< Create Symbol table
       bool TruncateNames=false,       ///< Truncate the filename to 15 chars
-      std::string* ErrMessage=0       ///< If non-null, where error msg is set
+      std::string* ErrMessage=0,      ///< If non-null, where error msg is set
+      // @LOCALMOD-BEGIN
+      unsigned NumThreads=1           ///< Threads reading member symbols
+      // @LOCALMOD-END
     );
 
     /// This method adds a new file to the archive. The \p filename is examined
@@ -474,21 +490,38 @@ class Archive {
     /// @brief Load just the symbol table.
     bool loadSymbolTable(std::string* ErrMessage);
 
-    /// @brief Write the symbol table to an ofstream.
-    void writeSymbolTable(std::ofstream& ARFile);
+    // @LOCALMOD-BEGIN
+    /// @brief Write the symbol table to a buffer and advance Out past it.
+    void writeSymbolTable(char*& Out);
+    // @LOCALMOD-END
+
+    // @LOCALMOD-BEGIN
+    /// @brief Check the hashed symbol index member and remember where it is,
+    /// unless it was built for a symbol table of a different size.
+    bool setSymbolIndex(const char* data, unsigned size, unsigned tableSize,
+                        std::string* error);
+
+    /// @brief Look up a symbol in the symbol index or, if the archive has
+    /// none, in the symbol table. Sets Offset as it is stored in symTab.
+    bool lookupSymbol(StringRef Name, unsigned& Offset) const;
 
-    /// Writes one ArchiveMember to an ofstream. If an error occurs, returns
-    /// false, otherwise true. If an error occurs and error is non-null then
-    /// it will be set to an error message.
-    /// @returns false if writing member succeeded,
-    /// returns true if writing member failed, \p error set to error message.
-    bool writeMember(
+    /// @brief Write the hashed symbol index for symTab as an archive member.
+    void writeSymbolIndex(char*& Out);
+
+    /// Writes one ArchiveMember with the given data to a buffer and advances
+    /// \p Out past it. The buffer must have room for getMemberSize() bytes.
+    void writeMember(
       const ArchiveMember& member, ///< The member to be written
-      std::ofstream& ARFile,       ///< The file to write member onto
-      bool CreateSymbolTable,      ///< Should symbol table be created?
-      bool TruncateNames,          ///< Should names be truncated to 11 chars?
-      std::string* ErrMessage      ///< If non-null, place were error msg is set
-    );
+      const char* data,            ///< The member's content
+      unsigned size,               ///< The size of the member's content
+      bool TruncateNames,          ///< Should names be truncated to 15 chars?
+      char*& Out                   ///< Where to write the member
+    ) const;
+
+    /// @brief Get the number of bytes writeMember() writes for a member.
+    unsigned getMemberSize(const ArchiveMember& member, unsigned size,
+                           bool TruncateNames) const;
+    // @LOCALMOD-END
 
     /// @brief Fill in an ArchiveMemberHeader from ArchiveMember.
     bool fillHeader(const ArchiveMember&mbr,
@@ -519,6 +552,11 @@ class Archive {
     SymTabType symTab;        ///< The symbol table
     std::string strtab;       ///< The string table for long file names
     unsigned symTabSize;      ///< Size in bytes of symbol table
+    // @LOCALMOD-BEGIN
+    const char* symTabData;   ///< Symbol table not parsed into symTab yet
+    const char* symIdx;       ///< Mapped hashed symbol index, if any
+    unsigned symIdxSize;      ///< Size in bytes of symIdx
+    // @LOCALMOD-END
     unsigned firstFileOffset; ///< Offset to first normal file.
     ModuleMap modules;        ///< The modules loaded via symbol lookup.
     ArchiveMember* foreignST; ///< This holds the foreign symbol table.
@@ -0,0 +1,57 @@
+//===-- CompileTimeBudget.h - Per-function codegen time budget --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares CompileTimeBudget, which bounds the time spent generating
+// code for one function. The limit is set with -codegen-time-budget.
+//
+// Passes whose worst case is much slower than their typical case check the
+// budget at coarse steps and, once it is used up, switch to a cheaper strategy
+// for the rest of the function:
+//   - SelectionDAG isel skips alias-based chain combines and schedules in
+//     source order, like it does at -O0.
+//   - The machine scheduler leaves the remaining regions in their order.
+//   - The greedy register allocator spills instead of splitting live ranges.
+//
+// The generated code is still correct, but it depends on how fast the host
+// is, so leave the budget off when output must be reproducible.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_COMPILETIMEBUDGET_H
+#define LLVM_CODEGEN_COMPILETIMEBUDGET_H
+
+#include "llvm/Support/TimeValue.h"
+
+namespace llvm {
+
+class CompileTimeBudget {
+  sys::TimeValue Deadline;
+  bool Enabled;
+  bool Exceeded;
+
+  bool checkDeadline();
+
+public:
+  /// CompileTimeBudget - Start the budget set on the command line, counting
+  /// from now.
+  CompileTimeBudget();
+
+  /// isExceeded - Return true if the budget has been used up. Once this
+  /// returns true it keeps doing so. It reads the clock, so call it once per
+  /// block, region or live range rather than per instruction.
+  bool isExceeded() {
+    if (!Enabled)
+      return false;
+    return Exceeded || checkDeadline();
+  }
+};
+
+} // End llvm namespace
+
+#endif
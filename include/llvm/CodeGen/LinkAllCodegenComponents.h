@@ -34,6 +34,7 @@ namespace {
       (void) llvm::createFastRegisterAllocator();
       (void) llvm::createBasicRegisterAllocator();
       (void) llvm::createGreedyRegisterAllocator();
+      (void) llvm::createLinearScanRegisterAllocator(); // @LOCALMOD
 #if !defined(__native_client__)
       // Not needed by sandboxed translator.
       (void) llvm::createDefaultPBQPRegisterAllocator();
@@ -19,6 +19,7 @@
 #define LLVM_CODEGEN_MACHINEFUNCTION_H
 
 #include "llvm/ADT/ilist.h"
+#include "llvm/CodeGen/CompileTimeBudget.h" // @LOCALMOD
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/ArrayRecycler.h"
@@ -134,6 +135,12 @@ class MachineFunction {
   /// True if the function includes MS-style inline assembly.
   bool HasMSInlineAsm;
 
+  // @LOCALMOD-BEGIN
+  /// Budget - Time left for generating code for this function, counted from
+  /// the creation of the MachineFunction.
+  CompileTimeBudget Budget;
+  // @LOCALMOD-END
+
   MachineFunction(const MachineFunction &) LLVM_DELETED_FUNCTION;
   void operator=(const MachineFunction&) LLVM_DELETED_FUNCTION;
 public:
@@ -154,6 +161,13 @@ public:
   ///
   StringRef getName() const;
 
+  // @LOCALMOD-BEGIN
+  /// getCompileTimeBudget - Return the code generation time budget for this
+  /// function. Expensive passes use it to decide when to fall back to their
+  /// cheaper strategies.
+  CompileTimeBudget &getCompileTimeBudget() { return Budget; }
+  // @LOCALMOD-END
+
   /// getFunctionNumber - Return a unique ID for the current function.
   ///
   unsigned getFunctionNumber() const { return FunctionNumber; }
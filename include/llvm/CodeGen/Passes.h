@@ -390,6 +390,14 @@ namespace llvm {
   ///
   FunctionPass *createGreedyRegisterAllocator();
 
+  // @LOCALMOD-BEGIN
+  /// LinearScanRegisterAllocation Pass - This pass assigns live intervals in
+  /// order of their start without splitting them. It is meant for functions
+  /// too large for the greedy allocator.
+  ///
+  FunctionPass *createLinearScanRegisterAllocator();
+  // @LOCALMOD-END
+
   /// PBQPRegisterAllocation Pass - This pass implements the Partitioned Boolean
   /// Quadratic Prograaming (PBQP) based register allocator.
   ///
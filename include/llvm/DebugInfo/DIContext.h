@@ -15,6 +15,7 @@
 #ifndef LLVM_DEBUGINFO_DICONTEXT_H
 #define LLVM_DEBUGINFO_DICONTEXT_H
 
+#include "llvm/ADT/ArrayRef.h" // @LOCALMOD
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
@@ -134,6 +135,31 @@ public:
       uint64_t Size, DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DIInliningInfo getInliningInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
+
+  // @LOCALMOD-BEGIN
+  /// getLineInfoForAddresses - Append the line info for each of Addresses to
+  /// Result. Implementations may answer a batch of sorted addresses faster
+  /// than the same addresses one at a time.
+  virtual void getLineInfoForAddresses(ArrayRef<uint64_t> Addresses,
+      SmallVectorImpl<DILineInfo> &Result,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier());
+
+  /// useAddressIndex - Answer address queries from an address index cached
+  /// in the file CachePath, creating or replacing the file if it does not
+  /// describe this debug info. Returns false if no index could be built.
+  virtual bool useAddressIndex(StringRef CachePath) {
+    return false;
+  }
+
+  /// setNumThreads - Parse debug info on up to NumThreads threads. The
+  /// results do not depend on the number of threads.
+  virtual void setNumThreads(unsigned NumThreads) {}
+
+  /// parseAllDebugInfo - Parse all the debug info the queries use up front.
+  /// Returns true if queries no longer modify the context afterwards, so
+  /// that they may run concurrently without a lock.
+  virtual bool parseAllDebugInfo() { return false; }
+  // @LOCALMOD-END
 };
 
 }
@@ -301,6 +301,14 @@ public:
     setLinkage(ExternalLinkage);
   }
 
+  // @LOCALMOD-BEGIN
+  /// releaseBody - Like deleteBody, but also free the argument list and the
+  /// storage of the local symbol table, which deleteBody keeps. The arguments
+  /// are rebuilt lazily if a body is added again, so this is only valid when
+  /// nothing outside the body still refers to them.
+  void releaseBody();
+  // @LOCALMOD-END
+
   /// removeFromParent - This method unlinks 'this' from the containing module,
   /// but does not delete it.
   ///
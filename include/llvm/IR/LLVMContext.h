@@ -37,6 +37,18 @@ public:
   LLVMContextImpl *const pImpl;
   LLVMContext();
   ~LLVMContext();
+
+  // @LOCALMOD-BEGIN
+  /// resetModuleState - Prepare the context for an unrelated job once every
+  /// module in it has been deleted. This frees the constants and metadata
+  /// nodes the modules left behind and forgets the names of struct types,
+  /// so a new module starts from the same names as in a fresh context.
+  /// Types, attributes, metadata kinds and the storage of the uniquing
+  /// tables are kept, which makes this much cheaper than destroying and
+  /// recreating the context. Nothing may still reference a constant or
+  /// metadata node of this context.
+  void resetModuleState();
+  // @LOCALMOD-END
   
   // Pinned metadata names, which always have the same value.  This is a
   // compile-time performance optimization, not a correctness optimization.
@@ -14,6 +14,11 @@
 #ifndef LLVM_LINKER_H
 #define LLVM_LINKER_H
 
+// @LOCALMOD-BEGIN
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+// @LOCALMOD-END
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +29,41 @@ namespace llvm {
 class Module;
 class LLVMContext;
 class StringRef;
+// @LOCALMOD-BEGIN
+class StructType;
+class Type;
+
+/// IdentifiedStructTypeSet - The identified struct types used in a module.
+/// The ones with a body are also indexed by a hash of their element types.
+/// Element types are unique within an LLVMContext, so two structs with the
+/// same elements are isomorphic and the linker can find a destination type
+/// for a source struct without walking either type graph. The hash of a type
+/// is computed once, when it is added.
+class IdentifiedStructTypeSet {
+  /// Types - Every type in the set, and whether it is in NonOpaqueTypes.
+  DenseMap<StructType*, bool> Types;
+  /// NonOpaqueTypes - The types with a body, keyed by the hash of the body.
+  DenseMap<unsigned, SmallVector<StructType*, 1> > NonOpaqueTypes;
+
+  static unsigned getBodyHash(ArrayRef<Type*> ElementTypes, bool IsPacked);
+
+public:
+  /// addModule - Add the identified struct types used in M.
+  void addModule(Module &M);
+
+  /// addType - Add Ty, or add it to the index if it got a body since it was
+  /// added as an opaque type.
+  void addType(StructType *Ty);
+
+  /// findNonOpaque - Return the first struct type added with the given body,
+  /// or null if there is none.
+  StructType *findNonOpaque(ArrayRef<Type*> ElementTypes, bool IsPacked) const;
+
+  bool hasType(StructType *Ty) const { return Types.count(Ty); }
+
+  void clear() { Types.clear(); NonOpaqueTypes.clear(); }
+};
+// @LOCALMOD-END
 
 /// This class provides the core functionality of linking in LLVM. It retains a
 /// Module object which is the composite of the modules and libraries linked
@@ -87,9 +127,18 @@ class Linker {
     /// linked into it via the various LinkIn* methods. This method does not
     /// release the Module to the caller. The Linker retains ownership and will
     /// destruct the Module when the Linker is destructed.
+    // @LOCALMOD-BEGIN
+    /// The caller may change the types the module uses, so the Linker
+    /// collects them again on the next LinkInModule call.
+    // @LOCALMOD-END
     /// @see releaseModule
     /// @brief Get the linked/composite module.
-    Module* getModule() const { return Composite; }
+    // @LOCALMOD-BEGIN
+    Module* getModule() const {
+      CompositeStructTypesValid = false;
+      return Composite;
+    }
+    // @LOCALMOD-END
 
     /// This method releases the composite Module into which linking is being
     /// done. Ownership of the composite Module is transferred to the caller who
@@ -149,15 +198,17 @@ class Linker {
     /// by calling LinkModules.  All the other LinkIn* methods eventually
     /// result in calling this method to link a Module into the Linker's
     /// composite.
+    // @LOCALMOD-BEGIN
+    /// The struct types of the composite are collected once and kept up to
+    /// date as modules are linked in.
+    // @LOCALMOD-END
     /// @see LinkModules
     /// @returns True if an error occurs, false otherwise.
     /// @brief Link in a module.
     bool LinkInModule(
       Module* Src,              ///< Module linked into \p Dest
       std::string* ErrorMsg = 0 /// Error/diagnostic string
-    ) { 
-      return LinkModules(Composite, Src, Linker::DestroySource, ErrorMsg ); 
-    }
+    ); // @LOCALMOD
 
     /// This is the heart of the linker. This method will take unconditional
     /// control of the \p Src module and link it into the \p Dest module. The
@@ -190,6 +241,12 @@ class Linker {
     std::vector<sys::Path> LibPaths; ///< The library search paths
     unsigned Flags;    ///< Flags to control optional behavior.
     std::string Error; ///< Text of error that occurred.
+    // @LOCALMOD-BEGIN
+    /// The identified struct types used in Composite.
+    IdentifiedStructTypeSet CompositeStructTypes;
+    /// False when CompositeStructTypes has to be collected again.
+    mutable bool CompositeStructTypesValid;
+    // @LOCALMOD-END
     std::string ProgramName; ///< Name of the program being linked
   /// @}
 
@@ -17,8 +17,10 @@
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/MC/MCFixup.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/DataTypes.h"
+#include <string>
 #include <vector> // FIXME: Shouldn't be needed.
 
 namespace llvm {
@@ -125,6 +127,21 @@ public:
   void dump();
 };
 
+// @LOCALMOD-BEGIN
+/// Fragments are allocated from their MCAssembler's arena (see
+/// operator new(size_t, MCAssembler&)), so removing one from its section
+/// only runs the destructor; the memory is reclaimed when the assembler is
+/// reset or destroyed.
+template<> struct ilist_node_traits<MCFragment> {
+  static void deleteNode(MCFragment *F) { F->~MCFragment(); }
+
+  void addNodeToList(MCFragment *) {}
+  void removeNodeFromList(MCFragment *) {}
+  void transferNodesFromList(ilist_node_traits &, ilist_iterator<MCFragment>,
+                             ilist_iterator<MCFragment>) {}
+};
+// @LOCALMOD-END
+
 /// Interface implemented by fragments that contain encoded instructions and/or
 /// data.
 ///
@@ -797,6 +814,20 @@ struct DataRegionData {
   MCSymbol *End;
 };
 
+// @LOCALMOD-BEGIN
+/// Symbol data lives in the MCAssembler's arena too, see the MCFragment
+/// traits above.
+template<> struct ilist_node_traits<MCSymbolData> {
+  static void deleteNode(MCSymbolData *SD) { SD->~MCSymbolData(); }
+
+  void addNodeToList(MCSymbolData *) {}
+  void removeNodeFromList(MCSymbolData *) {}
+  void transferNodesFromList(ilist_node_traits &,
+                             ilist_iterator<MCSymbolData>,
+                             ilist_iterator<MCSymbolData>) {}
+};
+// @LOCALMOD-END
+
 class MCAssembler {
   friend class MCAsmLayout;
 
@@ -832,6 +863,12 @@ private:
 
   raw_ostream &OS;
 
+  // @LOCALMOD-BEGIN
+  /// Allocator for fragments and symbol data. It is declared before the
+  /// lists below so that it outlives the nodes they destroy.
+  BumpPtrAllocator Allocator;
+  // @LOCALMOD-END
+
   iplist<MCSectionData> Sections;
 
   iplist<MCSymbolData> Symbols;
@@ -877,6 +914,12 @@ private:
   // Access to the flags is necessary in cases where assembler directives affect
   // which flags to be set.
   unsigned ELFHeaderEFlags;
+
+  // @LOCALMOD-BEGIN
+  /// Section contents encoded ahead of WriteObject, indexed by section
+  /// ordinal. Empty unless parallel section encoding is enabled.
+  std::vector<std::string> EncodedSectionData;
+  // @LOCALMOD-END
 private:
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
@@ -926,6 +969,14 @@ private:
   uint64_t handleFixup(const MCAsmLayout &Layout,
                        MCFragment &F, const MCFixup &Fixup);
 
+  // @LOCALMOD-BEGIN
+  /// Encode the contents of every non-virtual section into
+  /// EncodedSectionData, using up to \p NumThreads threads. Must only be
+  /// called once the layout is final and all fixups have been applied.
+  void encodeSectionsInParallel(const MCAsmLayout &Layout,
+                                unsigned NumThreads);
+  // @LOCALMOD-END
+
 public:
   /// Compute the effective fragment size assuming it is laid out at the given
   /// \p SectionAddress and \p FragmentOffset.
@@ -984,6 +1035,14 @@ public:
 
   MCObjectWriter &getWriter() const { return Writer; }
 
+  // @LOCALMOD-BEGIN
+  /// Allocate memory that lives until the assembler is reset or destroyed.
+  /// Used for fragments and symbol data; see operator new below.
+  void *Allocate(size_t Size, size_t Align = 8) {
+    return Allocator.Allocate(Size, Align);
+  }
+  // @LOCALMOD-END
+
   /// Finish - Do final processing and write the object to the output stream.
   /// \p Writer is used for custom object writer (as the MCJIT does),
   /// if not specified it is automatically created from backend.
@@ -1141,7 +1200,9 @@ public:
 
     if (Created) *Created = !Entry;
     if (!Entry)
-      Entry = new MCSymbolData(Symbol, 0, 0, this);
+      Entry = new (Allocate(sizeof(MCSymbolData), // @LOCALMOD
+                            AlignOf<MCSymbolData>::Alignment))
+        MCSymbolData(Symbol, 0, 0, this);
 
     return *Entry;
   }
@@ -1153,4 +1214,22 @@ public:
 
 } // end namespace llvm
 
+// @LOCALMOD-BEGIN
+/// \brief Placement new for fragments, using the MCAssembler's allocator.
+///
+/// Every MCFragment must be created this way, e.g.
+/// \code
+/// new (Asm) MCDataFragment(SD);
+/// \endcode
+/// The memory is never freed individually: destroying a fragment only runs
+/// its destructor, and the whole arena is released by MCAssembler::reset()
+/// or when the assembler goes away.
+inline void *operator new(size_t Bytes, llvm::MCAssembler &Asm) {
+  return Asm.Allocate(Bytes);
+}
+/// \brief Placement delete companion to the above, only called if a
+/// constructor throws. The memory stays in the arena.
+inline void operator delete(void *, llvm::MCAssembler &) throw() {}
+// @LOCALMOD-END
+
 #endif
@@ -0,0 +1,66 @@
+//===-- StringTableBuilder.h - String table building utility ------*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_MC_STRINGTABLEBUILDER_H
+#define LLVM_MC_STRINGTABLEBUILDER_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include <cassert>
+#include <vector>
+
+namespace llvm {
+
+/// \brief Utility for building string tables with deduplicated suffixes.
+///
+/// Strings are uniqued through a hash table as they are added. finalize()
+/// then lays out the table, storing a string only once and pointing every
+/// string that is a suffix of another one into the tail of the longer one.
+/// Strings that are stored keep the order in which they were first added,
+/// and offset 0 always holds the empty string.
+class StringTableBuilder {
+  SmallString<256> StringTable;
+  StringMap<size_t> StringIndexMap;
+  std::vector<StringMapEntry<size_t> *> Strings;
+
+public:
+  /// \brief Add a string to the builder. Returns a StringRef to the internal
+  /// copy of s. Can only be used before the table is finalized.
+  StringRef add(StringRef s);
+
+  /// \brief Analyze the strings and build the final table. No more strings
+  /// can be added after this point.
+  void finalize();
+
+  /// \brief Retrieve the string table data. Can only be used after the table
+  /// is finalized.
+  StringRef data() const {
+    assert(isFinalized());
+    return StringTable;
+  }
+
+  /// \brief Get the offset of a string in the string table. Can only be used
+  /// after the table is finalized.
+  size_t getOffset(StringRef s) const {
+    assert(isFinalized());
+    if (s.empty())
+      return 0;
+    assert(StringIndexMap.count(s) && "String is not in table!");
+    return StringIndexMap.lookup(s);
+  }
+
+  void clear();
+
+private:
+  bool isFinalized() const { return !StringTable.empty(); }
+};
+
+} // end llvm namespace
+
+#endif
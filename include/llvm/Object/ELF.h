@@ -14,6 +14,7 @@
 #ifndef LLVM_OBJECT_ELF_H
 #define LLVM_OBJECT_ELF_H
 
+#include "llvm/ADT/ArrayRef.h" // @LOCALMOD
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
@@ -29,6 +30,7 @@
 #include <algorithm>
 #include <limits>
 #include <utility>
+#include <vector> // @LOCALMOD
 
 namespace llvm {
 namespace object {
@@ -570,6 +572,21 @@ private:
   // header, or NULL if there is no dynamic string table.
   Sections_t SymbolTableSections;
   IndexMap_t SymbolTableSectionsIndexMap;
+  // @LOCALMOD-BEGIN
+  /// SymbolTableView - The entries of a symbol table and the string table
+  /// holding their names, located once when the file is opened so that the
+  /// symbol accessors read them in place without section header lookups.
+  struct SymbolTableView {
+    const char *Entries;     // Null for a missing .dynsym.
+    uint64_t EntrySize;
+    uint64_t NumEntries;
+    const char *Strings;     // Null if there is no string table.
+    uint64_t StringsSize;
+  };
+  // SymbolTableViews[i] describes SymbolTableSections[i].
+  SmallVector<SymbolTableView, 2> SymbolTableViews;
+  void buildSymbolTableViews();
+  // @LOCALMOD-END
   DenseMap<const Elf_Sym*, ELF::Elf64_Word> ExtendedSymbolTable;
 
   const Elf_Shdr *dot_dynamic_sec;       // .dynamic
@@ -617,6 +634,31 @@ private:
     return getSection(Rel.w.b);
   }
 
+  // @LOCALMOD-BEGIN
+public:
+  /// SymbolAddress - A symbol of the static symbol table that is defined in
+  /// a section, with the address getSymbolAddress() reports for it.
+  struct SymbolAddress {
+    uint64_t Address;
+    uint32_t SymbolIndex;    // Index in its symbol table.
+    uint32_t SymbolTable;    // Index in SymbolTableSections.
+    uint32_t SectionIndex;   // Index of the section defining the symbol.
+
+    bool operator<(const SymbolAddress &RHS) const {
+      if (Address != RHS.Address)
+        return Address < RHS.Address;
+      if (SymbolTable != RHS.SymbolTable)
+        return SymbolTable < RHS.SymbolTable;
+      return SymbolIndex < RHS.SymbolIndex;
+    }
+  };
+
+private:
+  // Sorted by address. Built on first use, see getSymbolsByAddress().
+  mutable std::vector<SymbolAddress> SymbolsByAddress;
+  mutable bool SymbolsByAddressBuilt;
+  // @LOCALMOD-END
+
 public:
   bool            isRelocationHasAddend(DataRefImpl Rel) const;
   template<typename T>
@@ -795,6 +837,32 @@ public:
   const Elf_Sym *getElfSymbol(symbol_iterator &It) const;
   const Elf_Sym *getElfSymbol(uint32_t index) const;
 
+  // @LOCALMOD-BEGIN
+  /// getSymbolsByAddress - Return the function, object and untyped symbols
+  /// of the static symbol tables that are defined in a section, sorted by
+  /// address. The index is built on the first call and shared by all later
+  /// address lookups. That first call, whether through this method or
+  /// findSymbolByAddress(), is not thread-safe: make it before other threads
+  /// start using the object. Later calls may run concurrently.
+  ArrayRef<SymbolAddress> getSymbolsByAddress() const;
+
+  /// findSymbolByAddress - Set Res to the symbol of getSymbolsByAddress()
+  /// with the greatest address not above Address, or to end_symbols() if
+  /// there is none. Of several symbols at that address the first in the
+  /// symbol table is returned. Builds the index on the first call, see
+  /// getSymbolsByAddress().
+  error_code findSymbolByAddress(uint64_t Address, symbol_iterator &Res) const;
+
+  /// getSymbolRef - Return the symbol an entry of getSymbolsByAddress()
+  /// describes.
+  SymbolRef getSymbolRef(const SymbolAddress &Entry) const {
+    DataRefImpl Symb;
+    Symb.d.a = Entry.SymbolIndex;
+    Symb.d.b = Entry.SymbolTable;
+    return SymbolRef(Symb, this);
+  }
+  // @LOCALMOD-END
+
   // Methods for type inquiry through isa, cast, and dyn_cast
   bool isDyldType() const { return isDyldELFObject; }
   static inline bool classof(const Binary *v) {
@@ -908,11 +976,10 @@ template<class ELFT>
 error_code ELFObjectFile<ELFT>::getSymbolNext(DataRefImpl Symb,
                                               SymbolRef &Result) const {
   validateSymbol(Symb);
-  const Elf_Shdr *SymbolTableSection = SymbolTableSections[Symb.d.b];
 
   ++Symb.d.a;
   // Check to see if we are at the end of this symbol table.
-  if (Symb.d.a >= SymbolTableSection->getEntityCount()) {
+  if (Symb.d.a >= SymbolTableViews[Symb.d.b].NumEntries) { // @LOCALMOD
     // We are at the end. If there are other symbol tables, jump to them.
     // If the symbol table is .dynsym, we are iterating dynamic symbols,
     // and there is only one table of these.
@@ -936,7 +1003,16 @@ error_code ELFObjectFile<ELFT>::getSymbolName(DataRefImpl Symb,
                                               StringRef &Result) const {
   validateSymbol(Symb);
   const Elf_Sym *symb = getSymbol(Symb);
-  return getSymbolName(SymbolTableSections[Symb.d.b], symb, Result);
+  // @LOCALMOD-BEGIN
+  if (symb->st_name == 0)
+    return getSymbolName(SymbolTableSections[Symb.d.b], symb, Result);
+  const SymbolTableView &View = SymbolTableViews[Symb.d.b];
+  if (!View.Strings || symb->st_name >= View.StringsSize)
+    // FIXME: Proper error handling.
+    report_fatal_error("Symbol name offset outside of string table!");
+  Result = View.Strings + symb->st_name;
+  return object_error::success;
+  // @LOCALMOD-END
 }
 
 template<class ELFT>
@@ -2066,6 +2142,7 @@ ELFObjectFile<ELFT>::ELFObjectFile(MemoryBuffer *Object, error_code &ec)
   , dot_gnu_version_r_sec(0)
   , dot_gnu_version_d_sec(0)
   , dt_soname(0)
+  , SymbolsByAddressBuilt(false) // @LOCALMOD
  {
 
   const uint64_t FileSize = Data->getBufferSize();
@@ -2196,6 +2273,8 @@ ELFObjectFile<ELFT>::ELFObjectFile(MemoryBuffer *Object, error_code &ec)
     }
   }
 
+  buildSymbolTableViews(); // @LOCALMOD
+
   // Build symbol name side-mapping if there is one.
   if (SymbolTableSectionHeaderIndex) {
     const Elf_Word *ShndxTable = reinterpret_cast<const Elf_Word*>(base() +
@@ -2212,6 +2291,89 @@ ELFObjectFile<ELFT>::ELFObjectFile(MemoryBuffer *Object, error_code &ec)
   }
 }
 
+// @LOCALMOD-BEGIN
+template<class ELFT>
+void ELFObjectFile<ELFT>::buildSymbolTableViews() {
+  for (unsigned i = 0, e = SymbolTableSections.size(); i != e; ++i) {
+    const Elf_Shdr *Sec = SymbolTableSections[i];
+    SymbolTableView View = { 0, 0, 0, 0, 0 };
+    if (Sec) {
+      View.Entries = reinterpret_cast<const char *>(base() + Sec->sh_offset);
+      View.EntrySize = Sec->sh_entsize;
+      View.NumEntries = Sec->getEntityCount();
+    }
+    // Names of .dynsym symbols are in .dynstr, all others in .strtab.
+    if (const Elf_Shdr *StrTab = i == 0 ? dot_dynstr_sec : dot_strtab_sec) {
+      View.Strings = reinterpret_cast<const char *>(base() +
+                                                    StrTab->sh_offset);
+      View.StringsSize = StrTab->sh_size;
+    }
+    SymbolTableViews.push_back(View);
+  }
+}
+
+template<class ELFT>
+ArrayRef<typename ELFObjectFile<ELFT>::SymbolAddress>
+ELFObjectFile<ELFT>::getSymbolsByAddress() const {
+  if (SymbolsByAddressBuilt)
+    return SymbolsByAddress;
+
+  std::vector<SymbolAddress> Symbols;
+  bool IsRelocatable = Header->e_type != ELF::ET_EXEC &&
+                       Header->e_type != ELF::ET_DYN;
+  for (unsigned t = 1, te = SymbolTableViews.size(); t < te; ++t) {
+    const SymbolTableView &View = SymbolTableViews[t];
+    // The 0th symbol in ELF is fake.
+    for (uint64_t i = 1; i < View.NumEntries; ++i) {
+      const Elf_Sym *symb =
+        reinterpret_cast<const Elf_Sym *>(View.Entries + i * View.EntrySize);
+      unsigned char Type = symb->getType();
+      if (Type != ELF::STT_FUNC && Type != ELF::STT_OBJECT &&
+          Type != ELF::STT_NOTYPE)
+        continue;
+      ELF::Elf64_Word SectionIndex = getSymbolTableIndex(symb);
+      if (SectionIndex == ELF::SHN_UNDEF ||
+          (SectionIndex >= ELF::SHN_LORESERVE &&
+           symb->st_shndx != ELF::SHN_XINDEX))
+        continue;
+      SymbolAddress Entry;
+      Entry.Address = symb->st_value;
+      if (IsRelocatable)
+        Entry.Address += getSection(SectionIndex)->sh_addr;
+      Entry.SymbolIndex = i;
+      Entry.SymbolTable = t;
+      Entry.SectionIndex = SectionIndex;
+      Symbols.push_back(Entry);
+    }
+  }
+  std::sort(Symbols.begin(), Symbols.end());
+  // Mark the index built only once it is complete.
+  SymbolsByAddress.swap(Symbols);
+  SymbolsByAddressBuilt = true;
+  return SymbolsByAddress;
+}
+
+template<class ELFT>
+error_code
+ELFObjectFile<ELFT>::findSymbolByAddress(uint64_t Address,
+                                         symbol_iterator &Res) const {
+  ArrayRef<SymbolAddress> Symbols = getSymbolsByAddress();
+  SymbolAddress Key = { Address, ~0U, ~0U, 0 };
+  const SymbolAddress *I =
+    std::upper_bound(Symbols.begin(), Symbols.end(), Key);
+  if (I == Symbols.begin()) {
+    Res = end_symbols();
+    return object_error::success;
+  }
+  --I;
+  // Step back to the first symbol at the address.
+  while (I != Symbols.begin() && I[-1].Address == I->Address)
+    --I;
+  Res = symbol_iterator(getSymbolRef(*I));
+  return object_error::success;
+}
+// @LOCALMOD-END
+
 // Get the symbol table index in the symtab section given a symbol
 template<class ELFT>
 uint64_t ELFObjectFile<ELFT>::getSymbolIndex(const Elf_Sym *Sym) const {
@@ -2508,7 +2670,11 @@ ELFObjectFile<ELFT>::getEntry(const Elf_Shdr * Section, uint32_t Entry) const {
 template<class ELFT>
 const typename ELFObjectFile<ELFT>::Elf_Sym *
 ELFObjectFile<ELFT>::getSymbol(DataRefImpl Symb) const {
-  return getEntry<Elf_Sym>(SymbolTableSections[Symb.d.b], Symb.d.a);
+  // @LOCALMOD-BEGIN
+  const SymbolTableView &View = SymbolTableViews[Symb.d.b];
+  return reinterpret_cast<const Elf_Sym *>(View.Entries +
+                                           Symb.d.a * View.EntrySize);
+  // @LOCALMOD-END
 }
 
 template<class ELFT>
@@ -465,6 +465,35 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+// @LOCALMOD-BEGIN
+/// PassProfileRegion - While in scope, accumulate one run of a pass into the
+/// -pass-profile-json report: wall, user and system time, malloc usage and
+/// peak RSS deltas, and the IR instruction count before and after the run.
+/// Runs on a Function are also aggregated per function. This does nothing
+/// unless the report was requested.
+class PassProfileRegion {
+  Pass *P;             // Null when profiling is disabled.
+  Module *M;
+  Function *F;
+  BasicBlock *BB;
+  unsigned InstsBefore;
+  size_t MallocBefore;
+  size_t PeakRSSBefore;
+  double WallBefore, UserBefore, SystemBefore;
+
+  void start();
+  unsigned countInstructions() const;
+
+  PassProfileRegion(const PassProfileRegion &) LLVM_DELETED_FUNCTION;
+  void operator=(const PassProfileRegion &) LLVM_DELETED_FUNCTION;
+public:
+  PassProfileRegion(Pass *P, Module &M);
+  PassProfileRegion(Pass *P, Function &F);
+  PassProfileRegion(Pass *P, BasicBlock &BB);
+  ~PassProfileRegion();
+};
+// @LOCALMOD-END
+
 }
 
 #endif
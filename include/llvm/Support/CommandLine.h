@@ -50,6 +50,16 @@ void ParseCommandLineOptions(int argc, const char * const *argv,
 void ParseEnvironmentOptions(const char *progName, const char *envvar,
                              const char *Overview = 0);
 
+// @LOCALMOD-BEGIN
+//===----------------------------------------------------------------------===//
+// ResetAllOptionOccurrences - Forget how often each option has been seen, so
+// ParseCommandLineOptions can be called again on another command line. Option
+// values are kept and act as defaults for the new command line; list options
+// keep their values and the new ones are appended.
+//
+void ResetAllOptionOccurrences();
+// @LOCALMOD-END
+
 ///===---------------------------------------------------------------------===//
 /// SetVersionPrinter - Override the default (LLVM specific) version printer
 ///                     used to print out the version when --version is given
@@ -145,6 +155,7 @@ enum MiscFlags {               // Miscellaneous flags to adjust argument
 class alias;
 class Option {
   friend class alias;
+  friend void ResetAllOptionOccurrences(); // @LOCALMOD
 
   // handleOccurrences - Overriden by subclasses to handle the value passed into
   // an argument.  Should return true if there was an error processing the
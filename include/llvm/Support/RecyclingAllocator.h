@@ -52,6 +52,19 @@ public:
   void Deallocate(SubClass* E) { return Base.Deallocate(Allocator, E); }
 
   void PrintStats() { Base.PrintStats(); }
+
+  // @LOCALMOD-BEGIN
+  /// Reset - Forget every object, live or recycled, and reset the wrapped
+  /// allocator so that its memory is reused for new objects. Objects are not
+  /// destroyed; this is only valid when none of them is used any more.
+  void Reset() {
+    Base.clear(Allocator);
+    Allocator.Reset();
+  }
+
+  /// getTotalMemory - Return the memory held by the wrapped allocator.
+  size_t getTotalMemory() const { return Allocator.getTotalMemory(); }
+  // @LOCALMOD-END
 };
 
 }
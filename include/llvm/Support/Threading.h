@@ -54,6 +54,21 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  // @LOCALMOD-BEGIN
+  /// llvm_execute_on_threads - Call \p UserFn once for each of the \p NumItems
+  /// entries of \p UserData, spreading the calls over up to \p NumThreads
+  /// threads, and wait for all of them to complete.
+  ///
+  /// Items are handed out to the threads in index order as they become idle,
+  /// so callers that need deterministic output should write each item's
+  /// result into its own slot and combine them afterwards. Without thread
+  /// support, or when \p NumThreads is at most one, the items are processed
+  /// on the calling thread in order. Otherwise LLVM is switched to
+  /// multithreaded mode first if it is not already in it.
+  void llvm_execute_on_threads(void (*UserFn)(void*), void *const *UserData,
+                               unsigned NumItems, unsigned NumThreads);
+  // @LOCALMOD-END
 }
 
 #endif
@@ -224,6 +224,7 @@ bool LPPassManager::runOnFunction(Function &F) {
       {
         PassManagerPrettyStackEntry X(P, *CurrentLoop->getHeader());
         TimeRegion PassTimer(getPassTimer(P));
+        PassProfileRegion PassProfile(P, F); // @LOCALMOD
 
         Changed |= P->runOnLoop(CurrentLoop, *this);
       }
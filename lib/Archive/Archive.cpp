@@ -145,7 +145,9 @@ bool ArchiveMember::replaceWith(const sys::Path& newFile, std::string* ErrMsg) {
 // initializes and maps the file into memory, if requested.
 Archive::Archive(const sys::Path& filename, LLVMContext& C)
   : archPath(filename), members(), mapfile(0), base(0), symTab(), strtab(),
-    symTabSize(0), firstFileOffset(0), modules(), foreignST(0), Context(C) {
+    symTabSize(0),
+    symTabData(0), symIdx(0), symIdxSize(0), // @LOCALMOD
+    firstFileOffset(0), modules(), foreignST(0), Context(C) {
 }
 
 bool
@@ -162,6 +164,17 @@ Archive::mapToMemory(std::string* ErrMsg) {
 }
 
 void Archive::cleanUpMemory() {
+  // @LOCALMOD-BEGIN
+  // Delete any Modules and ArchiveMember's we've allocated as a result of
+  // symbol table searches. Modules scanned for their symbols read the mapped
+  // file in place, so they go first.
+  for (ModuleMap::iterator I=modules.begin(), E=modules.end(); I != E; ++I ) {
+    delete I->second.first;
+    delete I->second.second;
+  }
+  modules.clear();
+  // @LOCALMOD-END
+
   // Shutdown the file mapping
   delete mapfile;
   mapfile = 0;
@@ -170,6 +183,11 @@ void Archive::cleanUpMemory() {
   // Forget the entire symbol table
   symTab.clear();
   symTabSize = 0;
+  // @LOCALMOD-BEGIN
+  symTabData = 0;
+  symIdx = 0;
+  symIdxSize = 0;
+  // @LOCALMOD-END
 
   firstFileOffset = 0;
 
@@ -178,13 +196,6 @@ void Archive::cleanUpMemory() {
     delete foreignST;
     foreignST = 0;
   }
-
-  // Delete any Modules and ArchiveMember's we've allocated as a result of
-  // symbol table searches.
-  for (ModuleMap::iterator I=modules.begin(), E=modules.end(); I != E; ++I ) {
-    delete I->second.first;
-    delete I->second.second;
-  }
 }
 
 // Archive destructor - just clean up memory
@@ -201,9 +212,11 @@ static void getSymbols(Module*M, std::vector<std::string>& symbols) {
       if (!GI->getName().empty())
         symbols.push_back(GI->getName());
 
-  // Loop over functions
+  // Loop over functions. The module is read lazily, so a function whose body
+  // has not been read yet is a definition too.
   for (Module::iterator FI = M->begin(), FE = M->end(); FI != FE; ++FI)
-    if (!FI->isDeclaration() && !FI->hasLocalLinkage())
+    if ((!FI->isDeclaration() || FI->isMaterializable()) && // @LOCALMOD
+        !FI->hasLocalLinkage())
       if (!FI->getName().empty())
         symbols.push_back(FI->getName());
 
@@ -227,9 +240,13 @@ bool llvm::GetBitcodeSymbols(const sys::Path& fName,
     return true;
   }
 
-  Module *M = ParseBitcodeFile(Buffer.get(), Context, ErrMsg);
+  // @LOCALMOD-BEGIN
+  // Only the module-level records are needed; function bodies stay unread.
+  Module *M = getLazyBitcodeModule(Buffer.get(), Context, ErrMsg);
   if (!M)
     return true;
+  Buffer.take();
+  // @LOCALMOD-END
 
   // Get the symbols
   getSymbols(M, symbols);
@@ -245,13 +262,18 @@ llvm::GetBitcodeSymbols(const char *BufPtr, unsigned Length,
                         LLVMContext& Context,
                         std::vector<std::string>& symbols,
                         std::string* ErrMsg) {
-  // Get the module.
+  // @LOCALMOD-BEGIN
+  // Get the module, reading only its module-level records. The function
+  // bodies are neither parsed nor copied; the module reads BufPtr in place,
+  // so it must not outlive the buffer.
   OwningPtr<MemoryBuffer> Buffer(
-    MemoryBuffer::getMemBufferCopy(StringRef(BufPtr, Length),ModuleID.c_str()));
+    MemoryBuffer::getMemBuffer(StringRef(BufPtr, Length), ModuleID, false));
 
-  Module *M = ParseBitcodeFile(Buffer.get(), Context, ErrMsg);
+  Module *M = getLazyBitcodeModule(Buffer.get(), Context, ErrMsg);
   if (!M)
     return 0;
+  Buffer.take();
+  // @LOCALMOD-END
 
   // Get the symbols
   getSymbols(M, symbols);
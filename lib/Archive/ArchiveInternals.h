@@ -23,6 +23,7 @@
 #define ARFILE_MAGIC_LEN (sizeof(ARFILE_MAGIC)-1)  ///< length of magic string
 #define ARFILE_SVR4_SYMTAB_NAME "/               " ///< SVR4 symtab entry name
 #define ARFILE_LLVM_SYMTAB_NAME "#_LLVM_SYM_TAB_#" ///< LLVM symtab entry name
+#define ARFILE_LLVM_SYMIDX_NAME "#_LLVM_SYM_IDX_#" ///< LLVM symidx name @LOCALMOD
 #define ARFILE_BSD4_SYMTAB_NAME "__.SYMDEF SORTED" ///< BSD4 symtab entry name
 #define ARFILE_STRTAB_NAME      "//              " ///< Name of string table
 #define ARFILE_PAD "\n"                            ///< inter-file align padding
@@ -70,6 +71,31 @@ namespace llvm {
     }
   };
   
+  // @LOCALMOD-BEGIN
+  /// The LLVM symbol index member follows the LLVM symbol table and maps the
+  /// same symbols to the same offsets, but can be searched in place. Member
+  /// offsets are counted from the start of the index, so readers that do not
+  /// know it take it for the first member and still find the others. All
+  /// fields are little-endian 32-bit integers:
+  ///
+  ///   NumBuckets                        (a power of two)
+  ///   SymTabSize                        (size of the symbol table's data)
+  ///   NumBuckets x { Hash, NameOffset, NameLength, FileOffset }
+  ///   the symbol names, not terminated
+  ///
+  /// Hash is HashString of the name and the bucket is found by linear probing
+  /// from Hash & (NumBuckets - 1). NameOffset is relative to the first name.
+  /// A bucket with NameLength 0 is empty. At most half of the buckets are used.
+  /// An index whose SymTabSize does not match the symbol table before it is
+  /// stale and is ignored.
+  namespace ArchiveSymbolIndex {
+    enum {
+      HeaderSize = 8,
+      BucketSize = 16
+    };
+  }
+  // @LOCALMOD-END
+
   // Get just the externally visible defined symbols from the bitcode
   bool GetBitcodeSymbols(const sys::Path& fName,
                           LLVMContext& Context,
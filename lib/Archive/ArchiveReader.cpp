@@ -67,6 +67,82 @@ Archive::parseSymbolTable(const void* data, unsigned size, std::string* error) {
   return true;
 }
 
+// @LOCALMOD-BEGIN
+/// Read a little-endian 32-bit integer from the symbol index.
+static inline unsigned readLE32(const char *At) {
+  const unsigned char *P = (const unsigned char *)At;
+  return P[0] | (P[1] << 8) | (P[2] << 16) | ((unsigned)P[3] << 24);
+}
+
+// Check the header of the hashed symbol index and remember where it is. The
+// buckets are searched in place and checked as they are probed. An index
+// built for a different symbol table was copied as a plain member by a tool
+// that does not know about it; it is ignored and the symbol table is used.
+bool
+Archive::setSymbolIndex(const char* data, unsigned size, unsigned tableSize,
+                        std::string* error) {
+  using namespace ArchiveSymbolIndex;
+  unsigned NumBuckets = size < HeaderSize ? 0 : readLE32(data);
+  if (NumBuckets == 0 || (NumBuckets & (NumBuckets - 1)) != 0 ||
+      NumBuckets > (size - HeaderSize) / BucketSize) {
+    if (error)
+      *error = "Malformed symbol index";
+    return false;
+  }
+  if (readLE32(data + 4) != tableSize)
+    return true;
+  symIdx = data;
+  symIdxSize = size;
+  return true;
+}
+
+// Find the offset of the member that defines Name, probing the symbol index
+// if there is one instead of the symbol table.
+bool Archive::lookupSymbol(StringRef Name, unsigned& Offset) const {
+  if (!symIdx) {
+    SymTabType::const_iterator SI = symTab.find(Name.str());
+    if (SI == symTab.end())
+      return false;
+    Offset = SI->second;
+    return true;
+  }
+
+  using namespace ArchiveSymbolIndex;
+  unsigned NumBuckets = readLE32(symIdx);
+  const char* Buckets = symIdx + HeaderSize;
+  const char* Names = Buckets + NumBuckets * BucketSize;
+  unsigned NamesSize = symIdx + symIdxSize - Names;
+  unsigned Hash = HashString(Name);
+  unsigned Mask = NumBuckets - 1;
+  for (unsigned i = 0, B = Hash & Mask; i != NumBuckets; ++i, B = (B+1) & Mask) {
+    const char* Bucket = Buckets + B * BucketSize;
+    unsigned Length = readLE32(Bucket + 8);
+    if (Length == 0)
+      return false;
+    if (readLE32(Bucket) != Hash || Length != Name.size())
+      continue;
+    unsigned NameOffset = readLE32(Bucket + 4);
+    if (NameOffset > NamesSize || Length > NamesSize - NameOffset)
+      return false;
+    if (memcmp(Names + NameOffset, Name.data(), Length) != 0)
+      continue;
+    Offset = readLE32(Bucket + 12);
+    return true;
+  }
+  return false;
+}
+
+// Return the symbol table, parsing it first if only the symbol index was read
+// when the archive was opened.
+const Archive::SymTabType& Archive::getSymbolTable() {
+  if (symTabData) {
+    parseSymbolTable(symTabData, symTabSize, 0);
+    symTabData = 0;
+  }
+  return symTab;
+}
+// @LOCALMOD-END
+
 // This member parses an ArchiveMemberHeader that is presumed to be pointed to
 // by At. The At pointer is updated to the byte just after the header, which
 // can be variable in size.
@@ -128,6 +204,12 @@ Archive::parseMemberHeader(const char*& At, const char* End, std::string* error)
             *error = "invalid long filename";
           return 0;
         }
+      // @LOCALMOD-BEGIN
+      } else if (Hdr->name[1] == '_' &&
+                 (0 == memcmp(Hdr->name, ARFILE_LLVM_SYMIDX_NAME, 16))) {
+        pathname.assign(ARFILE_LLVM_SYMIDX_NAME);
+        flags |= ArchiveMember::LLVMSymbolIndexFlag;
+      // @LOCALMOD-END
       } else if (Hdr->name[1] == '_' &&
                  (0 == memcmp(Hdr->name, ARFILE_LLVM_SYMTAB_NAME, 16))) {
         // The member is using a long file name (>15 chars) format.
@@ -253,6 +335,10 @@ Archive::loadArchive(std::string* error) {
   // Set up parsing
   members.clear();
   symTab.clear();
+  // @LOCALMOD-BEGIN
+  symTabData = 0;
+  symIdx = 0;
+  // @LOCALMOD-END
   const char *At = base;
   const char *End = mapfile->getBufferEnd();
 
@@ -263,6 +349,7 @@ Archive::loadArchive(std::string* error) {
 
   bool seenSymbolTable = false;
   bool foundFirstFile = false;
+  unsigned tableSize = 0; // @LOCALMOD
   while (At < End) {
     // parse the member header
     const char* Save = At;
@@ -293,6 +380,21 @@ Archive::loadArchive(std::string* error) {
       if ((intptr_t(At) & 1) == 1)
         At++;
       delete mbr;
+    // @LOCALMOD-BEGIN
+    } else if (mbr->isLLVMSymbolIndex() && seenSymbolTable &&
+               !foundFirstFile) {
+      // The symbol index duplicates the symbol table, which has been parsed
+      // already. It counts as the first file: member offsets are recorded
+      // from its start, so that readers that do not know it find the members.
+      if (!setSymbolIndex(mbr->getData(), mbr->getSize(), tableSize, error))
+        return false;
+      firstFileOffset = Save - base;
+      foundFirstFile = true;
+      At += mbr->getSize();
+      if ((intptr_t(At) & 1) == 1)
+        At++;
+      delete mbr;
+    // @LOCALMOD-END
     } else if (mbr->isLLVMSymbolTable()) {
       // This is the LLVM symbol table for the archive. If we've seen it
       // already, its an error. Otherwise, parse the symbol table and move on.
@@ -304,6 +406,7 @@ Archive::loadArchive(std::string* error) {
       if (!parseSymbolTable(mbr->getData(), mbr->getSize(), error))
         return false;
       seenSymbolTable = true;
+      tableSize = mbr->getSize(); // @LOCALMOD
       At += mbr->getSize();
       if ((intptr_t(At) & 1) == 1)
         At++;
@@ -367,6 +470,10 @@ Archive::loadSymbolTable(std::string* ErrorMsg) {
   // Set up parsing
   members.clear();
   symTab.clear();
+  // @LOCALMOD-BEGIN
+  symTabData = 0;
+  symIdx = 0;
+  // @LOCALMOD-END
   const char *At = base;
   const char *End = mapfile->getBufferEnd();
 
@@ -416,10 +523,10 @@ Archive::loadSymbolTable(std::string* ErrorMsg) {
 
   // See if its the symbol table
   if (mbr->isLLVMSymbolTable()) {
-    if (!parseSymbolTable(mbr->getData(), mbr->getSize(), ErrorMsg)) {
-      delete mbr;
-      return false;
-    }
+    // @LOCALMOD-BEGIN
+    const char* tableData = mbr->getData();
+    unsigned tableSize = mbr->getSize();
+    // @LOCALMOD-END
 
     At += mbr->getSize();
     if ((intptr_t(At) & 1) == 1)
@@ -427,6 +534,29 @@ Archive::loadSymbolTable(std::string* ErrorMsg) {
     delete mbr;
     // Can't be any more symtab headers so just advance
     FirstFile = At;
+
+    // @LOCALMOD-BEGIN
+    // The hashed symbol index comes right after the symbol table and counts
+    // as the first file, so FirstFile stays at its header. Lookups probe it
+    // in place, so the symbol table is only parsed if it is asked for.
+    if (At < End) {
+      const char* Next = At;
+      mbr = parseMemberHeader(Next, End, ErrorMsg);
+      if (!mbr)
+        return false;
+      bool Valid = !mbr->isLLVMSymbolIndex() ||
+        setSymbolIndex(mbr->getData(), mbr->getSize(), tableSize, ErrorMsg);
+      delete mbr;
+      if (!Valid)
+        return false;
+    }
+    if (symIdx) {
+      symTabData = tableData;
+      symTabSize = tableSize;
+    } else if (!parseSymbolTable(tableData, tableSize, ErrorMsg)) {
+      return false;
+    }
+    // @LOCALMOD-END
   } else {
     // There's no symbol table in the file. We have to rebuild it from scratch
     // because the intent of this method is to get the symbol table loaded so
@@ -456,9 +586,11 @@ Archive* Archive::OpenAndLoadSymbols(const sys::Path& File,
 Module*
 Archive::findModuleDefiningSymbol(const std::string& symbol, 
                                   std::string* ErrMsg) {
-  SymTabType::iterator SI = symTab.find(symbol);
-  if (SI == symTab.end())
+  // @LOCALMOD-BEGIN
+  unsigned symOffset;
+  if (!lookupSymbol(symbol, symOffset))
     return 0;
+  // @LOCALMOD-END
 
   // The symbol table was previously constructed assuming that the members were
   // written without the symbol table header. Because VBR encoding is used, the
@@ -467,7 +599,7 @@ Archive::findModuleDefiningSymbol(const std::string& symbol,
   // We now have to account for this by adjusting the offset by the size of the
   // symbol table and its header.
   unsigned fileOffset =
-    SI->second +                // offset in symbol-table-less file
+    symOffset +                 // offset in symbol-table-less file // @LOCALMOD
     firstFileOffset;            // add offset to first "real" file in archive
 
   // See if the module is already loaded
@@ -510,7 +642,7 @@ Archive::findModulesDefiningSymbols(std::set<std::string>& symbols,
     return false;
   }
 
-  if (symTab.empty()) {
+  if (symTab.empty() && !symIdx) { // @LOCALMOD
     // We don't have a symbol table, so we must build it now but lets also
     // make sure that we populate the modules table as we do this to ensure
     // that we don't load them twice when findModuleDefiningSymbol is called
@@ -594,13 +726,13 @@ Archive::findModulesDefiningSymbols(std::set<std::string>& symbols,
 bool Archive::isBitcodeArchive() {
   // Make sure the symTab has been loaded. In most cases this should have been
   // done when the archive was constructed, but still,  this is just in case.
-  if (symTab.empty())
+  if (symTab.empty() && !symIdx) // @LOCALMOD
     if (!loadSymbolTable(0))
       return false;
 
   // Now that we know it's been loaded, return true
   // if it has a size
-  if (symTab.size()) return true;
+  if (symTab.size() || symIdx) return true; // @LOCALMOD
 
   // We still can't be sure it isn't a bitcode archive
   if (!loadArchive(0))
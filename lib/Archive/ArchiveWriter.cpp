@@ -14,33 +14,39 @@
 #include "llvm/Bitcode/Archive.h"
 #include "ArchiveInternals.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h" // @LOCALMOD
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h" // @LOCALMOD
 #include "llvm/IR/Module.h"
+#include "llvm/Support/FileOutputBuffer.h" // @LOCALMOD
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/system_error.h"
 #include <fstream>
 #include <iomanip>
 #include <ostream>
 using namespace llvm;
 
+// @LOCALMOD-BEGIN
 // Write an integer using variable bit rate encoding. This saves a few bytes
 // per entry in the symbol table.
-static inline void writeInteger(unsigned num, std::ofstream& ARFile) {
+static inline void writeInteger(unsigned num, char*& Out) {
   while (1) {
     if (num < 0x80) { // done?
-      ARFile << (unsigned char)num;
+      *Out++ = (unsigned char)num;
       return;
     }
 
     // Nope, we are bigger than a character, output the next 7 bits and set the
     // high bit to say that there is more coming...
-    ARFile << (unsigned char)(0x80 | ((unsigned char)num & 0x7F));
+    *Out++ = (unsigned char)(0x80 | ((unsigned char)num & 0x7F));
     num >>= 7;  // Shift out 7 bits now...
   }
 }
+// @LOCALMOD-END
 
 // Compute how many bytes are taken by a given VBR encoded value. This is needed
 // to pre-compute the size of the symbol table.
@@ -198,105 +204,90 @@ Archive::addFileBefore(const sys::Path& filePath, iterator where,
   return false;
 }
 
-// Write one member out to the file.
-bool
-Archive::writeMember(
-  const ArchiveMember& member,
-  std::ofstream& ARFile,
-  bool CreateSymbolTable,
-  bool TruncateNames,
-  std::string* ErrMsg
-) {
-
-  unsigned filepos = ARFile.tellp();
-  filepos -= 8;
-
-  // Get the data and its size either from the
-  // member's in-memory data or directly from the file.
-  size_t fSize = member.getSize();
-  const char *data = (const char*)member.getData();
-  MemoryBuffer *mFile = 0;
-  if (!data) {
-    OwningPtr<MemoryBuffer> File;
-    if (error_code ec = MemoryBuffer::getFile(member.getPath().c_str(), File)) {
-      if (ErrMsg)
-        *ErrMsg = ec.message();
-      return true;
-    }
-    mFile = File.take();
-    data = mFile->getBufferStart();
-    fSize = mFile->getBufferSize();
-  }
 
-  // Now that we have the data in memory, update the
-  // symbol table if it's a bitcode file.
-  if (CreateSymbolTable && member.isBitcode()) {
-    std::vector<std::string> symbols;
-    std::string FullMemberName = archPath.str() + "(" + member.getPath().str()
-      + ")";
-    Module* M =
-      GetBitcodeSymbols(data, fSize, FullMemberName, Context, symbols, ErrMsg);
-
-    // If the bitcode parsed successfully
-    if ( M ) {
-      for (std::vector<std::string>::iterator SI = symbols.begin(),
-           SE = symbols.end(); SI != SE; ++SI) {
-
-        std::pair<SymTabType::iterator,bool> Res =
-          symTab.insert(std::make_pair(*SI,filepos));
-
-        if (Res.second) {
-          symTabSize += SI->length() +
-                        numVbrBytes(SI->length()) +
-                        numVbrBytes(filepos);
-        }
-      }
-      // We don't need this module any more.
-      delete M;
-    } else {
-      delete mFile;
-      if (ErrMsg)
-        *ErrMsg = "Can't parse bitcode member: " + member.getPath().str()
-          + ": " + *ErrMsg;
-      return true;
-    }
-  }
-
-  int hdrSize = fSize;
-
-  // Compute the fields of the header
-  ArchiveMemberHeader Hdr;
-  bool writeLongName = fillHeader(member,Hdr,hdrSize,TruncateNames);
-
-  // Write header to archive file
-  ARFile.write((char*)&Hdr, sizeof(Hdr));
+// @LOCALMOD-BEGIN
+namespace {
+// A member about to be written, with its data and the symbols it defines.
+struct MemberInfo {
+  const ArchiveMember *Member;
+  const char *Data;
+  unsigned Size;
+  unsigned Offset;   // Offset from the first member after the symbol tables.
+  bool Failed;       // The member is bitcode that could not be parsed.
+  std::string Error;
+  std::vector<std::string> Symbols;
+
+  MemberInfo() : Member(0), Data(0), Size(0), Offset(0), Failed(false) {}
+};
+
+// Owns the buffers of the members that are read from their files.
+struct MemberFiles {
+  std::vector<MemoryBuffer*> Buffers;
+  ~MemberFiles() { DeleteContainerPointers(Buffers); }
+};
+
+// The members whose symbols one worker reads: First, First + Stride, ...
+struct SymbolScanJob {
+  std::vector<MemberInfo> *Members;
+  const std::string *ArchiveName;
+  LLVMContext *Context;  // Null if the worker needs a context of its own.
+  unsigned First;
+  unsigned Stride;
+};
+}
 
-  // Write the long filename if its long
-  if (writeLongName) {
-    ARFile.write(member.getPath().str().data(),
-                 member.getPath().str().length());
+// Get the data and its size either from the member's in-memory data or
+// directly from the file.
+static bool getMemberData(const ArchiveMember &Member, MemberInfo &MI,
+                          MemberFiles &Files, std::string *ErrMsg) {
+  MI.Member = &Member;
+  MI.Size = Member.getSize();
+  MI.Data = (const char*)Member.getData();
+  if (MI.Data)
+    return false;
+  OwningPtr<MemoryBuffer> File;
+  if (error_code ec = MemoryBuffer::getFile(Member.getPath().c_str(), File)) {
+    if (ErrMsg)
+      *ErrMsg = ec.message();
+    return true;
   }
-
-  // Write the (possibly compressed) member's content to the file.
-  ARFile.write(data,fSize);
-
-  // Make sure the member is an even length
-  if ((ARFile.tellp() & 1) == 1)
-    ARFile << ARFILE_PAD;
-
-  // Close the mapped file if it was opened
-  delete mFile;
+  MI.Data = File->getBufferStart();
+  MI.Size = File->getBufferSize();
+  Files.Buffers.push_back(File.take());
   return false;
 }
 
-// Write out the LLVM symbol table as an archive member to the file.
-void
-Archive::writeSymbolTable(std::ofstream& ARFile) {
+// Read the symbols of the bitcode members of one job. Modules are only
+// materialized lazily, and every worker but the calling thread's parses into
+// its own LLVMContext, so the jobs share no IR state.
+static void scanMemberSymbols(void *Arg) {
+  SymbolScanJob &Job = *static_cast<SymbolScanJob*>(Arg);
+  OwningPtr<LLVMContext> OwnContext;
+  LLVMContext *Context = Job.Context;
+  if (!Context) {
+    OwnContext.reset(new LLVMContext());
+    Context = OwnContext.get();
+  }
+  for (unsigned i = Job.First, e = Job.Members->size(); i < e;
+       i += Job.Stride) {
+    MemberInfo &MI = (*Job.Members)[i];
+    if (!MI.Member->isBitcode())
+      continue;
+    std::string FullMemberName = *Job.ArchiveName + "(" +
+      MI.Member->getPath().str() + ")";
+    Module *M = GetBitcodeSymbols(MI.Data, MI.Size, FullMemberName, *Context,
+                                  MI.Symbols, &MI.Error);
+    MI.Failed = !M;
+    // We don't need this module any more.
+    delete M;
+  }
+}
 
-  // Construct the symbol table's header
-  ArchiveMemberHeader Hdr;
+// Fill in the header of a symbol table or index member of the given size.
+static void fillSymbolTableHeader(ArchiveMemberHeader &Hdr, const char *Name,
+                                  unsigned Size) {
   Hdr.init();
-  memcpy(Hdr.name,ARFILE_LLVM_SYMTAB_NAME,16);
+  memcpy(Hdr.name,Name,16);
   uint64_t secondsSinceEpoch = sys::TimeValue::now().toEpochTime();
   char buffer[32];
   sprintf(buffer, "%-8o", 0644);
@@ -307,50 +298,167 @@ Archive::writeSymbolTable(std::ofstream& ARFile) {
   memcpy(Hdr.gid,buffer,6);
   sprintf(buffer,"%-12u", unsigned(secondsSinceEpoch));
   memcpy(Hdr.date,buffer,12);
-  sprintf(buffer,"%-10u",symTabSize);
+  sprintf(buffer,"%-10u",Size);
   memcpy(Hdr.size,buffer,10);
+}
 
-  // Write the header
-  ARFile.write((char*)&Hdr, sizeof(Hdr));
+// Return the number of buckets in the symbol index for NumSymbols symbols.
+// Keep the table at most half full so that probe sequences stay short.
+static unsigned getNumIndexBuckets(unsigned NumSymbols) {
+  unsigned NumBuckets = 1;
+  while (NumBuckets < 2 * NumSymbols)
+    NumBuckets <<= 1;
+  return NumBuckets;
+}
+
+// Return the size of the symbol index's data for symTab.
+static unsigned getSymbolIndexSize(const Archive::SymTabType &symTab) {
+  unsigned Size = ArchiveSymbolIndex::HeaderSize +
+    getNumIndexBuckets(symTab.size()) * ArchiveSymbolIndex::BucketSize;
+  for (Archive::SymTabType::const_iterator I = symTab.begin(),
+       E = symTab.end(); I != E; ++I)
+    Size += I->first.length();
+  return Size;
+}
+
+// Return how many bytes a member with size bytes of data takes in the file,
+// including its header, long name and padding.
+unsigned
+Archive::getMemberSize(const ArchiveMember& member, unsigned size,
+                       bool TruncateNames) const {
+  ArchiveMemberHeader Hdr;
+  unsigned Total = sizeof(Hdr) + size;
+  if (fillHeader(member,Hdr,size,TruncateNames))
+    Total += member.getPath().str().length();
+  return (Total + 1) & ~1U;
+}
+
+// Write one member out to the buffer.
+void
+Archive::writeMember(const ArchiveMember& member, const char* data,
+                     unsigned size, bool TruncateNames, char*& Out) const {
+  char *Start = Out;
+
+  // Compute the fields of the header
+  ArchiveMemberHeader Hdr;
+  bool writeLongName = fillHeader(member,Hdr,size,TruncateNames);
+
+  // Write header to archive file
+  memcpy(Out, &Hdr, sizeof(Hdr));
+  Out += sizeof(Hdr);
+
+  // Write the long filename if its long
+  if (writeLongName) {
+    const std::string &Path = member.getPath().str();
+    memcpy(Out, Path.data(), Path.length());
+    Out += Path.length();
+  }
+
+  // Write the member's content to the file.
+  memcpy(Out, data, size);
+  Out += size;
+
+  // Make sure the member is an even length
+  if ((Out - Start) & 1)
+    *Out++ = ARFILE_PAD[0];
+}
+
+// Write out the LLVM symbol table as an archive member to the buffer.
+void
+Archive::writeSymbolTable(char*& Out) {
+  ArchiveMemberHeader Hdr;
+  fillSymbolTableHeader(Hdr, ARFILE_LLVM_SYMTAB_NAME, symTabSize);
+  memcpy(Out, &Hdr, sizeof(Hdr));
+  Out += sizeof(Hdr);
 
-#ifndef NDEBUG
   // Save the starting position of the symbol tables data content.
-  unsigned startpos = ARFile.tellp();
-#endif
+  char *Start = Out;
 
   // Write out the symbols sequentially
-  for ( Archive::SymTabType::iterator I = symTab.begin(), E = symTab.end();
-        I != E; ++I)
-  {
+  for (SymTabType::iterator I = symTab.begin(), E = symTab.end(); I != E;
+       ++I) {
     // Write out the file index
-    writeInteger(I->second, ARFile);
+    writeInteger(I->second, Out);
     // Write out the length of the symbol
-    writeInteger(I->first.length(), ARFile);
+    writeInteger(I->first.length(), Out);
     // Write out the symbol
-    ARFile.write(I->first.data(), I->first.length());
+    memcpy(Out, I->first.data(), I->first.length());
+    Out += I->first.length();
   }
 
-#ifndef NDEBUG
-  // Now that we're done with the symbol table, get the ending file position
-  unsigned endpos = ARFile.tellp();
-#endif
-
   // Make sure that the amount we wrote is what we pre-computed. This is
   // critical for file integrity purposes.
-  assert(endpos - startpos == symTabSize && "Invalid symTabSize computation");
+  assert(unsigned(Out - Start) == symTabSize &&
+         "Invalid symTabSize computation");
+  (void)Start;
 
   // Make sure the symbol table is even sized
-  if (symTabSize % 2 != 0 )
-    ARFile << ARFILE_PAD;
+  if (symTabSize % 2 != 0)
+    *Out++ = ARFILE_PAD[0];
+}
+
+// Write a little-endian 32-bit integer to the symbol index.
+static inline void writeLE32(unsigned num, char*& Out) {
+  *Out++ = char(num);
+  *Out++ = char(num >> 8);
+  *Out++ = char(num >> 16);
+  *Out++ = char(num >> 24);
+}
+
+// Write out the hashed index of symTab as an archive member to the buffer.
+// See ArchiveInternals.h for the layout.
+void
+Archive::writeSymbolIndex(char*& Out) {
+  unsigned NumBuckets = getNumIndexBuckets(symTab.size());
+  unsigned Mask = NumBuckets - 1;
+
+  std::vector<unsigned> Buckets(NumBuckets * 4, 0);
+  unsigned NameOffset = 0;
+  for (SymTabType::iterator I = symTab.begin(), E = symTab.end(); I != E;
+       ++I) {
+    unsigned Hash = HashString(I->first);
+    unsigned B = Hash & Mask;
+    while (Buckets[B * 4 + 2] != 0)
+      B = (B + 1) & Mask;
+    Buckets[B * 4] = Hash;
+    Buckets[B * 4 + 1] = NameOffset;
+    Buckets[B * 4 + 2] = I->first.length();
+    Buckets[B * 4 + 3] = I->second;
+    NameOffset += I->first.length();
+  }
+  unsigned Size = getSymbolIndexSize(symTab);
+
+  // Construct the index's header the same way as the symbol table's.
+  ArchiveMemberHeader Hdr;
+  fillSymbolTableHeader(Hdr, ARFILE_LLVM_SYMIDX_NAME, Size);
+  memcpy(Out, &Hdr, sizeof(Hdr));
+  Out += sizeof(Hdr);
+
+  writeLE32(NumBuckets, Out);
+  writeLE32(symTabSize, Out);
+  for (unsigned i = 0, e = Buckets.size(); i != e; ++i)
+    writeLE32(Buckets[i], Out);
+  for (SymTabType::iterator I = symTab.begin(), E = symTab.end(); I != E;
+       ++I) {
+    memcpy(Out, I->first.data(), I->first.length());
+    Out += I->first.length();
+  }
+
+  // Make sure the symbol index is even sized
+  if (Size % 2 != 0)
+    *Out++ = ARFILE_PAD[0];
 }
 
 // Write the entire archive to the file specified when the archive was created.
-// This writes to a temporary file first. Options are for creating a symbol
-// table, flattening the file names (no directories, 15 chars max) and
-// compressing each archive member.
+// Options are for creating a symbol table and flattening the file names (no
+// directories, 15 chars max). The symbols of bitcode members are read on up to
+// NumThreads threads and merged in member order, so the output does not depend
+// on NumThreads. The whole archive is laid out first and then written through
+// one mapped buffer into a temporary file, which replaces the archive once it
+// is complete.
 bool
 Archive::writeToDisk(bool CreateSymbolTable, bool TruncateNames,
-                     std::string* ErrMsg)
+                     std::string* ErrMsg, unsigned NumThreads)
 {
   // Make sure they haven't opened up the file, not loaded it,
   // but are now trying to write it which would wipe out the file.
@@ -360,115 +468,132 @@ Archive::writeToDisk(bool CreateSymbolTable, bool TruncateNames,
     return true;
   }
 
-  // Create a temporary file to store the archive in
-  sys::Path TmpArchive = archPath;
-  if (TmpArchive.createTemporaryFileOnDisk(ErrMsg))
-    return true;
-
-  // Make sure the temporary gets removed if we crash
-  sys::RemoveFileOnSignal(TmpArchive);
-
-  // Create archive file for output.
-  std::ios::openmode io_mode = std::ios::out | std::ios::trunc |
-                               std::ios::binary;
-  std::ofstream ArchiveFile(TmpArchive.c_str(), io_mode);
-
-  // Check for errors opening or creating archive file.
-  if (!ArchiveFile.is_open() || ArchiveFile.bad()) {
-    TmpArchive.eraseFromDisk();
-    if (ErrMsg)
-      *ErrMsg = "Error opening archive file: " + archPath.str();
-    return true;
-  }
+  MemberFiles Files;
+  std::vector<MemberInfo> Members(members.size());
+  unsigned Idx = 0;
+  for (MembersList::iterator I = begin(), E = end(); I != E; ++I, ++Idx)
+    if (getMemberData(*I, Members[Idx], Files, ErrMsg))
+      return true;
 
-  // If we're creating a symbol table, reset it now
   if (CreateSymbolTable) {
-    symTabSize = 0;
-    symTab.clear();
-  }
-
-  // Write magic string to archive.
-  ArchiveFile << ARFILE_MAGIC;
-
-  // Loop over all member files, and write them out. Note that this also
-  // builds the symbol table, symTab.
-  for (MembersList::iterator I = begin(), E = end(); I != E; ++I) {
-    if (writeMember(*I, ArchiveFile, CreateSymbolTable,
-                     TruncateNames, ErrMsg)) {
-      TmpArchive.eraseFromDisk();
-      ArchiveFile.close();
-      return true;
+    if (NumThreads < 1)
+      NumThreads = 1;
+    if (NumThreads > Members.size())
+      NumThreads = std::max<size_t>(Members.size(), 1);
+    std::string ArchiveName = archPath.str();
+    std::vector<SymbolScanJob> Jobs(NumThreads);
+    std::vector<void*> JobPtrs(NumThreads);
+    for (unsigned i = 0; i != NumThreads; ++i) {
+      SymbolScanJob &Job = Jobs[i];
+      Job.Members = &Members;
+      Job.ArchiveName = &ArchiveName;
+      Job.Context = NumThreads == 1 ? &Context : 0;
+      Job.First = i;
+      Job.Stride = NumThreads;
+      JobPtrs[i] = &Job;
     }
+    llvm_execute_on_threads(scanMemberSymbols, &JobPtrs[0], NumThreads,
+                            NumThreads);
   }
 
-  // Close archive file.
-  ArchiveFile.close();
+  // Lay out the members. Offsets start at the first member; the symbol index
+  // is added to those in the symbol table below.
+  unsigned MembersSize = 0;
+  for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+    MemberInfo &MI = Members[i];
+    MI.Offset = MembersSize;
+    MembersSize += getMemberSize(*MI.Member, MI.Size, TruncateNames);
+  }
 
-  // Write the symbol table
+  // Rebuild the symbol table. Members are merged in order, so the first
+  // definition of a symbol wins.
+  unsigned IndexSize = 0;
   if (CreateSymbolTable) {
-    // At this point we have written a file that is a legal archive but it
-    // doesn't have a symbol table in it. To aid in faster reading and to
-    // ensure compatibility with other archivers we need to put the symbol
-    // table first in the file. Unfortunately, this means mapping the file
-    // we just wrote back in and copying it to the destination file.
-    sys::Path FinalFilePath = archPath;
-
-    // Map in the archive we just wrote.
-    {
-    OwningPtr<MemoryBuffer> arch;
-    if (error_code ec = MemoryBuffer::getFile(TmpArchive.c_str(), arch)) {
-      if (ErrMsg)
-        *ErrMsg = ec.message();
-      return true;
+    symTab.clear();
+    for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+      MemberInfo &MI = Members[i];
+      if (MI.Failed) {
+        if (ErrMsg)
+          *ErrMsg = "Can't parse bitcode member: " +
+            MI.Member->getPath().str() + ": " + MI.Error;
+        return true;
+      }
+      for (std::vector<std::string>::iterator SI = MI.Symbols.begin(),
+           SE = MI.Symbols.end(); SI != SE; ++SI)
+        symTab.insert(std::make_pair(*SI,MI.Offset));
     }
-    const char* base = arch->getBufferStart();
-
-    // Open another temporary file in order to avoid invalidating the
-    // mmapped data
-    if (FinalFilePath.createTemporaryFileOnDisk(ErrMsg))
-      return true;
-    sys::RemoveFileOnSignal(FinalFilePath);
 
-    std::ofstream FinalFile(FinalFilePath.c_str(), io_mode);
-    if (!FinalFile.is_open() || FinalFile.bad()) {
-      TmpArchive.eraseFromDisk();
-      if (ErrMsg)
-        *ErrMsg = "Error opening archive file: " + FinalFilePath.str();
-      return true;
+    // The symbol index follows the symbol table and offsets are counted from
+    // its start. Its size depends only on the names, so the offsets can be
+    // moved past it before the symbol table's size is computed.
+    IndexSize = getSymbolIndexSize(symTab);
+    unsigned IndexMemberSize =
+      sizeof(ArchiveMemberHeader) + ((IndexSize + 1) & ~1U);
+    symTabSize = 0;
+    for (SymTabType::iterator I = symTab.begin(), E = symTab.end(); I != E;
+         ++I) {
+      I->second += IndexMemberSize;
+      symTabSize += I->first.length() +
+                    numVbrBytes(I->first.length()) +
+                    numVbrBytes(I->second);
     }
+  }
 
-    // Write the file magic number
-    FinalFile << ARFILE_MAGIC;
-
-    // If there is a foreign symbol table, put it into the file now. Most
-    // ar(1) implementations require the symbol table to be first but llvm-ar
-    // can deal with it being after a foreign symbol table. This ensures
-    // compatibility with other ar(1) implementations as well as allowing the
-    // archive to store both native .o and LLVM .bc files, both indexed.
+  // If there is a foreign symbol table, it goes first. Most ar(1)
+  // implementations require the symbol table to be first but llvm-ar can
+  // deal with it being after a foreign symbol table. This ensures
+  // compatibility with other ar(1) implementations as well as allowing the
+  // archive to store both native .o and LLVM .bc files, both indexed. The
+  // LLVM symbol table and index follow, then the members.
+  size_t FileSize = ARFILE_MAGIC_LEN + MembersSize;
+  MemberInfo ForeignST;
+  if (CreateSymbolTable) {
     if (foreignST) {
-      if (writeMember(*foreignST, FinalFile, false, false, ErrMsg)) {
-        FinalFile.close();
-        TmpArchive.eraseFromDisk();
+      if (getMemberData(*foreignST, ForeignST, Files, ErrMsg))
         return true;
-      }
+      FileSize += getMemberSize(*foreignST, ForeignST.Size, false);
     }
+    FileSize += sizeof(ArchiveMemberHeader) + ((symTabSize + 1) & ~1U);
+    FileSize += sizeof(ArchiveMemberHeader) + ((IndexSize + 1) & ~1U);
+  }
 
-    // Put out the LLVM symbol table now.
-    writeSymbolTable(FinalFile);
+  // Create a temporary file to store the archive in
+  sys::Path TmpArchive = archPath;
+  if (TmpArchive.createTemporaryFileOnDisk(ErrMsg))
+    return true;
 
-    // Copy the temporary file contents being sure to skip the file's magic
-    // number.
-    FinalFile.write(base + sizeof(ARFILE_MAGIC)-1,
-      arch->getBufferSize()-sizeof(ARFILE_MAGIC)+1);
+  // Make sure the temporary gets removed if we crash
+  sys::RemoveFileOnSignal(TmpArchive);
+
+  OwningPtr<FileOutputBuffer> Output;
+  if (FileOutputBuffer::create(TmpArchive.str(), FileSize, Output)) {
+    TmpArchive.eraseFromDisk();
+    if (ErrMsg)
+      *ErrMsg = "Error opening archive file: " + archPath.str();
+    return true;
+  }
 
-    // Close up shop
-    FinalFile.close();
-    } // free arch.
+  char *Out = (char*)Output->getBufferStart();
+  memcpy(Out, ARFILE_MAGIC, ARFILE_MAGIC_LEN);
+  Out += ARFILE_MAGIC_LEN;
+  if (CreateSymbolTable) {
+    if (foreignST)
+      writeMember(*foreignST, ForeignST.Data, ForeignST.Size, false, Out);
+    writeSymbolTable(Out);
+    writeSymbolIndex(Out);
+  }
+  for (unsigned i = 0, e = Members.size(); i != e; ++i)
+    writeMember(*Members[i].Member, Members[i].Data, Members[i].Size,
+                TruncateNames, Out);
+  assert(Out == (char*)Output->getBufferEnd() && "Invalid archive layout");
 
-    // Move the final file over top of TmpArchive
-    if (FinalFilePath.renamePathOnDisk(TmpArchive, ErrMsg))
-      return true;
+  if (error_code ec = Output->commit()) {
+    TmpArchive.eraseFromDisk();
+    if (ErrMsg)
+      *ErrMsg = ec.message();
+    return true;
   }
+  Output.reset();
 
   // Before we replace the actual archive, we need to forget all the
   // members, since they point to data in that old archive. We need to do
@@ -487,3 +612,4 @@ Archive::writeToDisk(bool CreateSymbolTable, bool TruncateNames,
 
   return false;
 }
+// @LOCALMOD-END
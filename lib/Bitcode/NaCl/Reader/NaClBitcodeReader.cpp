@@ -14,6 +14,7 @@
 #include "NaClBitcodeReader.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -28,6 +29,8 @@
 #include "llvm/Support/MemoryBuffer.h"
 using namespace llvm;
 
+STATISTIC(NumReleasedBodies, "Number of function bodies released after use");
+
 enum {
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
@@ -2887,8 +2890,11 @@ void NaClBitcodeReader::Dematerialize(GlobalValue *GV) {
 
   assert(DeferredFunctionInfo.count(F) && "No info to read function later?");
 
-  // Just forget the function body, we can remat it later.
-  F->deleteBody();
+  // Just forget the function body, we can remat it later. Give back the
+  // argument list and local symbol table too, which a translator streaming
+  // through thousands of functions would otherwise keep for each of them.
+  F->releaseBody();
+  ++NumReleasedBodies;
 }
 
 
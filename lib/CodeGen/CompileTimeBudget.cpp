@@ -0,0 +1,47 @@
+//===-- CompileTimeBudget.cpp - Per-function code generation budget -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "codegen-budget"
+#include "llvm/CodeGen/CompileTimeBudget.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+using namespace llvm;
+
+STATISTIC(NumFunctionsOverBudget,
+          "Number of functions that exceeded the code generation budget");
+
+static cl::opt<unsigned>
+CodeGenTimeBudget("codegen-time-budget", cl::Hidden, cl::init(0),
+                  cl::value_desc("milliseconds"),
+                  cl::desc("Time allowed for generating code for one function "
+                           "before expensive passes fall back to cheaper "
+                           "strategies (0 = unlimited)"));
+
+static cl::opt<bool>
+CodeGenBudgetExhausted("codegen-budget-exhausted", cl::Hidden,
+                       cl::desc("Treat the code generation budget of every "
+                                "function as used up (for testing)"));
+
+CompileTimeBudget::CompileTimeBudget()
+  : Enabled(CodeGenTimeBudget != 0 || CodeGenBudgetExhausted),
+    Exceeded(false) {
+  if (!Enabled)
+    return;
+  sys::TimeValue Limit;
+  Limit.msec(CodeGenTimeBudget);
+  Deadline = sys::TimeValue::now() + Limit;
+}
+
+bool CompileTimeBudget::checkDeadline() {
+  if (sys::TimeValue::now() < Deadline)
+    return false;
+  Exceeded = true;
+  ++NumFunctionsOverBudget;
+  return true;
+}
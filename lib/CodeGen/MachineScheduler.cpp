@@ -17,6 +17,7 @@
 #include "llvm/CodeGen/MachineScheduler.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/PriorityQueue.h"
+#include "llvm/ADT/Statistic.h" // @LOCALMOD
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/LiveIntervalAnalysis.h"
 #include "llvm/CodeGen/Passes.h"
@@ -32,6 +33,11 @@
 
 using namespace llvm;
 
+// @LOCALMOD-BEGIN
+STATISTIC(NumRegionsOverBudget, "Number of regions left unscheduled because "
+                                "of the code generation budget");
+// @LOCALMOD-END
+
 namespace llvm {
 cl::opt<bool> ForceTopDown("misched-topdown", cl::Hidden,
                            cl::desc("Force top-down list scheduling"));
@@ -261,6 +267,15 @@ bool MachineScheduler::runOnMachineFunction(MachineFunction &mf) {
         Scheduler->exitRegion();
         continue;
       }
+      // @LOCALMOD-BEGIN
+      // Leave the region in its current order once the function is over its
+      // code generation budget.
+      if (MF->getCompileTimeBudget().isExceeded()) {
+        ++NumRegionsOverBudget;
+        Scheduler->exitRegion();
+        continue;
+      }
+      // @LOCALMOD-END
       DEBUG(dbgs() << "********** MI Scheduling **********\n");
       DEBUG(dbgs() << MF->getName()
             << ":BB#" << MBB->getNumber() << " " << MBB->getName()
@@ -18,6 +18,7 @@
 #include "InterferenceCache.h"
 #include "LiveDebugVariables.h"
 #include "RegAllocBase.h"
+#include "RegAllocLinearScan.h" // @LOCALMOD
 #include "SpillPlacement.h"
 #include "Spiller.h"
 #include "SplitKit.h"
@@ -49,6 +50,12 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+// @LOCALMOD-BEGIN
+STATISTIC(NumOverBudget,   "Number of ranges spilled without splitting because "
+                           "of the code generation budget");
+STATISTIC(NumLinearScanFuncs, "Number of functions handed to the linear scan "
+                              "allocator because of their size");
+// @LOCALMOD-END
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -59,6 +66,14 @@ SplitSpillMode("split-spill-mode", cl::Hidden,
              clEnumValEnd),
   cl::init(SplitEditor::SM_Partition));
 
+// @LOCALMOD-BEGIN
+static cl::opt<unsigned>
+LinearScanThreshold("regalloc-linear-threshold", cl::Hidden, cl::init(0),
+  cl::desc("Allocate functions with more virtual registers than this with "
+           "the faster but lower quality linear scan allocator (default: 0, "
+           "never)"));
+// @LOCALMOD-END
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -1725,10 +1740,18 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
 
   assert(NewVRegs.empty() && "Cannot append to existing NewVRegs");
 
+  // @LOCALMOD-BEGIN
+  // Splitting is where allocation time goes in bad cases. Once the function
+  // is over its code generation budget, spill anything that could not be
+  // assigned or evicted for right away.
+  bool OverBudget = VirtReg.isSpillable() &&
+                    MF->getCompileTimeBudget().isExceeded();
+  // @LOCALMOD-END
+
   // The first time we see a live range, don't try to split or spill.
   // Wait until the second time, when all smaller ranges have been allocated.
   // This gives a better picture of the interference to split around.
-  if (Stage < RS_Split) {
+  if (Stage < RS_Split && !OverBudget) { // @LOCALMOD
     setStage(VirtReg, RS_Split);
     DEBUG(dbgs() << "wait for second round\n");
     NewVRegs.push_back(&VirtReg);
@@ -1741,9 +1764,15 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
     return ~0u;
 
   // Try splitting VirtReg or interferences.
-  unsigned PhysReg = trySplit(VirtReg, Order, NewVRegs);
-  if (PhysReg || !NewVRegs.empty())
-    return PhysReg;
+  // @LOCALMOD-BEGIN
+  if (OverBudget) {
+    ++NumOverBudget;
+  } else {
+    unsigned PhysReg = trySplit(VirtReg, Order, NewVRegs);
+    if (PhysReg || !NewVRegs.empty())
+      return PhysReg;
+  }
+  // @LOCALMOD-END
 
   // Finally spill VirtReg itself.
   NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
@@ -1767,6 +1796,19 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   if (VerifyEnabled)
     MF->verify(this, "Before greedy register allocator");
 
+  // @LOCALMOD-BEGIN
+  // Splitting and eviction chains make greedy superlinear in the size of the
+  // function. Very large functions are allocated in near linear time instead.
+  if (LinearScanThreshold &&
+      MF->getRegInfo().getNumVirtRegs() > LinearScanThreshold) {
+    ++NumLinearScanFuncs;
+    LinearScanAllocator(*this).allocate(*MF, getAnalysis<VirtRegMap>(),
+                                        getAnalysis<LiveIntervals>(),
+                                        getAnalysis<LiveRegMatrix>());
+    return true;
+  }
+  // @LOCALMOD-END
+
   RegAllocBase::init(getAnalysis<VirtRegMap>(),
                      getAnalysis<LiveIntervals>(),
                      getAnalysis<LiveRegMatrix>());
@@ -0,0 +1,253 @@
+//===-- RegAllocLinearScan.cpp - Linear scan register allocator -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements LinearScanAllocator and the RALinearScan function pass
+// that runs it on its own.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "regalloc"
+#include "RegAllocLinearScan.h"
+#include "AllocationOrder.h"
+#include "LiveDebugVariables.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/CodeGen/CalcSpillWeights.h"
+#include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/CodeGen/LiveRangeEdit.h"
+#include "llvm/CodeGen/LiveRegMatrix.h"
+#include "llvm/CodeGen/LiveStackAnalysis.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/RegAllocRegistry.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+
+using namespace llvm;
+
+STATISTIC(NumEvicted, "Number of intervals evicted to free a register");
+STATISTIC(NumSpilled, "Number of intervals spilled for lack of a register, "
+                      "including evicted ones");
+
+static RegisterRegAlloc linearRegAlloc("linear",
+                                       "linear scan register allocator",
+                                       createLinearScanRegisterAllocator);
+
+LinearScanAllocator::LinearScanAllocator(MachineFunctionPass &Pass)
+  : Pass(Pass), MF(0) {}
+
+void LinearScanAllocator::enqueue(LiveInterval *LI) {
+  SlotIndex Start = LI->empty() ? LIS->getSlotIndexes()->getZeroIndex()
+                                : LI->beginIndex();
+  Queue.push(std::make_pair(Start, LI->reg));
+}
+
+LiveInterval *LinearScanAllocator::dequeue() {
+  if (Queue.empty())
+    return 0;
+  LiveInterval *LI = &LIS->getInterval(Queue.top().second);
+  Queue.pop();
+  return LI;
+}
+
+// Collect the virtual registers assigned to PhysReg or an alias that interfere
+// with VirtReg into Intfs, and set Cost to the sum of their spill weights.
+// Return false if one of them may not be evicted for VirtReg: only lighter,
+// spillable intervals are evicted, so the allocation always makes progress.
+bool LinearScanAllocator::collectEvictable(LiveInterval &VirtReg,
+                                           unsigned PhysReg, float &Cost) {
+  Intfs.clear();
+  Cost = 0;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    Q.collectInterferingVRegs();
+    if (Q.seenUnspillableVReg())
+      return false;
+    for (unsigned i = Q.interferingVRegs().size(); i; --i) {
+      LiveInterval *Intf = Q.interferingVRegs()[i - 1];
+      if (!Intf->isSpillable() || Intf->weight >= VirtReg.weight)
+        return false;
+      // Wide registers see the same interval through several units.
+      if (std::find(Intfs.begin(), Intfs.end(), Intf) != Intfs.end())
+        continue;
+      Intfs.push_back(Intf);
+      Cost += Intf->weight;
+    }
+  }
+  return true;
+}
+
+// Assign VirtReg the first free register in its allocation order. When there
+// is none, pick the register whose interfering intervals are cheapest to spill
+// and evict them, provided together they weigh less than VirtReg. Otherwise
+// spill VirtReg itself. An evicted interval is requeued once and spilled the
+// next time it is evicted; nothing is split, so each interval costs at most
+// two interference checks per register in its class.
+unsigned
+LinearScanAllocator::selectOrSplit(LiveInterval &VirtReg,
+                                   SmallVectorImpl<LiveInterval*> &SplitVRegs) {
+  SmallVector<unsigned, 8> PhysRegSpillCands;
+
+  AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo);
+  while (unsigned PhysReg = Order.next()) {
+    switch (Matrix->checkInterference(VirtReg, PhysReg)) {
+    case LiveRegMatrix::IK_Free:
+      return PhysReg;
+    case LiveRegMatrix::IK_VirtReg:
+      PhysRegSpillCands.push_back(PhysReg);
+      continue;
+    default:
+      // RegMask or RegUnit interference.
+      continue;
+    }
+  }
+
+  // An interval that was evicted once only takes free registers.
+  Evicted.resize(MRI->getNumVirtRegs());
+  if (Evicted.test(TargetRegisterInfo::virtReg2Index(VirtReg.reg)))
+    PhysRegSpillCands.clear();
+
+  unsigned BestPhys = 0;
+  float BestCost = VirtReg.weight;
+  for (unsigned i = 0, e = PhysRegSpillCands.size(); i != e; ++i) {
+    float Cost;
+    if (!collectEvictable(VirtReg, PhysRegSpillCands[i], Cost))
+      continue;
+    if (Cost < BestCost) {
+      BestPhys = PhysRegSpillCands[i];
+      BestCost = Cost;
+    }
+  }
+
+  if (BestPhys) {
+    float Cost;
+    collectEvictable(VirtReg, BestPhys, Cost);
+    DEBUG(dbgs() << "spilling " << TRI->getName(BestPhys)
+                 << " interferences with " << VirtReg << '\n');
+    for (unsigned i = 0, e = Intfs.size(); i != e; ++i) {
+      LiveInterval &Spill = *Intfs[i];
+      // A LiveInterval instance may not be in a union during modification!
+      Matrix->unassign(Spill);
+      ++NumEvicted;
+      // Give each interval one more chance to find a free register.
+      unsigned Idx = TargetRegisterInfo::virtReg2Index(Spill.reg);
+      if (!Evicted.test(Idx)) {
+        Evicted.set(Idx);
+        SplitVRegs.push_back(&Spill);
+        continue;
+      }
+      LiveRangeEdit LRE(&Spill, SplitVRegs, *MF, *LIS, VRM);
+      spiller().spill(LRE);
+      ++NumSpilled;
+    }
+    assert(!Matrix->checkInterference(VirtReg, BestPhys) &&
+           "Interference after spill.");
+    return BestPhys;
+  }
+
+  DEBUG(dbgs() << "spilling: " << VirtReg << '\n');
+  if (!VirtReg.isSpillable())
+    return ~0u;
+  LiveRangeEdit LRE(&VirtReg, SplitVRegs, *MF, *LIS, VRM);
+  spiller().spill(LRE);
+  ++NumSpilled;
+  return 0;
+}
+
+void LinearScanAllocator::allocate(MachineFunction &mf, VirtRegMap &vrm,
+                                   LiveIntervals &lis, LiveRegMatrix &mat) {
+  MF = &mf;
+  RegAllocBase::init(vrm, lis, mat);
+  SpillerInstance.reset(createInlineSpiller(Pass, *MF, *VRM));
+
+  allocatePhysRegs();
+
+  DEBUG(dbgs() << "Post alloc VirtRegMap:\n" << *VRM << "\n");
+  SpillerInstance.reset(0);
+  Evicted.clear();
+  Intfs.clear();
+}
+
+namespace {
+/// RALinearScan runs LinearScanAllocator on every function.
+class RALinearScan : public MachineFunctionPass {
+public:
+  static char ID;
+
+  RALinearScan();
+
+  virtual const char* getPassName() const {
+    return "Linear Scan Register Allocator";
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+  virtual bool runOnMachineFunction(MachineFunction &mf);
+};
+
+char RALinearScan::ID = 0;
+
+} // end anonymous namespace
+
+RALinearScan::RALinearScan(): MachineFunctionPass(ID) {
+  initializeLiveDebugVariablesPass(*PassRegistry::getPassRegistry());
+  initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
+  initializeSlotIndexesPass(*PassRegistry::getPassRegistry());
+  initializeRegisterCoalescerPass(*PassRegistry::getPassRegistry());
+  initializeMachineSchedulerPass(*PassRegistry::getPassRegistry());
+  initializeCalculateSpillWeightsPass(*PassRegistry::getPassRegistry());
+  initializeLiveStacksPass(*PassRegistry::getPassRegistry());
+  initializeMachineDominatorTreePass(*PassRegistry::getPassRegistry());
+  initializeMachineLoopInfoPass(*PassRegistry::getPassRegistry());
+  initializeVirtRegMapPass(*PassRegistry::getPassRegistry());
+  initializeLiveRegMatrixPass(*PassRegistry::getPassRegistry());
+}
+
+void RALinearScan::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesCFG();
+  AU.addRequired<AliasAnalysis>();
+  AU.addPreserved<AliasAnalysis>();
+  AU.addRequired<LiveIntervals>();
+  AU.addPreserved<LiveIntervals>();
+  AU.addPreserved<SlotIndexes>();
+  AU.addRequired<LiveDebugVariables>();
+  AU.addPreserved<LiveDebugVariables>();
+  AU.addRequired<CalculateSpillWeights>();
+  AU.addRequired<LiveStacks>();
+  AU.addPreserved<LiveStacks>();
+  AU.addRequiredID(MachineDominatorsID);
+  AU.addPreservedID(MachineDominatorsID);
+  AU.addRequired<MachineLoopInfo>();
+  AU.addPreserved<MachineLoopInfo>();
+  AU.addRequired<VirtRegMap>();
+  AU.addPreserved<VirtRegMap>();
+  AU.addRequired<LiveRegMatrix>();
+  AU.addPreserved<LiveRegMatrix>();
+  MachineFunctionPass::getAnalysisUsage(AU);
+}
+
+bool RALinearScan::runOnMachineFunction(MachineFunction &mf) {
+  DEBUG(dbgs() << "********** LINEAR SCAN REGISTER ALLOCATION **********\n"
+               << "********** Function: " << mf.getName() << '\n');
+
+  LinearScanAllocator(*this).allocate(mf, getAnalysis<VirtRegMap>(),
+                                      getAnalysis<LiveIntervals>(),
+                                      getAnalysis<LiveRegMatrix>());
+  return true;
+}
+
+FunctionPass *llvm::createLinearScanRegisterAllocator() {
+  return new RALinearScan();
+}
@@ -11,6 +11,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "selectiondag" // @LOCALMOD
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "SDNodeDbgValue.h"
 #include "SDNodeOrdering.h"
@@ -18,6 +19,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h" // @LOCALMOD
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Analysis/ValueTracking.h"
@@ -53,6 +55,14 @@
 #include <cmath>
 using namespace llvm;
 
+// @LOCALMOD-BEGIN
+STATISTIC(NumArenaResets,    "Number of per-block SelectionDAG arena resets");
+STATISTIC(NumNodesReleased,  "Number of SDNodes released by arena resets");
+STATISTIC(NumNodeBytes,      "Bytes of SDNode arena memory reset");
+STATISTIC(NumOperandBytes,   "Bytes of SDNode operand arena memory reset");
+STATISTIC(NumCSEMapResizes,  "Number of times the CSE map was resized");
+// @LOCALMOD-END
+
 /// makeVTList - Return an instance of the SDVTList struct initialized with the
 /// specified members.
 static SDVTList makeVTList(const EVT *VTs, unsigned NumVTs) {
@@ -903,9 +913,40 @@ void SelectionDAG::allnodes_clear() {
 }
 
 void SelectionDAG::clear() {
-  allnodes_clear();
+  // @LOCALMOD-BEGIN
+  ++NumArenaResets;
+  NumNodeBytes += NodeAllocator.getTotalMemory();
+  NumOperandBytes += OperandAllocator.getTotalMemory();
+
+  // Every node of the block dies at once, so instead of recycling the nodes
+  // one at a time, which also updates the ordering and debug value maps for
+  // each, only free the operand lists that live outside the arenas and then
+  // reset the node arena as a whole. The maps are cleared below.
+  assert(&*AllNodes.begin() == &EntryNode);
+  AllNodes.remove(AllNodes.begin());
+  unsigned NumNodes = 0;
+  for (allnodes_iterator I = AllNodes.begin(), E = AllNodes.end(); I != E;
+       ++I, ++NumNodes)
+    if (I->OperandsNeedDelete)
+      delete[] I->OperandList;
+  NumNodesReleased += NumNodes;
+  AllNodes.clearAndLeakNodesUnsafely();
+  NodeAllocator.Reset();
   OperandAllocator.Reset();
-  CSEMap.clear();
+
+  // Size the CSE map from the number of nodes the block just finished left in
+  // it, with room to spare. The map only grows on its own, and clearing it
+  // takes time in proportion to its size, so after one huge block it would
+  // otherwise slow down every block that follows. Small maps are cheaper to
+  // clear than to grow again, so they are left alone.
+  unsigned CSESize = std::max(CSEMap.size(), 512u);
+  if (CSEMap.capacity() > 8 * CSESize) {
+    CSEMap.clearAndResize(2 * CSESize);
+    ++NumCSEMapResizes;
+  } else {
+    CSEMap.clear();
+  }
+  // @LOCALMOD-END
 
   ExtendedValueTypeNodes.clear();
   ExternalSymbols.clear();
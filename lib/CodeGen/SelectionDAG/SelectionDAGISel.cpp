@@ -60,6 +60,10 @@ using namespace llvm;
 
 STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
 STATISTIC(NumDAGBlocks, "Number of blocks selected using DAG");
+// @LOCALMOD-BEGIN
+STATISTIC(NumDAGBlocksOverBudget, "Number of blocks selected like at -O0 "
+                                  "because of the code generation budget");
+// @LOCALMOD-END
 
 #ifndef NDEBUG
 STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
@@ -579,6 +583,18 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     BlockName = MF->getName().str() + ":" +
                 FuncInfo->MBB->getBasicBlock()->getName().str();
   }
+  // @LOCALMOD-BEGIN
+  // Once the function is over its code generation budget, select the
+  // remaining blocks the way -O0 does: without the alias-based chain
+  // combines, and with source order scheduling.
+  CodeGenOpt::Level BlockOptLevel = OptLevel;
+  if (OptLevel != CodeGenOpt::None &&
+      MF->getCompileTimeBudget().isExceeded()) {
+    BlockOptLevel = CodeGenOpt::None;
+    ++NumDAGBlocksOverBudget;
+  }
+  // @LOCALMOD-END
+
   DEBUG(dbgs() << "Initial selection DAG: BB#" << BlockNumber
         << " '" << BlockName << "'\n"; CurDAG->dump());
   if (ViewDAGCombine1) CurDAG->viewGraph("dag-combine1 input for " + BlockName);
@@ -586,7 +602,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   // Run the DAG combiner in pre-legalize mode.
   {
     NamedRegionTimer T("DAG Combining 1", GroupName, TimePassesIsEnabled);
-    CurDAG->Combine(BeforeLegalizeTypes, *AA, OptLevel);
+    CurDAG->Combine(BeforeLegalizeTypes, *AA, BlockOptLevel); // @LOCALMOD
   }
 
   DEBUG(dbgs() << "Optimized lowered selection DAG: BB#" << BlockNumber
@@ -613,7 +629,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("DAG Combining after legalize types", GroupName,
                          TimePassesIsEnabled);
-      CurDAG->Combine(AfterLegalizeTypes, *AA, OptLevel);
+      CurDAG->Combine(AfterLegalizeTypes, *AA, BlockOptLevel); // @LOCALMOD
     }
 
     DEBUG(dbgs() << "Optimized type-legalized selection DAG: BB#" << BlockNumber
@@ -636,7 +652,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
     {
       NamedRegionTimer T("DAG Combining after legalize vectors", GroupName,
                          TimePassesIsEnabled);
-      CurDAG->Combine(AfterLegalizeVectorOps, *AA, OptLevel);
+      CurDAG->Combine(AfterLegalizeVectorOps, *AA, BlockOptLevel); // @LOCALMOD
     }
 
     DEBUG(dbgs() << "Optimized vector-legalized selection DAG: BB#"
@@ -654,7 +670,7 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   // Run the DAG combiner in post-legalize mode.
   {
     NamedRegionTimer T("DAG Combining 2", GroupName, TimePassesIsEnabled);
-    CurDAG->Combine(AfterLegalizeDAG, *AA, OptLevel);
+    CurDAG->Combine(AfterLegalizeDAG, *AA, BlockOptLevel); // @LOCALMOD
   }
 
   DEBUG(dbgs() << "Optimized legalized selection DAG: BB#" << BlockNumber
@@ -678,7 +694,10 @@ void SelectionDAGISel::CodeGenAndEmitDAG() {
   if (ViewSchedDAGs) CurDAG->viewGraph("scheduler input for " + BlockName);
 
   // Schedule machine code.
-  ScheduleDAGSDNodes *Scheduler = CreateScheduler();
+  // @LOCALMOD-BEGIN
+  ScheduleDAGSDNodes *Scheduler = BlockOptLevel == OptLevel ?
+    CreateScheduler() : createSourceListDAGScheduler(this, BlockOptLevel);
+  // @LOCALMOD-END
   {
     NamedRegionTimer T("Instruction Scheduling", GroupName,
                        TimePassesIsEnabled);
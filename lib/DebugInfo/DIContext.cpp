@@ -16,3 +16,12 @@ DIContext::~DIContext() {}
 DIContext *DIContext::getDWARFContext(object::ObjectFile *Obj) {
   return new DWARFContextInMemory(Obj);
 }
+
+// @LOCALMOD-BEGIN
+void DIContext::getLineInfoForAddresses(ArrayRef<uint64_t> Addresses,
+                                        SmallVectorImpl<DILineInfo> &Result,
+                                        DILineInfoSpecifier Specifier) {
+  for (unsigned i = 0, e = Addresses.size(); i != e; ++i)
+    Result.push_back(getLineInfoForAddress(Addresses[i], Specifier));
+}
+// @LOCALMOD-END
@@ -0,0 +1,134 @@
+//===-- DWARFAddressIndex.cpp ---------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DWARFAddressIndex.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+using namespace llvm;
+
+static const char IndexMagic[8] = { 'L', 'L', 'V', 'M', 'A', 'D', 'D', 'R' };
+static const uint32_t IndexVersion = 2;
+
+namespace {
+  /// IndexStringTable - Assigns each distinct string an offset in the
+  /// string table of the index.
+  class IndexStringTable {
+    StringMap<uint32_t> Offsets;
+    std::string Table;
+  public:
+    uint32_t add(const char *S) {
+      if (!S)
+        return -1U;
+      uint32_t Offset =
+        Offsets.GetOrCreateValue(S, (uint32_t)Table.size()).getValue();
+      if (Offset == Table.size()) {
+        Table += S;
+        Table += '\0';
+      }
+      return Offset;
+    }
+    const std::string &getTable() const { return Table; }
+  };
+}
+
+void DWARFAddressIndex::write(raw_ostream &OS, uint64_t Fingerprint,
+                              std::vector<Entry> &Entries) {
+  std::stable_sort(Entries.begin(), Entries.end(), Entry::orderByStart);
+
+  std::vector<DiskEntry> Table;
+  Table.reserve(Entries.size());
+  IndexStringTable Strings;
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const Entry &E = Entries[i];
+    if (E.End <= E.Start)
+      continue;
+    // An address covered by several entries belongs to the one that starts
+    // last, or to the first of those starting at the same address.
+    if (!Table.empty() && Table.back().Start == E.Start)
+      continue;
+    if (!Table.empty() && Table.back().End > E.Start)
+      Table.back().End = E.Start;
+
+    DiskEntry D;
+    D.Start = E.Start;
+    D.End = E.End;
+    D.CUOffset = E.CUOffset;
+    D.Row = E.Row;
+    D.SubprogramOffset = E.SubprogramOffset;
+    D.Line = E.Line;
+    D.Column = E.Column;
+    D.FileName = Strings.add(E.FileName);
+    D.AbsoluteFileName = Strings.add(E.AbsoluteFileName);
+    D.FunctionName = Strings.add(E.FunctionName);
+    Table.push_back(D);
+  }
+
+  DiskHeader H;
+  memcpy(H.Magic, IndexMagic, sizeof(H.Magic));
+  H.Version = IndexVersion;
+  H.NumEntries = Table.size();
+  H.Fingerprint = Fingerprint;
+  H.StringTableSize = Strings.getTable().size();
+  OS.write(reinterpret_cast<const char *>(&H), sizeof(H));
+  if (!Table.empty())
+    OS.write(reinterpret_cast<const char *>(&Table[0]),
+             Table.size() * sizeof(DiskEntry));
+  OS << Strings.getTable();
+}
+
+DWARFAddressIndex::DWARFAddressIndex(MemoryBuffer *Buf) : Buffer(Buf) {
+  const char *Data = Buffer->getBufferStart();
+  const DiskHeader *H = reinterpret_cast<const DiskHeader *>(Data);
+  NumEntries = H->NumEntries;
+  Entries = reinterpret_cast<const DiskEntry *>(Data + sizeof(DiskHeader));
+  StringTable = StringRef(Data + sizeof(DiskHeader) +
+                            NumEntries * sizeof(DiskEntry),
+                          H->StringTableSize);
+}
+
+DWARFAddressIndex *DWARFAddressIndex::create(MemoryBuffer *Buffer,
+                                             uint64_t Fingerprint) {
+  OwningPtr<MemoryBuffer> Buf(Buffer);
+  if (Buf->getBufferSize() < sizeof(DiskHeader))
+    return 0;
+  const DiskHeader *H =
+    reinterpret_cast<const DiskHeader *>(Buf->getBufferStart());
+  if (memcmp(H->Magic, IndexMagic, sizeof(H->Magic)) != 0 ||
+      H->Version != IndexVersion || H->Fingerprint != Fingerprint)
+    return 0;
+  uint64_t Size = sizeof(DiskHeader) +
+                  uint64_t(H->NumEntries) * sizeof(DiskEntry) +
+                  H->StringTableSize;
+  if (Size != Buf->getBufferSize())
+    return 0;
+  // The string table must end with a terminator for every string in it to be
+  // terminated.
+  if (H->StringTableSize != 0 && Buf->getBufferEnd()[-1] != '\0')
+    return 0;
+  return new DWARFAddressIndex(Buf.take());
+}
+
+uint32_t DWARFAddressIndex::findEntry(uint64_t Address, uint32_t Hint) const {
+  if (Hint >= NumEntries || getStart(Hint) > Address)
+    Hint = 0;
+  // Find the last entry starting at or before Address.
+  uint32_t Lo = Hint, Hi = NumEntries;
+  while (Lo < Hi) {
+    uint32_t Mid = Lo + (Hi - Lo) / 2;
+    if (getStart(Mid) <= Address)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+  if (Lo == Hint || getStart(Lo - 1) > Address || Address >= getEnd(Lo - 1))
+    return -1U;
+  return Lo - 1;
+}
@@ -0,0 +1,131 @@
+//===-- DWARFAddressIndex.h -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_DWARFADDRESSINDEX_H
+#define LLVM_DEBUGINFO_DWARFADDRESSINDEX_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <vector>
+
+namespace llvm {
+
+class raw_ostream;
+
+/// DWARFAddressIndex - A table of address ranges sorted by address, each with
+/// the line table row, compile unit and function that describe it. The table
+/// is stored in a flat little-endian format that is used in place, so an index
+/// written to disk can be memory mapped and queried without parsing any DWARF.
+class DWARFAddressIndex {
+public:
+  /// Entry - An address range [Start, End) as the index is being built.
+  struct Entry {
+    uint64_t Start;
+    uint64_t End;
+    uint32_t CUOffset;
+    uint32_t Row;
+    uint32_t SubprogramOffset; // -1U if no subprogram covers the range.
+    uint32_t Line;
+    uint32_t Column;
+    // Null if the line table has no valid file for the row.
+    const char *FileName;
+    const char *AbsoluteFileName;
+    const char *FunctionName;   // Null if there is no function name.
+
+    static bool orderByStart(const Entry &LHS, const Entry &RHS) {
+      return LHS.Start < RHS.Start;
+    }
+  };
+
+  /// write - Write an index of Entries to OS. Overlapping entries are
+  /// clipped so that each address belongs to the last entry starting before
+  /// it; of several entries with the same start only the first is kept.
+  /// Fingerprint identifies the debug info the index describes.
+  static void write(raw_ostream &OS, uint64_t Fingerprint,
+                    std::vector<Entry> &Entries);
+
+  /// create - Return an index backed by Buffer, taking ownership of it, if
+  /// it holds an index written for debug info with the given Fingerprint.
+  /// Otherwise delete Buffer and return null.
+  static DWARFAddressIndex *create(MemoryBuffer *Buffer, uint64_t Fingerprint);
+
+  uint32_t getNumEntries() const { return NumEntries; }
+
+  /// findEntry - Return the index of the entry containing Address, or -1U.
+  /// The search starts at entry Hint, so that a sweep over ascending
+  /// addresses only moves forward through the table.
+  uint32_t findEntry(uint64_t Address, uint32_t Hint = 0) const;
+
+  uint64_t getStart(uint32_t I) const { return getDiskEntry(I).Start; }
+  uint64_t getEnd(uint32_t I) const { return getDiskEntry(I).End; }
+  uint32_t getCUOffset(uint32_t I) const { return getDiskEntry(I).CUOffset; }
+  uint32_t getRow(uint32_t I) const { return getDiskEntry(I).Row; }
+  uint32_t getSubprogramOffset(uint32_t I) const {
+    return getDiskEntry(I).SubprogramOffset;
+  }
+  uint32_t getLine(uint32_t I) const { return getDiskEntry(I).Line; }
+  uint32_t getColumn(uint32_t I) const { return getDiskEntry(I).Column; }
+  /// The string accessors return null for a missing string.
+  const char *getFileName(uint32_t I) const {
+    return getString(getDiskEntry(I).FileName);
+  }
+  const char *getAbsoluteFileName(uint32_t I) const {
+    return getString(getDiskEntry(I).AbsoluteFileName);
+  }
+  const char *getFunctionName(uint32_t I) const {
+    return getString(getDiskEntry(I).FunctionName);
+  }
+
+private:
+  struct DiskHeader {
+    char Magic[8];
+    support::ulittle32_t Version;
+    support::ulittle32_t NumEntries;
+    support::ulittle64_t Fingerprint;
+    support::ulittle64_t StringTableSize;
+  };
+
+  struct DiskEntry {
+    support::ulittle64_t Start;
+    support::ulittle64_t End;
+    support::ulittle32_t CUOffset;
+    support::ulittle32_t Row;
+    support::ulittle32_t SubprogramOffset;
+    support::ulittle32_t Line;
+    support::ulittle32_t Column;
+    // Offsets into the string table, -1U for a missing string.
+    support::ulittle32_t FileName;
+    support::ulittle32_t AbsoluteFileName;
+    support::ulittle32_t FunctionName;
+  };
+
+  OwningPtr<MemoryBuffer> Buffer;
+  const DiskEntry *Entries;
+  uint32_t NumEntries;
+  StringRef StringTable;
+
+  explicit DWARFAddressIndex(MemoryBuffer *Buffer);
+
+  const DiskEntry &getDiskEntry(uint32_t I) const {
+    assert(I < NumEntries && "Entry index out of range");
+    return Entries[I];
+  }
+  const char *getString(uint32_t Offset) const {
+    if (Offset >= StringTable.size())
+      return 0;
+    return StringTable.data() + Offset;
+  }
+};
+
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm> // @LOCALMOD
 using namespace llvm;
 using namespace dwarf;
 
@@ -152,6 +153,15 @@ size_t DWARFCompileUnit::extractDIEsIfNeeded(bool cu_die_only) {
   if ((cu_die_only && initial_die_array_size > 0) ||
       initial_die_array_size > 1)
     return 0; // Already parsed
+  // @LOCALMOD-BEGIN
+  // A compile unit DIE without children is the whole compile unit.
+  if (initial_die_array_size == 1) {
+    const DWARFAbbreviationDeclaration *CUAbbrev =
+      DieArray[0].getAbbreviationDeclarationPtr();
+    if (CUAbbrev && !CUAbbrev->hasChildren())
+      return 0;
+  }
+  // @LOCALMOD-END
 
   // Set the offset to that of the first DIE and calculate the start of the
   // next compilation unit header.
@@ -270,3 +280,26 @@ DWARFCompileUnit::getInlinedChainForAddress(uint64_t Address) {
     return DWARFDebugInfoEntryMinimal::InlinedChain();
   return SubprogramDIE->getInlinedChainForAddress(this, Address);
 }
+
+// @LOCALMOD-BEGIN
+namespace {
+  struct DIEOffsetComparator {
+    bool operator()(const DWARFDebugInfoEntryMinimal &LHS,
+                    uint32_t RHS) const {
+      return LHS.getOffset() < RHS;
+    }
+  };
+}
+
+const DWARFDebugInfoEntryMinimal *
+DWARFCompileUnit::getDIEForOffset(uint32_t Offset) {
+  extractDIEsIfNeeded(false);
+  // DIEs are extracted in the order of their offsets.
+  std::vector<DWARFDebugInfoEntryMinimal>::const_iterator I =
+    std::lower_bound(DieArray.begin(), DieArray.end(), Offset,
+                     DIEOffsetComparator());
+  if (I == DieArray.end() || I->getOffset() != Offset)
+    return 0;
+  return &*I;
+}
+// @LOCALMOD-END
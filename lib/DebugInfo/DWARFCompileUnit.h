@@ -129,6 +129,18 @@ public:
 
   void clearDIEs(bool keep_compile_unit_die);
 
+  // @LOCALMOD-BEGIN
+  /// getNumDIEs - Returns the number of DIEs extracted so far.
+  size_t getNumDIEs() const { return DieArray.size(); }
+  const DWARFDebugInfoEntryMinimal &getDIEAtIndex(size_t Index) const {
+    assert(Index < DieArray.size());
+    return DieArray[Index];
+  }
+  /// getDIEForOffset - Returns the DIE at the given offset, extracting all
+  /// DIEs if needed, or null if there is no DIE at that offset.
+  const DWARFDebugInfoEntryMinimal *getDIEForOffset(uint32_t Offset);
+  // @LOCALMOD-END
+
   void buildAddressRangeTable(DWARFDebugAranges *debug_aranges,
                               bool clear_dies_if_already_not_parsed);
 
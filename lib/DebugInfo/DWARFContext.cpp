@@ -8,10 +8,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "DWARFContext.h"
+#include "llvm/ADT/STLExtras.h" // @LOCALMOD
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h" // @LOCALMOD
 #include "llvm/Support/Dwarf.h"
+#include "llvm/Support/FileSystem.h" // @LOCALMOD
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -27,6 +31,7 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
 
   if (DumpType == DIDT_All || DumpType == DIDT_Info) {
     OS << "\n.debug_info contents:\n";
+    extractCompileUnitDIEs(); // @LOCALMOD
     for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i)
       getCompileUnitAtIndex(i)->dump(OS);
   }
@@ -139,6 +144,38 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
   }
 }
 
+// @LOCALMOD-BEGIN
+static void extractAllDIEs(void *Arg) {
+  static_cast<DWARFCompileUnit*>(Arg)->extractDIEsIfNeeded(false);
+}
+
+void DWARFContext::extractCompileUnitDIEs() {
+  // Compile units are extracted lazily when used one at a time.
+  if (NumThreads <= 1 || getNumCompileUnits() <= 1)
+    return;
+  // Each compile unit keeps its DIEs in an array of its own, so the compile
+  // units can be extracted independently.
+  std::vector<void*> CUPtrs(getNumCompileUnits());
+  for (unsigned i = 0, e = CUPtrs.size(); i != e; ++i)
+    CUPtrs[i] = getCompileUnitAtIndex(i);
+  llvm_execute_on_threads(extractAllDIEs, &CUPtrs[0], CUPtrs.size(),
+                          NumThreads);
+}
+
+bool DWARFContext::parseAllDebugInfo() {
+  // Building the aranges may extract and then clear the DIEs of compile
+  // units, so it has to come first.
+  getDebugAranges();
+  extractCompileUnitDIEs();
+  for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i) {
+    DWARFCompileUnit *CU = getCompileUnitAtIndex(i);
+    CU->extractDIEsIfNeeded(false);
+    getLineTableForCompileUnit(CU);
+  }
+  return true;
+}
+// @LOCALMOD-END
+
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrev() {
   if (Abbrev)
     return Abbrev.get();
@@ -337,6 +374,13 @@ static bool getFileLineInfoForCompileUnit(DWARFCompileUnit *CU,
 
 DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
     DILineInfoSpecifier Specifier) {
+  // @LOCALMOD-BEGIN
+  if (AddrIndex) {
+    uint32_t Index = AddrIndex->findEntry(Address);
+    if (Index != -1U)
+      return getLineInfoFromIndex(Index, Specifier);
+  }
+  // @LOCALMOD-END
   DWARFCompileUnit *CU = getCompileUnitForAddress(Address);
   if (!CU)
     return DILineInfo();
@@ -428,12 +472,29 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
 
 DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
     DILineInfoSpecifier Specifier) {
-  DWARFCompileUnit *CU = getCompileUnitForAddress(Address);
-  if (!CU)
-    return DIInliningInfo();
-
-  const DWARFDebugInfoEntryMinimal::InlinedChain &InlinedChain =
-      CU->getInlinedChainForAddress(Address);
+  // @LOCALMOD-BEGIN
+  DWARFCompileUnit *CU = 0;
+  DWARFDebugInfoEntryMinimal::InlinedChain InlinedChain;
+  uint32_t Index = AddrIndex ? AddrIndex->findEntry(Address) : -1U;
+  if (Index != -1U) {
+    // The index knows the subprogram containing the address, so only the
+    // inlined chain below it has to be looked up.
+    uint32_t SubprogramOffset = AddrIndex->getSubprogramOffset(Index);
+    if (SubprogramOffset == -1U)
+      return DIInliningInfo();
+    CU = getCompileUnitForOffset(AddrIndex->getCUOffset(Index));
+    const DWARFDebugInfoEntryMinimal *SubprogramDIE =
+        CU ? CU->getDIEForOffset(SubprogramOffset) : 0;
+    if (!SubprogramDIE)
+      return DIInliningInfo();
+    InlinedChain = SubprogramDIE->getInlinedChainForAddress(CU, Address);
+  } else {
+    CU = getCompileUnitForAddress(Address);
+    if (!CU)
+      return DIInliningInfo();
+    InlinedChain = CU->getInlinedChainForAddress(Address);
+  }
+  // @LOCALMOD-END
   if (InlinedChain.size() == 0)
     return DIInliningInfo();
 
@@ -482,6 +543,364 @@ DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
   return InliningInfo;
 }
 
+// @LOCALMOD-BEGIN
+void DWARFContext::getLineInfoForAddresses(ArrayRef<uint64_t> Addresses,
+                                           SmallVectorImpl<DILineInfo> &Result,
+                                           DILineInfoSpecifier Specifier) {
+  if (!AddrIndex)
+    return DIContext::getLineInfoForAddresses(Addresses, Result, Specifier);
+  // Start each search at the entry found for the previous address, so that
+  // sorted addresses are answered in a single pass over the index.
+  uint32_t Hint = 0;
+  for (unsigned i = 0, e = Addresses.size(); i != e; ++i) {
+    uint32_t Index = AddrIndex->findEntry(Addresses[i], Hint);
+    if (Index == -1U) {
+      Result.push_back(getLineInfoForAddress(Addresses[i], Specifier));
+      continue;
+    }
+    Hint = Index;
+    Result.push_back(getLineInfoFromIndex(Index, Specifier));
+  }
+}
+
+DILineInfo DWARFContext::getLineInfoFromIndex(uint32_t Index,
+    DILineInfoSpecifier Specifier) const {
+  SmallString<16> FileName("<invalid>");
+  SmallString<16> FunctionName("<invalid>");
+  uint32_t Line = 0;
+  uint32_t Column = 0;
+  if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
+    if (const char *Name = AddrIndex->getFunctionName(Index))
+      FunctionName = Name;
+  }
+  if (Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
+    const char *Name =
+        Specifier.needs(DILineInfoSpecifier::AbsoluteFilePath) ?
+        AddrIndex->getAbsoluteFileName(Index) : AddrIndex->getFileName(Index);
+    if (Name) {
+      FileName = Name;
+      Line = AddrIndex->getLine(Index);
+      Column = AddrIndex->getColumn(Index);
+    }
+  }
+  return DILineInfo(FileName, FunctionName, Line, Column);
+}
+
+namespace {
+  /// FingerprintHash - 64-bit FNV-1a hash. Unlike hash_code, its value does
+  /// not depend on the process or the host, so it can be stored in files.
+  class FingerprintHash {
+    uint64_t Value;
+  public:
+    FingerprintHash() : Value(14695981039346656037ULL) {}
+    void add(StringRef Bytes) {
+      for (unsigned i = 0, e = Bytes.size(); i != e; ++i) {
+        Value ^= (unsigned char)Bytes[i];
+        Value *= 1099511628211ULL;
+      }
+    }
+    void add(uint64_t V) {
+      for (unsigned i = 0; i != 8; ++i) {
+        Value ^= (V >> (i * 8)) & 0xff;
+        Value *= 1099511628211ULL;
+      }
+    }
+    uint64_t get() const { return Value; }
+  };
+}
+
+uint64_t DWARFContext::getAddressIndexFingerprint() {
+  StringRef Sections[] = {
+    getInfoSection(), getAbbrevSection(), getARangeSection(),
+    getLineSection(), getStringSection(), getRangeSection()
+  };
+  FingerprintHash Hash;
+  Hash.add(uint64_t(isLittleEndian()));
+  Hash.add(uint64_t(getAddressSize()));
+  Hash.add(uint64_t(infoRelocMap().size()));
+  Hash.add(uint64_t(lineRelocMap().size()));
+  for (unsigned i = 0; i != array_lengthof(Sections); ++i)
+    Hash.add(uint64_t(Sections[i].size()));
+  // The build ID identifies the debug sections when there is one. Otherwise
+  // hash their contents: a file's size and modification time do not change
+  // when it is rewritten with the same size within the same second.
+  StringRef BuildID = getBuildIDSection();
+  if (!BuildID.empty()) {
+    Hash.add(BuildID);
+    return Hash.get();
+  }
+  for (unsigned i = 0; i != array_lengthof(Sections); ++i)
+    Hash.add(Sections[i]);
+  return Hash.get();
+}
+
+namespace {
+  /// SubprogramRange - An address range [Low, High] of the subprogram DIE at
+  /// index DIEIndex of its compile unit. As in addressRangeContainsAddress,
+  /// High belongs to the range.
+  struct SubprogramRange {
+    uint64_t Low;
+    uint64_t High;
+    uint32_t DIEIndex;
+    bool operator<(const SubprogramRange &RHS) const { return Low < RHS.Low; }
+  };
+}
+
+/// getDIEAddressRanges - Append the address ranges of DIE to Ranges in the
+/// form [Low, High], the way addressRangeContainsAddress interprets them.
+static void getDIEAddressRanges(const DWARFCompileUnit *CU,
+                                const DWARFDebugInfoEntryMinimal &DIE,
+                       SmallVectorImpl<std::pair<uint64_t, uint64_t> > &Ranges) {
+  if (DIE.isNULL())
+    return;
+  uint64_t LowPC, HighPC;
+  if (DIE.getLowAndHighPC(CU, LowPC, HighPC)) {
+    if (LowPC <= HighPC)
+      Ranges.push_back(std::make_pair(LowPC, HighPC));
+    return;
+  }
+  uint32_t RangesOffset = DIE.getAttributeValueAsReference(CU, DW_AT_ranges,
+                                                           -1U);
+  DWARFDebugRangeList RangeList;
+  if (RangesOffset == -1U || !CU->extractRangeList(RangesOffset, RangeList))
+    return;
+  unsigned First = Ranges.size();
+  RangeList.getAbsoluteRanges(CU->getBaseAddress(), Ranges);
+  for (unsigned i = First, e = Ranges.size(); i != e; ++i)
+    --Ranges[i].second;
+}
+
+/// addAddressIndexEntries - Append an address index entry to Entries for each
+/// address range of CU over which the answers to address queries do not
+/// change. File names are kept in FileNames.
+static void addAddressIndexEntries(DWARFCompileUnit *CU,
+                                   const DWARFLineTable *LineTable,
+                                   const DWARFDebugAranges *CUAranges,
+                                   ArrayRef<uint64_t> ArangeBounds,
+                                   StringMap<char> &FileNames,
+                         std::vector<DWARFAddressIndex::Entry> &Entries) {
+  if (!LineTable || LineTable->Sequences.empty())
+    return;
+  const bool HadDIEs = CU->getNumDIEs() > 1;
+  CU->extractDIEsIfNeeded(false);
+
+  // The answer to a query changes only at line table rows, at the bounds of
+  // DIE address ranges and at the bounds of .debug_aranges entries, so it is
+  // computed once for each piece between two of these addresses.
+  std::vector<uint64_t> Bounds;
+  uint64_t MinPC = -1ULL, MaxPC = 0;
+  for (unsigned i = 0, e = LineTable->Sequences.size(); i != e; ++i) {
+    MinPC = std::min(MinPC, LineTable->Sequences[i].LowPC);
+    MaxPC = std::max(MaxPC, LineTable->Sequences[i].HighPC);
+  }
+  for (unsigned i = 0, e = LineTable->Rows.size(); i != e; ++i)
+    Bounds.push_back(LineTable->Rows[i].Address);
+  std::vector<SubprogramRange> Subprograms;
+  SmallVector<std::pair<uint64_t, uint64_t>, 4> Ranges;
+  for (unsigned i = 0, e = CU->getNumDIEs(); i != e; ++i) {
+    const DWARFDebugInfoEntryMinimal &DIE = CU->getDIEAtIndex(i);
+    Ranges.clear();
+    getDIEAddressRanges(CU, DIE, Ranges);
+    for (unsigned j = 0, je = Ranges.size(); j != je; ++j) {
+      Bounds.push_back(Ranges[j].first);
+      if (Ranges[j].second != -1ULL)
+        Bounds.push_back(Ranges[j].second + 1);
+      if (DIE.isSubprogramDIE()) {
+        SubprogramRange SR = { Ranges[j].first, Ranges[j].second, i };
+        Subprograms.push_back(SR);
+      }
+    }
+  }
+  Bounds.insert(Bounds.end(),
+                std::lower_bound(ArangeBounds.begin(), ArangeBounds.end(),
+                                 MinPC),
+                std::upper_bound(ArangeBounds.begin(), ArangeBounds.end(),
+                                 MaxPC));
+  std::sort(Bounds.begin(), Bounds.end());
+  Bounds.erase(std::unique(Bounds.begin(), Bounds.end()), Bounds.end());
+  std::stable_sort(Subprograms.begin(), Subprograms.end());
+
+  const uint32_t CUOffset = CU->getOffset();
+  std::vector<SubprogramRange> Active;
+  unsigned NextSubprogram = 0;
+  std::string FileName;
+  for (unsigned i = 0, e = Bounds.size(); i + 1 < e; ++i) {
+    const uint64_t Start = Bounds[i];
+    // Keep track of the subprograms containing Start.
+    for (; NextSubprogram != Subprograms.size() &&
+           Subprograms[NextSubprogram].Low <= Start; ++NextSubprogram)
+      Active.push_back(Subprograms[NextSubprogram]);
+    for (unsigned j = 0; j != Active.size(); )
+      if (Active[j].High < Start) {
+        Active[j] = Active.back();
+        Active.pop_back();
+      } else {
+        ++j;
+      }
+
+    if (CUAranges->findAddress(Start) != CUOffset)
+      continue;
+    uint32_t RowIndex = LineTable->lookupAddress(Start);
+    if (RowIndex == -1U)
+      continue;
+
+    DWARFAddressIndex::Entry Entry;
+    Entry.Start = Start;
+    Entry.End = Bounds[i + 1];
+    Entry.CUOffset = CUOffset;
+    Entry.Row = RowIndex;
+    Entry.SubprogramOffset = -1U;
+    Entry.FunctionName = 0;
+    // Like getInlinedChainForAddress, pick the first subprogram in DIE order.
+    uint32_t SubprogramIndex = -1U;
+    for (unsigned j = 0, je = Active.size(); j != je; ++j)
+      SubprogramIndex = std::min(SubprogramIndex, Active[j].DIEIndex);
+    if (SubprogramIndex != -1U) {
+      const DWARFDebugInfoEntryMinimal &SubprogramDIE =
+          CU->getDIEAtIndex(SubprogramIndex);
+      Entry.SubprogramOffset = SubprogramDIE.getOffset();
+      const DWARFDebugInfoEntryMinimal::InlinedChain &InlinedChain =
+          SubprogramDIE.getInlinedChainForAddress(CU, Start);
+      if (InlinedChain.size() > 0)
+        Entry.FunctionName = InlinedChain[0].getSubroutineName(CU);
+    }
+
+    const DWARFDebugLine::Row &Row = LineTable->Rows[RowIndex];
+    Entry.FileName = Entry.AbsoluteFileName = 0;
+    Entry.Line = Entry.Column = 0;
+    if (getFileNameForCompileUnit(CU, LineTable, Row.File, false, FileName)) {
+      Entry.FileName = FileNames.GetOrCreateValue(FileName).getKeyData();
+      getFileNameForCompileUnit(CU, LineTable, Row.File, true, FileName);
+      Entry.AbsoluteFileName =
+          FileNames.GetOrCreateValue(FileName).getKeyData();
+      Entry.Line = Row.Line;
+      Entry.Column = Row.Column;
+    }
+    Entries.push_back(Entry);
+  }
+
+  if (!HadDIEs)
+    CU->clearDIEs(true);
+}
+
+namespace {
+  /// AddressIndexJob - The address index entries of one compile unit, built
+  /// independently of the other compile units.
+  struct AddressIndexJob {
+    DWARFCompileUnit *CU;
+    StringRef LineSection;
+    const RelocAddrMap *LineRelocMap;
+    bool IsLittleEndian;
+    const DWARFDebugAranges *CUAranges;
+    ArrayRef<uint64_t> ArangeBounds;
+    StringMap<char> FileNames;
+    std::vector<DWARFAddressIndex::Entry> Entries;
+  };
+}
+
+static void buildCompileUnitAddressIndex(void *Arg) {
+  AddressIndexJob &Job = *static_cast<AddressIndexJob*>(Arg);
+  DWARFCompileUnit *CU = Job.CU;
+  // The line table is parsed privately, because the line table cache of the
+  // context is not safe to use from several threads.
+  uint32_t StmtOffset =
+    CU->getCompileUnitDIE()->getAttributeValueAsUnsigned(CU, DW_AT_stmt_list,
+                                                         -1U);
+  if (StmtOffset == -1U)
+    return;
+  DataExtractor LineData(Job.LineSection, Job.IsLittleEndian,
+                         CU->getAddressByteSize());
+  DWARFDebugLine::State LineTable;
+  if (!DWARFDebugLine::parseStatementTable(LineData, Job.LineRelocMap,
+                                           &StmtOffset, LineTable))
+    return;
+  addAddressIndexEntries(CU, &LineTable, Job.CUAranges, Job.ArangeBounds,
+                         Job.FileNames, Job.Entries);
+}
+
+void DWARFContext::buildAddressIndex(raw_ostream &OS, uint64_t Fingerprint) {
+  const DWARFDebugAranges *CUAranges = getDebugAranges();
+  std::vector<uint64_t> ArangeBounds;
+  for (uint32_t i = 0, e = CUAranges->getNumRanges(); i != e; ++i) {
+    const DWARFDebugAranges::Range *R = CUAranges->rangeAtIndex(i);
+    ArangeBounds.push_back(R->LoPC);
+    if (R->HiPC() != -1ULL)
+      ArangeBounds.push_back(R->HiPC());
+  }
+  std::sort(ArangeBounds.begin(), ArangeBounds.end());
+
+  std::vector<DWARFAddressIndex::Entry> Entries;
+  const unsigned NumCUs = getNumCompileUnits();
+  if (NumThreads <= 1 || NumCUs <= 1) {
+    StringMap<char> FileNames;
+    for (unsigned i = 0; i != NumCUs; ++i) {
+      DWARFCompileUnit *CU = getCompileUnitAtIndex(i);
+      addAddressIndexEntries(CU, getLineTableForCompileUnit(CU), CUAranges,
+                             ArangeBounds, FileNames, Entries);
+    }
+    DWARFAddressIndex::write(OS, Fingerprint, Entries);
+    return;
+  }
+
+  // Build the entries of each compile unit in a job of its own and append
+  // them in compile unit order, so that the index does not depend on the
+  // number of threads.
+  std::vector<AddressIndexJob> Jobs(NumCUs);
+  std::vector<void*> JobPtrs(NumCUs);
+  for (unsigned i = 0; i != NumCUs; ++i) {
+    AddressIndexJob &Job = Jobs[i];
+    Job.CU = getCompileUnitAtIndex(i);
+    Job.LineSection = getLineSection();
+    Job.LineRelocMap = &lineRelocMap();
+    Job.IsLittleEndian = isLittleEndian();
+    Job.CUAranges = CUAranges;
+    Job.ArangeBounds = ArangeBounds;
+    JobPtrs[i] = &Job;
+  }
+  llvm_execute_on_threads(buildCompileUnitAddressIndex, &JobPtrs[0], NumCUs,
+                          NumThreads);
+  for (unsigned i = 0; i != NumCUs; ++i)
+    Entries.insert(Entries.end(), Jobs[i].Entries.begin(),
+                   Jobs[i].Entries.end());
+  DWARFAddressIndex::write(OS, Fingerprint, Entries);
+}
+
+bool DWARFContext::useAddressIndex(StringRef CachePath) {
+  const uint64_t Fingerprint = getAddressIndexFingerprint();
+  OwningPtr<MemoryBuffer> Buffer;
+  if (!MemoryBuffer::getFile(CachePath, Buffer, -1, false)) {
+    AddrIndex.reset(DWARFAddressIndex::create(Buffer.take(), Fingerprint));
+    if (AddrIndex)
+      return true;
+  }
+
+  std::string Data;
+  raw_string_ostream OS(Data);
+  buildAddressIndex(OS, Fingerprint);
+  OS.flush();
+
+  // Write the index to a temporary file and rename it into place, so that
+  // other processes never see a partially written index. Failing to cache
+  // the index is not an error.
+  int FD;
+  SmallString<128> TempPath;
+  if (!sys::fs::unique_file(CachePath + "-%%%%%%.tmp", FD, TempPath)) {
+    raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Data;
+    Out.close();
+    bool Existed;
+    if (Out.has_error() || sys::fs::rename(TempPath.str(), CachePath)) {
+      Out.clear_error();
+      sys::fs::remove(TempPath.str(), Existed);
+    }
+  }
+
+  AddrIndex.reset(DWARFAddressIndex::create(
+      MemoryBuffer::getMemBufferCopy(Data, CachePath), Fingerprint));
+  return AddrIndex != 0;
+}
+// @LOCALMOD-END
+
 DWARFContextInMemory::DWARFContextInMemory(object::ObjectFile *Obj) :
   IsLittleEndian(Obj->isLittleEndian()),
   AddressSize(Obj->getBytesInAddress()) {
@@ -524,6 +943,10 @@ DWARFContextInMemory::DWARFContextInMemory(object::ObjectFile *Obj) :
       StringOffsetDWOSection = data;
     else if (name == "debug_addr")
       AddrSection = data;
+    // @LOCALMOD-BEGIN
+    else if (name == "note.gnu.build-id")
+      BuildIDSection = data;
+    // @LOCALMOD-END
     // Any more debug info sections go here.
     else
       continue;
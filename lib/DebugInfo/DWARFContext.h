@@ -10,6 +10,7 @@
 #ifndef LLVM_DEBUGINFO_DWARFCONTEXT_H
 #define LLVM_DEBUGINFO_DWARFCONTEXT_H
 
+#include "DWARFAddressIndex.h" // @LOCALMOD
 #include "DWARFCompileUnit.h"
 #include "DWARFDebugAranges.h"
 #include "DWARFDebugFrame.h"
@@ -31,10 +32,13 @@ class DWARFContext : public DIContext {
   OwningPtr<DWARFDebugAranges> Aranges;
   OwningPtr<DWARFDebugLine> Line;
   OwningPtr<DWARFDebugFrame> DebugFrame;
+  OwningPtr<DWARFAddressIndex> AddrIndex; // @LOCALMOD
 
   SmallVector<DWARFCompileUnit, 1> DWOCUs;
   OwningPtr<DWARFDebugAbbrev> AbbrevDWO;
 
+  unsigned NumThreads; // @LOCALMOD
+
   DWARFContext(DWARFContext &) LLVM_DELETED_FUNCTION;
   DWARFContext &operator=(DWARFContext &) LLVM_DELETED_FUNCTION;
 
@@ -46,9 +50,18 @@ class DWARFContext : public DIContext {
   void parseDWOCompileUnits();
 
 public:
-  DWARFContext() {}
+  DWARFContext() : NumThreads(1) {} // @LOCALMOD
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All);
 
+  // @LOCALMOD-BEGIN
+  virtual void setNumThreads(unsigned N) { NumThreads = N ? N : 1; }
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// Extract the DIEs of all compile units, one compile unit per job on up
+  /// to getNumThreads() threads.
+  void extractCompileUnitDIEs();
+  // @LOCALMOD-END
+
   /// Get the number of compile units in this context.
   unsigned getNumCompileUnits() {
     if (CUs.empty())
@@ -99,6 +112,13 @@ public:
       uint64_t Size, DILineInfoSpecifier Specifier = DILineInfoSpecifier());
   virtual DIInliningInfo getInliningInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier());
+  // @LOCALMOD-BEGIN
+  virtual void getLineInfoForAddresses(ArrayRef<uint64_t> Addresses,
+      SmallVectorImpl<DILineInfo> &Result,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier());
+  virtual bool useAddressIndex(StringRef CachePath);
+  virtual bool parseAllDebugInfo();
+  // @LOCALMOD-END
 
   virtual bool isLittleEndian() const = 0;
   virtual uint8_t getAddressSize() const = 0;
@@ -121,6 +141,7 @@ public:
   virtual StringRef getRangeDWOSection() = 0;
   virtual StringRef getAddrSection() = 0;
   virtual const RelocAddrMap &infoDWORelocMap() const = 0;
+  virtual StringRef getBuildIDSection() = 0; // @LOCALMOD
 
   static bool isSupportedVersion(unsigned version) {
     return version == 2 || version == 3;
@@ -132,6 +153,21 @@ private:
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
+
+  // @LOCALMOD-BEGIN
+  /// Build line info from entry Index of the address index.
+  DILineInfo getLineInfoFromIndex(uint32_t Index,
+                                  DILineInfoSpecifier Specifier) const;
+
+  /// Return a key identifying the debug info the address index is built
+  /// from. It is computed from the build ID, or from the contents of the
+  /// debug sections if there is no build ID, and is stable across runs and
+  /// hosts.
+  uint64_t getAddressIndexFingerprint();
+
+  /// Build the address index of all compile units and write it to OS.
+  void buildAddressIndex(raw_ostream &OS, uint64_t Fingerprint);
+  // @LOCALMOD-END
 };
 
 /// DWARFContextInMemory is the simplest possible implementation of a
@@ -161,6 +197,8 @@ class DWARFContextInMemory : public DWARFContext {
   StringRef RangeDWOSection;
   StringRef AddrSection;
 
+  StringRef BuildIDSection; // @LOCALMOD
+
 public:
   DWARFContextInMemory(object::ObjectFile *);
   virtual bool isLittleEndian() const { return IsLittleEndian; }
@@ -190,6 +228,7 @@ public:
   virtual const RelocAddrMap &infoDWORelocMap() const {
     return InfoDWORelocMap;
   }
+  virtual StringRef getBuildIDSection() { return BuildIDSection; } // @LOCALMOD
 };
 
 }
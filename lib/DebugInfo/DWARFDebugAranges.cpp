@@ -11,6 +11,7 @@
 #include "DWARFCompileUnit.h"
 #include "DWARFContext.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -88,16 +89,54 @@ bool DWARFDebugAranges::extract(DataExtractor debug_aranges_data) {
   return false;
 }
 
+// @LOCALMOD-BEGIN
+namespace {
+  /// ArangesJob - The address ranges of one compile unit, built from its DIEs
+  /// independently of the other compile units.
+  struct ArangesJob {
+    DWARFCompileUnit *CU;
+    DWARFDebugAranges Ranges;
+  };
+}
+
+static void buildCompileUnitAranges(void *Arg) {
+  ArangesJob &Job = *static_cast<ArangesJob*>(Arg);
+  Job.CU->buildAddressRangeTable(&Job.Ranges, true);
+}
+// @LOCALMOD-END
+
 bool DWARFDebugAranges::generate(DWARFContext *ctx) {
   if (ctx) {
+    // @LOCALMOD-BEGIN
+    // Each compile unit is parsed by a job of its own, on as many threads as
+    // the context allows. The ranges are appended in compile unit order, so
+    // the result does not depend on the number of threads.
+    std::vector<DWARFCompileUnit *> CUs;
     const uint32_t num_compile_units = ctx->getNumCompileUnits();
     for (uint32_t cu_idx = 0; cu_idx < num_compile_units; ++cu_idx) {
       if (DWARFCompileUnit *cu = ctx->getCompileUnitAtIndex(cu_idx)) {
         uint32_t CUOffset = cu->getOffset();
         if (ParsedCUOffsets.insert(CUOffset).second)
-          cu->buildAddressRangeTable(this, true);
+          CUs.push_back(cu);
+      }
+    }
+    if (ctx->getNumThreads() <= 1 || CUs.size() <= 1) {
+      for (unsigned i = 0, e = CUs.size(); i != e; ++i)
+        CUs[i]->buildAddressRangeTable(this, true);
+    } else {
+      std::vector<ArangesJob> Jobs(CUs.size());
+      std::vector<void*> JobPtrs(CUs.size());
+      for (unsigned i = 0, e = CUs.size(); i != e; ++i) {
+        Jobs[i].CU = CUs[i];
+        JobPtrs[i] = &Jobs[i];
       }
+      llvm_execute_on_threads(buildCompileUnitAranges, &JobPtrs[0],
+                              JobPtrs.size(), ctx->getNumThreads());
+      for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+        Aranges.insert(Aranges.end(), Jobs[i].Ranges.Aranges.begin(),
+                       Jobs[i].Ranges.Aranges.end());
     }
+    // @LOCALMOD-END
   }
   sort(true, /* overlap size */ 0);
   return !isEmpty();
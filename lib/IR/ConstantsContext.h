@@ -539,6 +539,10 @@ public:
       // Asserts that use_empty().
       delete I->second;
     }
+    // @LOCALMOD-BEGIN
+    Map.clear();
+    InverseMap.clear();
+    // @LOCALMOD-END
   }
     
   /// InsertOrGetItem - Return an iterator for the specified element.
@@ -709,6 +713,7 @@ public:
       // Asserts that use_empty().
       delete I->first;
     }
+    Map.clear(); // @LOCALMOD
   }
 
 private:
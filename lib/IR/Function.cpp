@@ -210,6 +210,23 @@ Function::~Function() {
   clearGC();
 }
 
+// @LOCALMOD-BEGIN
+void Function::releaseBody() {
+  deleteBody();
+
+  if (!hasLazyArguments()) {
+    ArgumentList.clear();
+    setValueSubclassData(getSubclassDataFromValue() | 1);
+  }
+
+  // Only the argument names are left in the table at this point, and those
+  // are gone too now. Replace it to give back the bucket array.
+  assert(SymTab->empty() && "Values still named after deleting the body!");
+  delete SymTab;
+  SymTab = new ValueSymbolTable();
+}
+// @LOCALMOD-END
+
 void Function::BuildLazyArguments() const {
   // Create the arguments vector, all arguments start out unnamed.
   FunctionType *FT = getFunctionType();
@@ -69,6 +69,25 @@ void LLVMContext::removeModule(Module *M) {
   pImpl->OwnedModules.erase(M);
 }
 
+// @LOCALMOD-BEGIN
+void LLVMContext::resetModuleState() {
+  assert(pImpl->OwnedModules.empty() &&
+         "Cannot reset a context that still owns modules!");
+  pImpl->freeConstantsAndMetadata();
+
+  // Struct types cannot be freed, since they are allocated from the type
+  // arena, but their names can be released for the next module.
+  std::vector<StructType*> Named;
+  Named.reserve(pImpl->NamedStructTypes.size());
+  for (StringMap<StructType*>::iterator I = pImpl->NamedStructTypes.begin(),
+       E = pImpl->NamedStructTypes.end(); I != E; ++I)
+    Named.push_back(I->getValue());
+  for (unsigned i = 0, e = Named.size(); i != e; ++i)
+    Named[i]->setName("");
+  pImpl->NamedStructTypesUniqueID = 0;
+}
+// @LOCALMOD-END
+
 //===----------------------------------------------------------------------===//
 // Recoverable Backend Errors
 //===----------------------------------------------------------------------===//
@@ -68,9 +68,39 @@ LLVMContextImpl::~LLVMContextImpl() {
   // iterator invalidation if we iterated on the set directly.
   std::vector<Module*> Modules(OwnedModules.begin(), OwnedModules.end());
   DeleteContainerPointers(Modules);
-  
+
+  // @LOCALMOD-BEGIN
   // Free the constants.  This is important to do here to ensure that they are
   // freed before the LeakDetector is torn down.
+  freeConstantsAndMetadata();
+
+  // Destroy attributes.
+  for (FoldingSetIterator<AttributeImpl> I = AttrsSet.begin(),
+         E = AttrsSet.end(); I != E; ) {
+    FoldingSetIterator<AttributeImpl> Elem = I++;
+    delete &*Elem;
+  }
+
+  // Destroy attribute lists.
+  for (FoldingSetIterator<AttributeSetImpl> I = AttrsLists.begin(),
+         E = AttrsLists.end(); I != E; ) {
+    FoldingSetIterator<AttributeSetImpl> Elem = I++;
+    delete &*Elem;
+  }
+
+  // Destroy attribute node lists.
+  for (FoldingSetIterator<AttributeSetNode> I = AttrsSetNodes.begin(),
+         E = AttrsSetNodes.end(); I != E; ) {
+    FoldingSetIterator<AttributeSetNode> Elem = I++;
+    delete &*Elem;
+  }
+
+  // Destroy MDStrings.
+  DeleteContainerSeconds(MDStringCache);
+}
+
+void LLVMContextImpl::freeConstantsAndMetadata() {
+  // @LOCALMOD-END
   std::for_each(ExprConstants.map_begin(), ExprConstants.map_end(),
                 DropReferences());
   std::for_each(ArrayConstants.map_begin(), ArrayConstants.map_end(),
@@ -94,27 +124,10 @@ LLVMContextImpl::~LLVMContextImpl() {
        E = CDSConstants.end(); I != E; ++I)
     delete I->second;
   CDSConstants.clear();
-
-  // Destroy attributes.
-  for (FoldingSetIterator<AttributeImpl> I = AttrsSet.begin(),
-         E = AttrsSet.end(); I != E; ) {
-    FoldingSetIterator<AttributeImpl> Elem = I++;
-    delete &*Elem;
-  }
-
-  // Destroy attribute lists.
-  for (FoldingSetIterator<AttributeSetImpl> I = AttrsLists.begin(),
-         E = AttrsLists.end(); I != E; ) {
-    FoldingSetIterator<AttributeSetImpl> Elem = I++;
-    delete &*Elem;
-  }
-
-  // Destroy attribute node lists.
-  for (FoldingSetIterator<AttributeSetNode> I = AttrsSetNodes.begin(),
-         E = AttrsSetNodes.end(); I != E; ) {
-    FoldingSetIterator<AttributeSetNode> Elem = I++;
-    delete &*Elem;
-  }
+  // @LOCALMOD-BEGIN
+  TheTrueVal = 0;
+  TheFalseVal = 0;
+  // @LOCALMOD-END
 
   // Destroy MDNodes.  ~MDNode can move and remove nodes between the MDNodeSet
   // and the NonUniquedMDNodes sets, so copy the values out first.
@@ -130,8 +143,13 @@ LLVMContextImpl::~LLVMContextImpl() {
   assert(MDNodeSet.empty() && NonUniquedMDNodes.empty() &&
          "Destroying all MDNodes didn't empty the Context's sets.");
 
-  // Destroy MDStrings.
-  DeleteContainerSeconds(MDStringCache);
+  // @LOCALMOD-BEGIN
+  // The debug location scope records only referred to the nodes just freed.
+  ScopeRecordIdx.clear();
+  ScopeRecords.clear();
+  ScopeInlinedAtIdx.clear();
+  ScopeInlinedAtRecords.clear();
+  // @LOCALMOD-END
 }
 
 // ConstantsContext anchors
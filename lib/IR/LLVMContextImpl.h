@@ -355,6 +355,14 @@ public:
   
   LLVMContextImpl(LLVMContext &C);
   ~LLVMContextImpl();
+
+  // @LOCALMOD-BEGIN
+  /// freeConstantsAndMetadata - Delete every constant and metadata node in
+  /// the context and empty their uniquing tables, keeping the tables'
+  /// storage where the container allows it. Only valid once no module or
+  /// other user references them.
+  void freeConstantsAndMetadata();
+  // @LOCALMOD-END
 };
 
 }
@@ -13,6 +13,7 @@
 
 
 #include "llvm/PassManagers.h"
+#include "llvm/ADT/StringMap.h" // @LOCALMOD
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Module.h"
@@ -20,9 +21,11 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h" // @LOCALMOD
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/PassNameParser.h"
+#include "llvm/Support/Process.h" // @LOCALMOD
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -1299,6 +1302,7 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        PassProfileRegion PassProfile(BP, *I); // @LOCALMOD
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1526,6 +1530,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      PassProfileRegion PassProfile(FP, F); // @LOCALMOD
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1604,6 +1609,7 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      PassProfileRegion PassProfile(MP, M); // @LOCALMOD
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1768,6 +1774,230 @@ Timer *llvm::getPassTimer(Pass *P) {
   return 0;
 }
 
+// @LOCALMOD-BEGIN
+//===----------------------------------------------------------------------===//
+// PassProfiler Class - This class collects the -pass-profile-json report, a
+// machine-readable counterpart of -time-passes that also tracks memory and
+// IR size.
+//
+static cl::opt<std::string>
+PassProfileFile("pass-profile-json", cl::value_desc("filename"),
+                cl::desc("Write per-pass time, memory and instruction count "
+                         "deltas to this file as JSON on exit"));
+
+namespace {
+
+/// PassProfileSample - Totals over one or more runs of a pass.
+struct PassProfileSample {
+  unsigned Runs;
+  double WallTime, UserTime, SystemTime;
+  int64_t MallocDelta;
+  uint64_t PeakRSSDelta;
+  uint64_t InstsBefore, InstsAfter;
+
+  PassProfileSample()
+    : Runs(0), WallTime(0), UserTime(0), SystemTime(0), MallocDelta(0),
+      PeakRSSDelta(0), InstsBefore(0), InstsAfter(0) {}
+
+  void operator+=(const PassProfileSample &RHS) {
+    Runs         += RHS.Runs;
+    WallTime     += RHS.WallTime;
+    UserTime     += RHS.UserTime;
+    SystemTime   += RHS.SystemTime;
+    MallocDelta  += RHS.MallocDelta;
+    PeakRSSDelta += RHS.PeakRSSDelta;
+    InstsBefore  += RHS.InstsBefore;
+    InstsAfter   += RHS.InstsAfter;
+  }
+
+  /// print - Print the sample as the members of a JSON object.
+  void print(raw_ostream &OS) const {
+    OS << "\"runs\": " << Runs
+       << ", \"wall_time\": " << format("%.6f", WallTime)
+       << ", \"user_time\": " << format("%.6f", UserTime)
+       << ", \"system_time\": " << format("%.6f", SystemTime)
+       << ", \"malloc_delta\": " << MallocDelta
+       << ", \"peak_rss_delta\": " << PeakRSSDelta
+       << ", \"insts_before\": " << InstsBefore
+       << ", \"insts_after\": " << InstsAfter;
+  }
+};
+
+/// PassProfileRecord - Everything recorded for one pass instance.
+struct PassProfileRecord {
+  std::string PassName;
+  const char *Kind;
+  PassProfileSample Total;
+  // Per-function totals for passes that run on functions, in first-run order.
+  std::vector<std::pair<std::string, PassProfileSample> > Functions;
+  StringMap<unsigned> FunctionIndex;
+};
+
+class PassProfiler {
+  sys::SmartMutex<true> Lock;
+  DenseMap<Pass*, unsigned> RecordIndex;
+  std::vector<PassProfileRecord*> Records;
+public:
+  ~PassProfiler();
+
+  void addSample(Pass *P, const char *Kind, const Function *F,
+                 const PassProfileSample &S);
+  void print(raw_ostream &OS);
+};
+
+} // End of anon namespace
+
+static ManagedStatic<PassProfiler> ThePassProfiler;
+
+static void printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (StringRef::iterator I = Str.begin(), E = Str.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void PassProfiler::addSample(Pass *P, const char *Kind, const Function *F,
+                             const PassProfileSample &S) {
+  sys::SmartScopedLock<true> Guard(Lock);
+  // Pass managers are created and destroyed repeatedly in the streaming
+  // translator, so a pass pointer may be reused by a different pass.
+  std::pair<DenseMap<Pass*, unsigned>::iterator, bool> Ins =
+    RecordIndex.insert(std::make_pair(P, unsigned(Records.size())));
+  if (!Ins.second && Records[Ins.first->second]->PassName != P->getPassName())
+    Ins.first->second = Records.size();
+  if (Ins.first->second == Records.size()) {
+    PassProfileRecord *R = new PassProfileRecord();
+    R->PassName = P->getPassName();
+    R->Kind = Kind;
+    Records.push_back(R);
+  }
+  PassProfileRecord &R = *Records[Ins.first->second];
+  R.Total += S;
+  if (!F)
+    return;
+
+  StringMapEntry<unsigned> &Entry =
+    R.FunctionIndex.GetOrCreateValue(F->getName(), R.Functions.size());
+  if (Entry.getValue() == R.Functions.size())
+    R.Functions.push_back(std::make_pair(F->getName().str(),
+                                         PassProfileSample()));
+  R.Functions[Entry.getValue()].second += S;
+}
+
+void PassProfiler::print(raw_ostream &OS) {
+  sys::SmartScopedLock<true> Guard(Lock);
+  OS << "{\n  \"passes\": [";
+  for (unsigned i = 0, e = Records.size(); i != e; ++i) {
+    const PassProfileRecord &R = *Records[i];
+    OS << (i ? ",\n" : "\n") << "    {\"name\": ";
+    printJSONString(OS, R.PassName);
+    OS << ", \"kind\": \"" << R.Kind << "\", ";
+    R.Total.print(OS);
+    if (!R.Functions.empty()) {
+      OS << ",\n     \"functions\": [";
+      for (unsigned j = 0, je = R.Functions.size(); j != je; ++j) {
+        OS << (j ? ",\n" : "\n") << "       {\"name\": ";
+        printJSONString(OS, R.Functions[j].first);
+        OS << ", ";
+        R.Functions[j].second.print(OS);
+        OS << '}';
+      }
+      OS << "\n     ]";
+    }
+    OS << '}';
+  }
+  OS << "\n  ]\n}\n";
+}
+
+PassProfiler::~PassProfiler() {
+  std::string ErrorInfo;
+  raw_fd_ostream OS(PassProfileFile.c_str(), ErrorInfo);
+  if (ErrorInfo.empty())
+    print(OS);
+  else
+    errs() << "Error opening pass profile file '" << PassProfileFile
+           << "': " << ErrorInfo << '\n';
+  DeleteContainerPointers(Records);
+}
+
+PassProfileRegion::PassProfileRegion(Pass *ThePass, Module &TheModule)
+  : P(0), M(&TheModule), F(0), BB(0) {
+  if (!PassProfileFile.empty() && !ThePass->getAsPMDataManager()) {
+    P = ThePass;
+    start();
+  }
+}
+
+PassProfileRegion::PassProfileRegion(Pass *ThePass, Function &TheFunction)
+  : P(0), M(0), F(&TheFunction), BB(0) {
+  if (!PassProfileFile.empty() && !ThePass->getAsPMDataManager()) {
+    P = ThePass;
+    start();
+  }
+}
+
+PassProfileRegion::PassProfileRegion(Pass *ThePass, BasicBlock &TheBlock)
+  : P(0), M(0), F(0), BB(&TheBlock) {
+  if (!PassProfileFile.empty() && !ThePass->getAsPMDataManager()) {
+    P = ThePass;
+    start();
+  }
+}
+
+unsigned PassProfileRegion::countInstructions() const {
+  if (BB)
+    return BB->size();
+  unsigned Count = 0;
+  if (F) {
+    for (Function::const_iterator I = F->begin(), E = F->end(); I != E; ++I)
+      Count += I->size();
+    return Count;
+  }
+  for (Module::const_iterator FI = M->begin(), FE = M->end(); FI != FE; ++FI)
+    for (Function::const_iterator I = FI->begin(), E = FI->end(); I != E; ++I)
+      Count += I->size();
+  return Count;
+}
+
+void PassProfileRegion::start() {
+  // Take the time last so that the other measurements are not charged to the
+  // pass.
+  InstsBefore = countInstructions();
+  MallocBefore = sys::Process::GetMallocUsage();
+  PeakRSSBefore = sys::Process::GetPeakResidentSetSize();
+  TimeRecord Now = TimeRecord::getCurrentTime(true);
+  WallBefore = Now.getWallTime();
+  UserBefore = Now.getUserTime();
+  SystemBefore = Now.getSystemTime();
+}
+
+PassProfileRegion::~PassProfileRegion() {
+  if (!P)
+    return;
+  TimeRecord Now = TimeRecord::getCurrentTime(false);
+  PassProfileSample S;
+  S.Runs = 1;
+  S.WallTime = Now.getWallTime() - WallBefore;
+  S.UserTime = Now.getUserTime() - UserBefore;
+  S.SystemTime = Now.getSystemTime() - SystemBefore;
+  S.MallocDelta = int64_t(sys::Process::GetMallocUsage()) -
+                  int64_t(MallocBefore);
+  S.PeakRSSDelta = sys::Process::GetPeakResidentSetSize() - PeakRSSBefore;
+  S.InstsBefore = InstsBefore;
+  S.InstsAfter = countInstructions();
+
+  const char *Kind = M ? "module" : F ? "function" : "basicblock";
+  ThePassProfiler->addSample(P, Kind, F, S);
+}
+// @LOCALMOD-END
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
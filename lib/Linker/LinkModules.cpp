@@ -11,18 +11,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "linker" // @LOCALMOD
 #include "llvm/Linker.h"
 #include "llvm-c/Linker.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h" // @LOCALMOD
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h" // @LOCALMOD
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/TypeFinder.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/InstIterator.h" // @LOCALMOD
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Cloning.h"
@@ -30,6 +34,11 @@
 #include <cctype>
 using namespace llvm;
 
+// @LOCALMOD-BEGIN
+STATISTIC(NumMaterializedBodies,
+          "Number of function bodies read from lazily loaded modules");
+// @LOCALMOD-END
+
 //===----------------------------------------------------------------------===//
 // TypeMap implementation.
 //===----------------------------------------------------------------------===//
@@ -54,7 +63,19 @@ class TypeMapTy : public ValueMapTypeRemapper {
   /// destination modules who are getting a body from the source module.
   SmallPtrSet<StructType*, 16> DstResolvedOpaqueTypes;
 
+  // @LOCALMOD-BEGIN
+  /// DstStructTypesSet - The identified struct types used in the destination
+  /// module. Source structs are merged into the ones with the same body.
+  IdentifiedStructTypeSet &DstStructTypesSet;
+
+  /// VisitingStructs - The named structs whose elements getImpl() is mapping.
+  SmallPtrSet<StructType*, 16> VisitingStructs;
+
 public:
+  explicit TypeMapTy(IdentifiedStructTypeSet &DstStructTypesSet)
+    : DstStructTypesSet(DstStructTypesSet) {}
+  // @LOCALMOD-END
+
   /// addTypeMapping - Indicate that the specified type in the destination
   /// module is conceptually equivalent to the specified type in the source
   /// module.
@@ -222,6 +243,7 @@ void TypeMapTy::linkDefinedTypeBodies() {
       Elements[i] = getImpl(SrcSTy->getElementType(i));
     
     DstSTy->setBody(Elements, SrcSTy->isPacked());
+    DstStructTypesSet.addType(DstSTy); // @LOCALMOD
     
     // If DstSTy has no name or has a longer name than STy, then viciously steal
     // STy's name.
@@ -331,9 +353,40 @@ Type *TypeMapTy::getImpl(Type *Ty) {
   StructType *STy = cast<StructType>(Ty);
   
   // If the type is opaque, we can just use it directly.
-  if (STy->isOpaque())
+  if (STy->isOpaque()) {
+    DstStructTypesSet.addType(STy); // @LOCALMOD
     return *Entry = STy;
-  
+  }
+
+  // @LOCALMOD-BEGIN
+  // Map the elements first. If the destination module already uses a struct
+  // with the mapped body, use that one, and if no element changed the type
+  // itself can be used. This is not possible if the struct is part of a cycle
+  // we are still mapping, since its body is not known yet.
+  if (VisitingStructs.insert(STy)) {
+    bool AnyChange = false;
+    SmallVector<Type*, 8> ElementTypes(STy->getNumElements());
+    for (unsigned i = 0, e = ElementTypes.size(); i != e; ++i) {
+      ElementTypes[i] = getImpl(STy->getElementType(i));
+      AnyChange |= ElementTypes[i] != STy->getElementType(i);
+    }
+    VisitingStructs.erase(STy);
+
+    // If we found our type while recursively processing stuff, just use it.
+    Entry = &MappedTypes[Ty];
+    if (*Entry) return *Entry;
+
+    if (StructType *DTy = DstStructTypesSet.findNonOpaque(ElementTypes,
+                                                          STy->isPacked()))
+      return *Entry = DTy;
+
+    if (!AnyChange) {
+      DstStructTypesSet.addType(STy);
+      return *Entry = STy;
+    }
+  }
+  // @LOCALMOD-END
+
   // Otherwise we create a new type and resolve its body later.  This will be
   // resolved by the top level of get().
   SrcDefinitionsToResolve.push_back(STy);
@@ -351,6 +404,11 @@ namespace {
   /// function, which is the entrypoint for this file.
   class ModuleLinker {
     Module *DstM, *SrcM;
+
+    // @LOCALMOD-BEGIN
+    /// DstStructTypesSet - The identified struct types used in DstM.
+    IdentifiedStructTypeSet &DstStructTypesSet;
+    // @LOCALMOD-END
     
     TypeMapTy TypeMap; 
 
@@ -375,12 +433,28 @@ namespace {
     
     // Vector of functions to lazily link in.
     std::vector<Function*> LazilyLinkFunctions;
+
+    // @LOCALMOD-BEGIN
+    // Position in LazilyLinkFunctions of each lazily linked destination
+    // function whose body has not been queued yet.
+    DenseMap<Function*, unsigned> LazyFunctionIndex;
+
+    // Source functions whose bodies are needed but not yet linked in.
+    SmallVector<Function*, 16> LazyWorklist;
+
+    // Constants already searched for lazily linked functions.
+    SmallPtrSet<const Constant*, 32> VisitedLazyConstants;
+    // @LOCALMOD-END
     
   public:
     std::string ErrorMsg;
     
-    ModuleLinker(Module *dstM, Module *srcM, unsigned mode)
-      : DstM(dstM), SrcM(srcM), Mode(mode) { }
+    // @LOCALMOD-BEGIN
+    ModuleLinker(Module *dstM, Module *srcM, unsigned mode,
+                 IdentifiedStructTypeSet &dstStructTypes)
+      : DstM(dstM), SrcM(srcM), DstStructTypesSet(dstStructTypes),
+        TypeMap(dstStructTypes), Mode(mode) { }
+    // @LOCALMOD-END
     
     bool run();
     
@@ -433,6 +507,10 @@ namespace {
     void linkFunctionBody(Function *Dst, Function *Src);
     void linkAliasBodies();
     void linkNamedMDNodes();
+    // @LOCALMOD-BEGIN
+    void queueLazyFunction(Function *DF);
+    void queueLazyReferences(Constant *C);
+    // @LOCALMOD-END
   };
 }
 
@@ -594,11 +672,6 @@ void ModuleLinker::computeTypeMapping() {
   SmallPtrSet<StructType*, 32> SrcStructTypesSet(SrcStructTypes.begin(),
                                                  SrcStructTypes.end());
 
-  TypeFinder DstStructTypes;
-  DstStructTypes.run(*DstM, true);
-  SmallPtrSet<StructType*, 32> DstStructTypesSet(DstStructTypes.begin(),
-                                                 DstStructTypes.end());
-
   for (unsigned i = 0, e = SrcStructTypes.size(); i != e; ++i) {
     StructType *ST = SrcStructTypes[i];
     if (!ST->hasName()) continue;
@@ -629,7 +702,7 @@ void ModuleLinker::computeTypeMapping() {
       // we prefer to take the '%C' version. So we are then left with both
       // '%C.1' and '%C' being used for the same types. This leads to some
       // variables using one type and some using the other.
-      if (!SrcStructTypesSet.count(DST) && DstStructTypesSet.count(DST))
+      if (!SrcStructTypesSet.count(DST) && DstStructTypesSet.hasType(DST))
         TypeMap.addTypeMapping(DST, ST);
   }
 
@@ -952,6 +1025,35 @@ void ModuleLinker::linkFunctionBody(Function *Dst, Function *Src) {
   
 }
 
+// @LOCALMOD-BEGIN
+/// queueLazyFunction - If DF is a lazily linked function whose body has not
+/// been queued yet, queue its source for linking.
+void ModuleLinker::queueLazyFunction(Function *DF) {
+  DenseMap<Function*, unsigned>::iterator I = LazyFunctionIndex.find(DF);
+  if (I == LazyFunctionIndex.end())
+    return;
+  LazyWorklist.push_back(LazilyLinkFunctions[I->second]);
+  // "Remove" from vector by setting the element to 0.
+  LazilyLinkFunctions[I->second] = 0;
+  LazyFunctionIndex.erase(I);
+}
+
+/// queueLazyReferences - Queue the lazily linked functions that C refers to,
+/// looking through constant expressions and aggregates.
+void ModuleLinker::queueLazyReferences(Constant *C) {
+  if (Function *F = dyn_cast<Function>(C)) {
+    queueLazyFunction(F);
+    return;
+  }
+  if (isa<GlobalValue>(C) || !VisitedLazyConstants.insert(C))
+    return;
+  // A blockaddress also refers to a basic block, which is not a constant.
+  for (User::op_iterator I = C->op_begin(), E = C->op_end(); I != E; ++I)
+    if (Constant *Op = dyn_cast<Constant>(*I))
+      queueLazyReferences(Op);
+}
+// @LOCALMOD-END
+
 /// linkAliasBodies - Insert all of the aliases in Src into the Dest module.
 void ModuleLinker::linkAliasBodies() {
   for (Module::alias_iterator I = SrcM->alias_begin(), E = SrcM->alias_end();
@@ -1226,6 +1328,7 @@ bool ModuleLinker::run() {
         continue;
       if (SF->Materialize(&ErrorMsg))
         return true;
+      ++NumMaterializedBodies; // @LOCALMOD
     }
     
     linkFunctionBody(cast<Function>(ValueMap[SF]), SF);
@@ -1244,43 +1347,51 @@ bool ModuleLinker::run() {
   if (linkModuleFlagsMetadata())
     return true;
 
-  // Process vector of lazily linked in functions.
+  // @LOCALMOD-BEGIN
+  // Process vector of lazily linked in functions. Linking in a body can only
+  // add uses to the functions it refers to, so queue those directly instead
+  // of rescanning the whole vector after every body. Bodies that nothing
+  // refers to are never materialized.
+  for (unsigned i = 0, e = LazilyLinkFunctions.size(); i != e; ++i)
+    LazyFunctionIndex[cast<Function>(ValueMap[LazilyLinkFunctions[i]])] = i;
+
   bool LinkedInAnyFunctions;
   do {
     LinkedInAnyFunctions = false;
-    
-    for(std::vector<Function*>::iterator I = LazilyLinkFunctions.begin(),
-        E = LazilyLinkFunctions.end(); I != E; ++I) {
-      if (!*I)
-        continue;
-      
-      Function *SF = *I;
+
+    for (unsigned i = 0, e = LazilyLinkFunctions.size(); i != e; ++i) {
+      Function *SF = LazilyLinkFunctions[i];
+      if (SF && !cast<Function>(ValueMap[SF])->use_empty())
+        queueLazyFunction(cast<Function>(ValueMap[SF]));
+    }
+
+    while (!LazyWorklist.empty()) {
+      Function *SF = LazyWorklist.pop_back_val();
       Function *DF = cast<Function>(ValueMap[SF]);
-      
-      if (!DF->use_empty()) {
-        
-        // Materialize if necessary.
-        if (SF->isDeclaration()) {
-          if (!SF->isMaterializable())
-            continue;
-          if (SF->Materialize(&ErrorMsg))
-            return true;
-        }
-        
-        // Link in function body.
-        linkFunctionBody(DF, SF);
-        SF->Dematerialize();
 
-        // "Remove" from vector by setting the element to 0.
-        *I = 0;
-        
-        // Set flag to indicate we may have more functions to lazily link in
-        // since we linked in a function.
-        LinkedInAnyFunctions = true;
+      // Materialize if necessary.
+      if (SF->isDeclaration()) {
+        if (!SF->isMaterializable())
+          continue;
+        if (SF->Materialize(&ErrorMsg))
+          return true;
+        ++NumMaterializedBodies;
       }
+
+      // Link in function body.
+      linkFunctionBody(DF, SF);
+      SF->Dematerialize();
+      LinkedInAnyFunctions = true;
+
+      for (inst_iterator I = inst_begin(DF), E = inst_end(DF); I != E; ++I)
+        for (User::op_iterator OI = I->op_begin(), OE = I->op_end();
+             OI != OE; ++OI)
+          if (Constant *C = dyn_cast<Constant>(*OI))
+            queueLazyReferences(C);
     }
   } while (LinkedInAnyFunctions);
-  
+  // @LOCALMOD-END
+
   // Remove any prototypes of functions that were not actually linked in.
   for(std::vector<Function*>::iterator I = LazilyLinkFunctions.begin(),
       E = LazilyLinkFunctions.end(); I != E; ++I) {
@@ -1311,8 +1422,31 @@ bool ModuleLinker::run() {
 /// and shouldn't be relied on to be consistent.
 bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Mode, 
                          std::string *ErrorMsg) {
-  ModuleLinker TheLinker(Dest, Src, Mode);
+  // @LOCALMOD-BEGIN
+  IdentifiedStructTypeSet DstStructTypes;
+  DstStructTypes.addModule(*Dest);
+  ModuleLinker TheLinker(Dest, Src, Mode, DstStructTypes);
+  // @LOCALMOD-END
+  if (TheLinker.run()) {
+    if (ErrorMsg) *ErrorMsg = TheLinker.ErrorMsg;
+    return true;
+  }
+
+  return false;
+}
+
+// @LOCALMOD-BEGIN
+bool Linker::LinkInModule(Module *Src, std::string *ErrorMsg) {
+  if (!CompositeStructTypesValid) {
+    CompositeStructTypes.clear();
+    CompositeStructTypes.addModule(*Composite);
+    CompositeStructTypesValid = true;
+  }
+  ModuleLinker TheLinker(Composite, Src, Linker::DestroySource,
+                         CompositeStructTypes);
   if (TheLinker.run()) {
+    // The composite may be left half linked; collect its types again.
+    CompositeStructTypesValid = false;
     if (ErrorMsg) *ErrorMsg = TheLinker.ErrorMsg;
     return true;
   }
@@ -1320,6 +1454,56 @@ bool Linker::LinkModules(Module *Dest, Module *Src, unsigned Mode,
   return false;
 }
 
+//===----------------------------------------------------------------------===//
+// IdentifiedStructTypeSet implementation.
+//===----------------------------------------------------------------------===//
+
+unsigned IdentifiedStructTypeSet::getBodyHash(ArrayRef<Type*> ElementTypes,
+                                              bool IsPacked) {
+  // Keep clear of the DenseMap empty and tombstone keys.
+  return hash_combine(hash_combine_range(ElementTypes.begin(),
+                                         ElementTypes.end()),
+                      IsPacked) & 0x7fffffff;
+}
+
+void IdentifiedStructTypeSet::addModule(Module &M) {
+  TypeFinder StructTypes;
+  StructTypes.run(M, false);
+  for (TypeFinder::iterator I = StructTypes.begin(), E = StructTypes.end();
+       I != E; ++I)
+    if (!(*I)->isLiteral())
+      addType(*I);
+}
+
+void IdentifiedStructTypeSet::addType(StructType *Ty) {
+  assert(!Ty->isLiteral() && "Only identified structs are tracked");
+  bool &Indexed = Types[Ty];
+  if (Indexed || Ty->isOpaque())
+    return;
+  Indexed = true;
+  ArrayRef<Type*> ElementTypes(Ty->element_begin(), Ty->element_end());
+  NonOpaqueTypes[getBodyHash(ElementTypes, Ty->isPacked())].push_back(Ty);
+}
+
+StructType *
+IdentifiedStructTypeSet::findNonOpaque(ArrayRef<Type*> ElementTypes,
+                                       bool IsPacked) const {
+  DenseMap<unsigned, SmallVector<StructType*, 1> >::const_iterator I =
+    NonOpaqueTypes.find(getBodyHash(ElementTypes, IsPacked));
+  if (I == NonOpaqueTypes.end())
+    return 0;
+  // Only compare the bodies on a hash collision.
+  for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+    StructType *Ty = I->second[i];
+    if (Ty->isPacked() == IsPacked &&
+        ArrayRef<Type*>(Ty->element_begin(), Ty->element_end()) ==
+          ElementTypes)
+      return Ty;
+  }
+  return 0;
+}
+// @LOCALMOD-END
+
 //===----------------------------------------------------------------------===//
 // C API.
 //===----------------------------------------------------------------------===//
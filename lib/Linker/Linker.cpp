@@ -27,6 +27,7 @@ Linker::Linker(StringRef progname, StringRef modname,
   LibPaths(),
   Flags(flags),
   Error(),
+  CompositeStructTypesValid(true), // @LOCALMOD
   ProgramName(progname) { }
 
 Linker::Linker(StringRef progname, Module* aModule, unsigned flags) :
@@ -35,6 +36,7 @@ Linker::Linker(StringRef progname, Module* aModule, unsigned flags) :
   LibPaths(),
   Flags(flags),
   Error(),
+  CompositeStructTypesValid(false), // @LOCALMOD
   ProgramName(progname) { }
 
 Linker::~Linker() {
@@ -86,6 +88,10 @@ Linker::releaseModule() {
   LibPaths.clear();
   Error.clear();
   Composite = 0;
+  // @LOCALMOD-BEGIN
+  CompositeStructTypes.clear();
+  CompositeStructTypesValid = false;
+  // @LOCALMOD-END
   Flags = 0;
   return result;
 }
@@ -28,6 +28,7 @@
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/MC/StringTableBuilder.h" // @LOCALMOD
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -69,6 +70,7 @@ class ELFObjectWriter : public MCObjectWriter {
     struct ELFSymbolData {
       MCSymbolData *SymbolData;
       uint64_t StringIndex;
+      StringRef Name; // @LOCALMOD
       uint32_t SectionIndex;
 
       // Support lexicographic sorting.
@@ -97,7 +99,7 @@ class ELFObjectWriter : public MCObjectWriter {
     /// @name Symbol Table Data
     /// @{
 
-    SmallString<256> StringTable;
+    StringTableBuilder StrTabBuilder; // @LOCALMOD
     std::vector<ELFSymbolData> LocalSymbolData;
     std::vector<ELFSymbolData> ExternalSymbolData;
     std::vector<ELFSymbolData> UndefinedSymbolData;
@@ -230,6 +232,30 @@ class ELFObjectWriter : public MCObjectWriter {
       F.getContents().append(&buf[0], &buf[8]);
     }
 
+    // @LOCALMOD-BEGIN
+    char *Put32(char *Buf, uint32_t Value) {
+      if (isLittleEndian())
+        StringLE32(Buf, Value);
+      else
+        StringBE32(Buf, Value);
+      return Buf + 4;
+    }
+
+    char *Put64(char *Buf, uint64_t Value) {
+      if (isLittleEndian())
+        StringLE64(Buf, Value);
+      else
+        StringBE64(Buf, Value);
+      return Buf + 8;
+    }
+
+    unsigned getRelocationEntrySize() const {
+      if (hasRelocationAddend())
+        return is64Bit() ? sizeof(ELF::Elf64_Rela) : sizeof(ELF::Elf32_Rela);
+      return is64Bit() ? sizeof(ELF::Elf64_Rel) : sizeof(ELF::Elf32_Rel);
+    }
+    // @LOCALMOD-END
+
     void WriteHeader(const MCAssembler &Asm,
                      uint64_t SectionDataSize,
                      unsigned NumberOfSections);
@@ -583,7 +609,7 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
                                     const SectionIndexMapTy &SectionIndexMap) {
   // The string table must be emitted first because we need the index
   // into the string table for all the symbol names.
-  assert(StringTable.size() && "Missing string table");
+  assert(StrTabBuilder.data().size() && "Missing string table"); // @LOCALMOD
 
   // FIXME: Make sure the start of the symbol table is aligned.
 
@@ -876,13 +902,6 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
     MCELF::SetBinding(Data, ELF::STB_GLOBAL);
   }
 
-  // Index 0 is always the empty string.
-  StringMap<uint64_t> StringIndexMap;
-  StringTable += '\x00';
-
-  // FIXME: We could optimize suffixes in strtab in the same way we
-  // optimize them in shstrtab.
-
   // Add the data for the symbols.
   for (MCAssembler::symbol_iterator it = Asm.symbol_begin(),
          ie = Asm.symbol_end(); it != ie; ++it) {
@@ -945,13 +964,7 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
       Name = Buf;
     }
 
-    uint64_t &Entry = StringIndexMap[Name];
-    if (!Entry) {
-      Entry = StringTable.size();
-      StringTable += Name;
-      StringTable += '\x00';
-    }
-    MSD.StringIndex = Entry;
+    MSD.Name = StrTabBuilder.add(Name); // @LOCALMOD
     if (MSD.SectionIndex == ELF::SHN_UNDEF)
       UndefinedSymbolData.push_back(MSD);
     else if (Local)
@@ -960,6 +973,21 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
       ExternalSymbolData.push_back(MSD);
   }
 
+  // @LOCALMOD-BEGIN
+  // Lay out the string table, sharing the tails of names that are suffixes
+  // of other names. Index 0 is always the empty string.
+  StrTabBuilder.finalize();
+  for (unsigned i = 0, e = LocalSymbolData.size(); i != e; ++i)
+    LocalSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(LocalSymbolData[i].Name);
+  for (unsigned i = 0, e = ExternalSymbolData.size(); i != e; ++i)
+    ExternalSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(ExternalSymbolData[i].Name);
+  for (unsigned i = 0, e = UndefinedSymbolData.size(); i != e; ++i)
+    UndefinedSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(UndefinedSymbolData[i].Name);
+  // @LOCALMOD-END
+
   // Symbols are required to be in lexicographic order.
   array_pod_sort(LocalSymbolData.begin(), LocalSymbolData.end());
   array_pod_sort(ExternalSymbolData.begin(), ExternalSymbolData.end());
@@ -999,11 +1027,7 @@ void ELFObjectWriter::CreateRelocationSections(MCAssembler &Asm,
     std::string RelaSectionName = hasRelocationAddend() ? ".rela" : ".rel";
     RelaSectionName += SectionName;
 
-    unsigned EntrySize;
-    if (hasRelocationAddend())
-      EntrySize = is64Bit() ? sizeof(ELF::Elf64_Rela) : sizeof(ELF::Elf32_Rela);
-    else
-      EntrySize = is64Bit() ? sizeof(ELF::Elf64_Rel) : sizeof(ELF::Elf32_Rel);
+    unsigned EntrySize = getRelocationEntrySize(); // @LOCALMOD
 
     const MCSectionELF *RelaSection =
       Ctx.getELFSection(RelaSectionName, hasRelocationAddend() ?
@@ -1029,7 +1053,7 @@ void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
     MCSectionData &RelaSD = Asm.getOrCreateSectionData(*RelaSection);
     RelaSD.setAlignment(is64Bit() ? 8 : 4);
 
-    MCDataFragment *F = new MCDataFragment(&RelaSD);
+    MCDataFragment *F = new (Asm) MCDataFragment(&RelaSD);
     WriteRelocationsFragment(Asm, F, &*it);
   }
 }
@@ -1061,6 +1085,15 @@ void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
   // (e.g., MIPS) have additional constraints.
   TargetObjectWriter->sortRelocs(Asm, Relocs);
 
+  // @LOCALMOD-BEGIN
+  // Size the fragment once and encode the entries straight into it, instead
+  // of appending each field separately.
+  SmallVectorImpl<char> &Contents = F->getContents();
+  size_t Start = Contents.size();
+  Contents.resize(Start + Relocs.size() * getRelocationEntrySize());
+  char *Buf = Contents.data() + Start;
+  // @LOCALMOD-END
+
   for (unsigned i = 0, e = Relocs.size(); i != e; ++i) {
     ELFRelocationEntry entry = Relocs[e - i - 1];
 
@@ -1070,34 +1103,38 @@ void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
       entry.Index = getSymbolIndexInSymbolTable(Asm, entry.Symbol);
     else
       entry.Index += LocalSymbolData.size();
+    // @LOCALMOD-BEGIN
     if (is64Bit()) {
-      String64(*F, entry.r_offset);
+      Buf = Put64(Buf, entry.r_offset);
       if (TargetObjectWriter->isN64()) {
-        String32(*F, entry.Index);
+        Buf = Put32(Buf, entry.Index);
 
-        String8(*F, TargetObjectWriter->getRSsym(entry.Type));
-        String8(*F, TargetObjectWriter->getRType3(entry.Type));
-        String8(*F, TargetObjectWriter->getRType2(entry.Type));
-        String8(*F, TargetObjectWriter->getRType(entry.Type));
+        *Buf++ = TargetObjectWriter->getRSsym(entry.Type);
+        *Buf++ = TargetObjectWriter->getRType3(entry.Type);
+        *Buf++ = TargetObjectWriter->getRType2(entry.Type);
+        *Buf++ = TargetObjectWriter->getRType(entry.Type);
       }
       else {
         struct ELF::Elf64_Rela ERE64;
         ERE64.setSymbolAndType(entry.Index, entry.Type);
-        String64(*F, ERE64.r_info);
+        Buf = Put64(Buf, ERE64.r_info);
       }
       if (hasRelocationAddend())
-        String64(*F, entry.r_addend);
+        Buf = Put64(Buf, entry.r_addend);
     } else {
-      String32(*F, entry.r_offset);
+      Buf = Put32(Buf, entry.r_offset);
 
       struct ELF::Elf32_Rela ERE32;
       ERE32.setSymbolAndType(entry.Index, entry.Type);
-      String32(*F, ERE32.r_info);
+      Buf = Put32(Buf, ERE32.r_info);
 
       if (hasRelocationAddend())
-        String32(*F, entry.r_addend);
+        Buf = Put32(Buf, entry.r_addend);
     }
+    // @LOCALMOD-END
   }
+  assert(Buf == Contents.data() + Contents.size() &&
+         "Relocation entry size mismatch"); // @LOCALMOD
 }
 
 static int compareBySuffix(const void *a, const void *b) {
@@ -1164,17 +1201,20 @@ void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
   StringTableIndex = SectionIndexMap.lookup(StrtabSection);
 
   // Symbol table
-  F = new MCDataFragment(&SymtabSD);
+  F = new (Asm) MCDataFragment(&SymtabSD);
   MCDataFragment *ShndxF = NULL;
   if (NeedsSymtabShndx) {
-    ShndxF = new MCDataFragment(SymtabShndxSD);
+    ShndxF = new (Asm) MCDataFragment(SymtabShndxSD);
   }
   WriteSymbolTable(F, ShndxF, Asm, Layout, SectionIndexMap);
 
-  F = new MCDataFragment(&StrtabSD);
-  F->getContents().append(StringTable.begin(), StringTable.end());
+  F = new (Asm) MCDataFragment(&StrtabSD);
+  // @LOCALMOD-BEGIN
+  StringRef StrTab = StrTabBuilder.data();
+  F->getContents().append(StrTab.begin(), StrTab.end());
+  // @LOCALMOD-END
 
-  F = new MCDataFragment(&ShstrtabSD);
+  F = new (Asm) MCDataFragment(&ShstrtabSD);
 
   std::vector<const MCSectionELF*> Sections;
   for (MCAssembler::const_iterator it = Asm.begin(),
@@ -1243,7 +1283,7 @@ void ELFObjectWriter::CreateIndexedSections(MCAssembler &Asm,
       Group = Ctx.CreateELFGroupSection();
       MCSectionData &Data = Asm.getOrCreateSectionData(*Group);
       Data.setAlignment(4);
-      MCDataFragment *F = new MCDataFragment(&Data);
+      MCDataFragment *F = new (Asm) MCDataFragment(&Data);
       String32(*F, ELF::GRP_COMDAT);
     }
     GroupMap[Group] = SignatureSymbol;
@@ -1261,7 +1301,7 @@ void ELFObjectWriter::CreateIndexedSections(MCAssembler &Asm,
     const MCSectionELF *Group = RevGroupMap[Section.getGroup()];
     MCSectionData &Data = Asm.getOrCreateSectionData(*Group);
     // FIXME: we could use the previous fragment
-    MCDataFragment *F = new MCDataFragment(&Data);
+    MCDataFragment *F = new (Asm) MCDataFragment(&Data);
     unsigned Index = SectionIndexMap.lookup(&Section);
     String32(*F, Index);
   }
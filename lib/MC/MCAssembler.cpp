@@ -9,6 +9,7 @@
 
 #define DEBUG_TYPE "assembler"
 #include "llvm/MC/MCAssembler.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
@@ -24,14 +25,24 @@
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
+// @LOCALMOD-BEGIN
+static cl::opt<unsigned>
+SectionThreads("mc-section-threads", cl::Hidden, cl::init(0),
+  cl::desc("Encode the contents of independent sections on this many "
+           "threads before writing the object file (0 = off)"));
+// @LOCALMOD-END
+
 namespace {
 namespace stats {
 STATISTIC(EmittedFragments, "Number of emitted assembler fragments - total");
@@ -52,6 +63,14 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+// @LOCALMOD-BEGIN
+STATISTIC(FinalRelaxableChecks,
+          "Number of relaxation checks on already final instructions");
+STATISTIC(ReencodedInstructions,
+          "Number of instructions re-encoded after relaxation");
+STATISTIC(ReencodingsAvoided,
+          "Number of relaxation checks reusing the cached encoding");
+// @LOCALMOD-END
 }
 }
 
@@ -287,7 +306,12 @@ void MCAssembler::reset() {
   SymbolMap.clear();
   IndirectSymbols.clear();
   DataRegions.clear();
+  EncodedSectionData.clear();
   ThumbFuncs.clear();
+  // @LOCALMOD-BEGIN
+  // The fragments and symbol data destroyed above were allocated here.
+  Allocator.Reset();
+  // @LOCALMOD-END
   RelaxAll = false;
   NoExecStack = false;
   SubsectionsViaSymbols = false;
@@ -513,9 +537,7 @@ static void writeFragmentContents(const MCFragment &F, MCObjectWriter *OW) {
 
 /// \brief Write the fragment \p F to the output file.
 static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
-                          const MCFragment &F) {
-  MCObjectWriter *OW = &Asm.getWriter();
-
+                          const MCFragment &F, MCObjectWriter *OW) {
   // FIXME: Embed in fragments instead?
   uint64_t FragmentSize = Asm.computeFragmentSize(Layout, F);
 
@@ -701,12 +723,21 @@ void MCAssembler::writeSectionData(const MCSectionData *SD,
     return;
   }
 
+  // @LOCALMOD-BEGIN
+  // Use the bytes encoded up front by encodeSectionsInParallel, if any.
+  // Sections the object writer created afterwards are written directly.
+  if (SD->getOrdinal() < EncodedSectionData.size()) {
+    getWriter().WriteBytes(EncodedSectionData[SD->getOrdinal()]);
+    return;
+  }
+  // @LOCALMOD-END
+
   uint64_t Start = getWriter().getStream().tell();
   (void)Start;
 
   for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
        it != ie; ++it)
-    writeFragment(*this, Layout, *it);
+    writeFragment(*this, Layout, *it, &getWriter());
 
   assert(getWriter().getStream().tell() - Start ==
          Layout.getSectionAddressSize(SD));
@@ -728,6 +759,66 @@ uint64_t MCAssembler::handleFixup(const MCAsmLayout &Layout,
    return FixedValue;
  }
 
+// @LOCALMOD-BEGIN
+namespace {
+struct SectionEncodingJob {
+  const MCAssembler *Asm;
+  const MCAsmLayout *Layout;
+  const MCSectionData *SD;
+  std::string *Contents;
+};
+
+struct LargerSectionFirst {
+  const MCAsmLayout &Layout;
+  explicit LargerSectionFirst(const MCAsmLayout &Layout) : Layout(Layout) {}
+  bool operator()(const SectionEncodingJob &A,
+                  const SectionEncodingJob &B) const {
+    return Layout.getSectionAddressSize(A.SD) >
+           Layout.getSectionAddressSize(B.SD);
+  }
+};
+}
+
+static void encodeSectionJob(void *Arg) {
+  SectionEncodingJob &Job = *static_cast<SectionEncodingJob*>(Arg);
+  raw_string_ostream OS(*Job.Contents);
+  // Each job writes through its own object writer so that nop padding and
+  // fill values get the target's endianness without touching shared state.
+  OwningPtr<MCObjectWriter> OW(Job.Asm->getBackend().createObjectWriter(OS));
+  for (MCSectionData::const_iterator it = Job.SD->begin(),
+         ie = Job.SD->end(); it != ie; ++it)
+    writeFragment(*Job.Asm, *Job.Layout, *it, OW.get());
+  OS.flush();
+  assert(Job.Contents->size() == Job.Layout->getSectionAddressSize(Job.SD));
+}
+
+void MCAssembler::encodeSectionsInParallel(const MCAsmLayout &Layout,
+                                           unsigned NumThreads) {
+  // The layout is final and every fragment is valid, so the layout queries
+  // made while writing fragments are read-only and may run concurrently.
+  EncodedSectionData.assign(size(), std::string());
+  std::vector<SectionEncodingJob> Jobs;
+  for (const_iterator it = begin(), ie = end(); it != ie; ++it) {
+    if (it->getSection().isVirtualSection())
+      continue;
+    SectionEncodingJob Job = { this, &Layout, &*it,
+                               &EncodedSectionData[it->getOrdinal()] };
+    Jobs.push_back(Job);
+  }
+
+  // Hand out the largest sections first so one big .text does not end up
+  // being started last.
+  std::stable_sort(Jobs.begin(), Jobs.end(), LargerSectionFirst(Layout));
+  std::vector<void*> JobPtrs;
+  for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+    JobPtrs.push_back(&Jobs[i]);
+
+  if (!JobPtrs.empty())
+    llvm_execute_on_threads(encodeSectionJob, &JobPtrs[0], JobPtrs.size(),
+                            NumThreads);
+}
+// @LOCALMOD-END
+
 void MCAssembler::Finish() {
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - pre-layout\n--\n";
@@ -742,7 +833,7 @@ void MCAssembler::Finish() {
     // Create dummy fragments to eliminate any empty sections, this simplifies
     // layout.
     if (it->getFragmentList().empty())
-      new MCDataFragment(it);
+      new (*this) MCDataFragment(it); // @LOCALMOD
 
     it->setOrdinal(SectionIndex++);
   }
@@ -797,8 +888,16 @@ void MCAssembler::Finish() {
     }
   }
 
+  // @LOCALMOD-BEGIN
+  // Optionally encode the section contents on several threads. The writer
+  // below still emits the sections in its own, deterministic order.
+  if (SectionThreads > 1)
+    encodeSectionsInParallel(Layout, SectionThreads);
+  // @LOCALMOD-END
+
   // Write the object file.
   getWriter().WriteObject(*this, Layout);
+  EncodedSectionData.clear();
 
   stats::ObjectBytes += OS.tell() - StartOffset;
 }
@@ -820,8 +919,10 @@ bool MCAssembler::fragmentNeedsRelaxation(const MCRelaxableFragment *F,
   // If this inst doesn't ever need relaxation, ignore it. This occurs when we
   // are intentionally pushing out inst fragments, or because we relaxed a
   // previous instruction to one that doesn't need relaxation.
-  if (!getBackend().mayNeedRelaxation(F->getInst()))
+  if (!getBackend().mayNeedRelaxation(F->getInst())) {
+    ++stats::FinalRelaxableChecks; // @LOCALMOD
     return false;
+  }
 
   for (MCRelaxableFragment::const_fixup_iterator it = F->fixup_begin(),
        ie = F->fixup_end(); it != ie; ++it)
@@ -831,10 +932,40 @@ bool MCAssembler::fragmentNeedsRelaxation(const MCRelaxableFragment *F,
   return false;
 }
 
+// @LOCALMOD-BEGIN
+static bool isSameOperand(const MCOperand &A, const MCOperand &B) {
+  if (A.isReg())
+    return B.isReg() && A.getReg() == B.getReg();
+  if (A.isImm())
+    return B.isImm() && A.getImm() == B.getImm();
+  if (A.isFPImm())
+    return B.isFPImm() && A.getFPImm() == B.getFPImm();
+  if (A.isExpr())
+    return B.isExpr() && A.getExpr() == B.getExpr();
+  if (A.isInst())
+    return B.isInst() && A.getInst() == B.getInst();
+  return !B.isValid();
+}
+
+/// isSameInst - Return true if A and B have the same opcode and operands, so
+/// that they also have the same encoding.
+static bool isSameInst(const MCInst &A, const MCInst &B) {
+  if (A.getOpcode() != B.getOpcode() ||
+      A.getNumOperands() != B.getNumOperands())
+    return false;
+  for (unsigned i = 0, e = A.getNumOperands(); i != e; ++i)
+    if (!isSameOperand(A.getOperand(i), B.getOperand(i)))
+      return false;
+  return true;
+}
+// @LOCALMOD-END
+
 bool MCAssembler::relaxInstruction(MCAsmLayout &Layout,
                                    MCRelaxableFragment &F) {
-  if (!fragmentNeedsRelaxation(&F, Layout))
+  if (!fragmentNeedsRelaxation(&F, Layout)) {
+    ++stats::ReencodingsAvoided; // @LOCALMOD
     return false;
+  }
 
   ++stats::RelaxedInstructions;
 
@@ -846,6 +977,16 @@ bool MCAssembler::relaxInstruction(MCAsmLayout &Layout,
   MCInst Relaxed;
   getBackend().relaxInstruction(F.getInst(), Relaxed);
 
+  // @LOCALMOD-BEGIN
+  // The fragment already holds the encoding of its current instruction, so
+  // only run the encoder again if relaxation actually changed it.
+  if (isSameInst(Relaxed, F.getInst())) {
+    ++stats::ReencodingsAvoided;
+    return false;
+  }
+  ++stats::ReencodedInstructions;
+  // @LOCALMOD-END
+
   // Encode the new instruction.
   //
   // FIXME-PERF: If it matters, we could let the target do this. It can
@@ -11,6 +11,7 @@
 #include "llvm/MC/MCELFObjectWriter.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCValue.h"
+#include <algorithm> // @LOCALMOD
 
 using namespace llvm;
 
@@ -43,9 +44,54 @@ void MCELFObjectTargetWriter::adjustFixupOffset(const MCFixup &Fixup,
                                                 uint64_t &RelocOffset) {
 }
 
+// @LOCALMOD-BEGIN
+namespace {
+struct ByDecreasingOffset {
+  bool operator()(const ELFRelocationEntry &A,
+                  const ELFRelocationEntry &B) const {
+    return A < B;
+  }
+};
+}
+
+/// sortRelocsByOffset - Stable sort of Relocs by decreasing r_offset. Large
+/// sections (hundreds of thousands of relocations in big pexes) use an LSD
+/// radix sort on 8-bit digits, skipping the digits that are the same in every
+/// offset; short lists are not worth the extra buffer.
+static void sortRelocsByOffset(std::vector<ELFRelocationEntry> &Relocs) {
+  size_t N = Relocs.size();
+  if (N < 256) {
+    std::stable_sort(Relocs.begin(), Relocs.end(), ByDecreasingOffset());
+    return;
+  }
+
+  uint64_t AnyBits = 0, AllBits = ~0ULL;
+  for (size_t i = 0; i != N; ++i) {
+    AnyBits |= Relocs[i].r_offset;
+    AllBits &= Relocs[i].r_offset;
+  }
+  uint64_t VaryingBits = AnyBits & ~AllBits;
+
+  std::vector<ELFRelocationEntry> Tmp(N);
+  for (unsigned Shift = 0; Shift < 64; Shift += 8) {
+    if (((VaryingBits >> Shift) & 0xff) == 0)
+      continue;
+    // Bucket on the inverted digit so that larger offsets come first.
+    size_t Start[257] = { 0 };
+    for (size_t i = 0; i != N; ++i)
+      ++Start[0xff - ((Relocs[i].r_offset >> Shift) & 0xff) + 1];
+    for (unsigned d = 1; d != 257; ++d)
+      Start[d] += Start[d - 1];
+    for (size_t i = 0; i != N; ++i)
+      Tmp[Start[0xff - ((Relocs[i].r_offset >> Shift) & 0xff)]++] = Relocs[i];
+    Relocs.swap(Tmp);
+  }
+}
+// @LOCALMOD-END
+
 void
 MCELFObjectTargetWriter::sortRelocs(const MCAssembler &Asm,
                                     std::vector<ELFRelocationEntry> &Relocs) {
   // Sort by the r_offset, just like gnu as does.
-  array_pod_sort(Relocs.begin(), Relocs.end());
+  sortRelocsByOffset(Relocs); // @LOCALMOD
 }
@@ -368,6 +368,29 @@ void MCELFStreamer::EmitInstToFragment(const MCInst &Inst) {
     fixSymbolsInTLSFixups(F.getFixups()[i].getValue());
 }
 
+// @LOCALMOD-BEGIN
+/// getBundleAlignedLabelFragment - Return the last fragment of SD if it is an
+/// empty data fragment that only holds labels and directly follows an
+/// alignment to at least the bundle size. An instruction placed there never
+/// needs bundle padding, so the labels keep their addresses and no separate
+/// fragment has to be allocated for the instruction.
+static MCDataFragment *getBundleAlignedLabelFragment(const MCAssembler &Asm,
+                                                     MCSectionData *SD) {
+  if (SD->empty())
+    return 0;
+  MCSectionData::iterator I = SD->end();
+  MCDataFragment *DF = dyn_cast<MCDataFragment>(--I);
+  if (!DF || DF->hasInstructions() || !DF->getContents().empty() ||
+      I == SD->begin())
+    return 0;
+  const MCAlignFragment *AF = dyn_cast<MCAlignFragment>(--I);
+  if (!AF || AF->getAlignment() < Asm.getBundleAlignSize() ||
+      AF->getMaxBytesToEmit() < AF->getAlignment() - 1)
+    return 0;
+  return DF;
+}
+// @LOCALMOD-END
+
 void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
   MCAssembler &Assembler = getAssembler();
   SmallVector<MCFixup, 4> Fixups;
@@ -402,15 +425,23 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
       // If we are bundle-locked, we re-use the current fragment.
       // The bundle-locking directive ensures this is a new data fragment.
       DF = cast<MCDataFragment>(getCurrentFragment());
+    // @LOCALMOD-BEGIN
+    else if (MCDataFragment *LabelDF = SD->isBundleLocked() ? 0 :
+               getBundleAlignedLabelFragment(Assembler, SD))
+      // Reuse the fragment that was created for the labels in front of this
+      // instruction.
+      DF = LabelDF;
+    // @LOCALMOD-END
     else if (!SD->isBundleLocked() && Fixups.size() == 0) {
       // Optimize memory usage by emitting the instruction to a
       // MCCompactEncodedInstFragment when not in a bundle-locked group and
       // there are no fixups registered.
-      MCCompactEncodedInstFragment *CEIF = new MCCompactEncodedInstFragment(SD);
+      MCCompactEncodedInstFragment *CEIF =
+        new (getAssembler()) MCCompactEncodedInstFragment(SD);
       CEIF->getContents().append(Code.begin(), Code.end());
       return;
     } else {
-      DF = new MCDataFragment(SD);
+      DF = new (getAssembler()) MCDataFragment(SD);
       if (SD->getBundleLockState() == MCSectionData::BundleLockedAlignToEnd) {
         // If this is a new fragment created for a bundle-locked group, and the
         // group was marked as "align_to_end", set a flag in the fragment.
@@ -485,9 +516,10 @@ void MCELFStreamer::FinishImpl() {
     const MCSection &Section = Symbol.getSection();
 
     MCSectionData &SectData = getAssembler().getOrCreateSectionData(Section);
-    new MCAlignFragment(ByteAlignment, 0, 1, ByteAlignment, &SectData);
+    new (getAssembler()) MCAlignFragment(ByteAlignment, 0, 1, ByteAlignment,
+                                         &SectData);
 
-    MCFragment *F = new MCFillFragment(0, 0, Size, &SectData);
+    MCFragment *F = new (getAssembler()) MCFillFragment(0, 0, Size, &SectData);
     SD->setFragment(F);
 
     // Update the maximum alignment of the section if necessary.
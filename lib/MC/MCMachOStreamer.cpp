@@ -126,7 +126,7 @@ void MCMachOStreamer::EmitLabel(MCSymbol *Symbol) {
   // We have to create a new fragment if this is an atom defining symbol,
   // fragments cannot span atoms.
   if (getAssembler().isSymbolLinkerVisible(*Symbol))
-    new MCDataFragment(getCurrentSectionData());
+    new (getAssembler()) MCDataFragment(getCurrentSectionData());
 
   MCObjectStreamer::EmitLabel(Symbol);
 
@@ -354,9 +354,10 @@ void MCMachOStreamer::EmitZerofill(const MCSection *Section, MCSymbol *Symbol,
 
   // Emit an align fragment if necessary.
   if (ByteAlignment != 1)
-    new MCAlignFragment(ByteAlignment, 0, 0, ByteAlignment, &SectData);
+    new (getAssembler()) MCAlignFragment(ByteAlignment, 0, 0, ByteAlignment,
+                                         &SectData);
 
-  MCFragment *F = new MCFillFragment(0, 0, Size, &SectData);
+  MCFragment *F = new (getAssembler()) MCFillFragment(0, 0, Size, &SectData);
   SD.setFragment(F);
 
   Symbol->setSection(*Section);
@@ -62,7 +62,7 @@ MCDataFragment *MCObjectStreamer::getOrCreateDataFragment() const {
   // When bundling is enabled, we don't want to add data to a fragment that
   // already has instructions (see MCELFStreamer::EmitInstToData for details)
   if (!F || (Assembler->isBundlingEnabled() && F->hasInstructions()))
-    F = new MCDataFragment(getCurrentSectionData());
+    F = new (*Assembler) MCDataFragment(getCurrentSectionData());
   return F;
 }
 
@@ -124,6 +124,27 @@ void MCObjectStreamer::EmitLabel(MCSymbol *Symbol) {
 
   MCSymbolData &SD = getAssembler().getOrCreateSymbolData(*Symbol);
 
+  // @LOCALMOD-BEGIN
+  // With bundling, every instruction outside a bundle-locked group already
+  // lives in a fragment of its own, so a new data fragment per label would
+  // stay empty and only cost memory. Point the label past the end of the
+  // preceding instruction fragment instead: its size can no longer change,
+  // and since bundle padding is placed at the start of the next fragment,
+  // the label resolves to the same address.
+  if (Assembler->isBundlingEnabled() &&
+      !getCurrentSectionData()->isBundleLocked()) {
+    MCFragment *F = getCurrentFragment();
+    MCDataFragment *DF = dyn_cast_or_null<MCDataFragment>(F);
+    if (F && (isa<MCCompactEncodedInstFragment>(F) ||
+              (DF && DF->hasInstructions()))) {
+      assert(!SD.getFragment() && "Unexpected fragment on symbol data!");
+      SD.setFragment(F);
+      SD.setOffset(cast<MCEncodedFragment>(F)->getContents().size());
+      return;
+    }
+  }
+  // @LOCALMOD-END
+
   // FIXME: This is wasteful, we don't necessarily need to create a data
   // fragment. Instead, we should mark the symbol as pointing into the data
   // fragment if it exists, otherwise we should just queue the label and set its
@@ -145,7 +166,7 @@ void MCObjectStreamer::EmitULEB128Value(const MCExpr *Value) {
     return;
   }
   Value = ForceExpAbs(Value);
-  new MCLEBFragment(*Value, false, getCurrentSectionData());
+  new (getAssembler()) MCLEBFragment(*Value, false, getCurrentSectionData());
 }
 
 void MCObjectStreamer::EmitSLEB128Value(const MCExpr *Value) {
@@ -155,7 +176,7 @@ void MCObjectStreamer::EmitSLEB128Value(const MCExpr *Value) {
     return;
   }
   Value = ForceExpAbs(Value);
-  new MCLEBFragment(*Value, true, getCurrentSectionData());
+  new (getAssembler()) MCLEBFragment(*Value, true, getCurrentSectionData());
 }
 
 void MCObjectStreamer::EmitWeakReference(MCSymbol *Alias,
@@ -224,7 +245,7 @@ void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst) {
   // Always create a new, separate fragment here, because its size can change
   // during relaxation.
   MCRelaxableFragment *IF =
-    new MCRelaxableFragment(Inst, getCurrentSectionData());
+    new (getAssembler()) MCRelaxableFragment(Inst, getCurrentSectionData());
 
   SmallString<128> Code;
   raw_svector_ostream VecOS(Code);
@@ -265,7 +286,8 @@ void MCObjectStreamer::EmitDwarfAdvanceLineAddr(int64_t LineDelta,
     return;
   }
   AddrDelta = ForceExpAbs(AddrDelta);
-  new MCDwarfLineAddrFragment(LineDelta, *AddrDelta, getCurrentSectionData());
+  new (getAssembler()) MCDwarfLineAddrFragment(LineDelta, *AddrDelta,
+                                               getCurrentSectionData());
 }
 
 void MCObjectStreamer::EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
@@ -277,7 +299,8 @@ void MCObjectStreamer::EmitDwarfAdvanceFrameAddr(const MCSymbol *LastLabel,
     return;
   }
   AddrDelta = ForceExpAbs(AddrDelta);
-  new MCDwarfCallFrameFragment(*AddrDelta, getCurrentSectionData());
+  new (getAssembler()) MCDwarfCallFrameFragment(*AddrDelta,
+                                                getCurrentSectionData());
 }
 
 void MCObjectStreamer::EmitBytes(StringRef Data, unsigned AddrSpace) {
@@ -291,8 +314,8 @@ void MCObjectStreamer::EmitValueToAlignment(unsigned ByteAlignment,
                                             unsigned MaxBytesToEmit) {
   if (MaxBytesToEmit == 0)
     MaxBytesToEmit = ByteAlignment;
-  new MCAlignFragment(ByteAlignment, Value, ValueSize, MaxBytesToEmit,
-                      getCurrentSectionData());
+  new (getAssembler()) MCAlignFragment(ByteAlignment, Value, ValueSize,
+                                       MaxBytesToEmit, getCurrentSectionData());
 
   // Update the maximum alignment on the current section if necessary.
   if (ByteAlignment > getCurrentSectionData()->getAlignment())
@@ -309,7 +332,7 @@ bool MCObjectStreamer::EmitValueToOffset(const MCExpr *Offset,
                                          unsigned char Value) {
   int64_t Res;
   if (Offset->EvaluateAsAbsolute(Res, getAssembler())) {
-    new MCOrgFragment(*Offset, Value, getCurrentSectionData());
+    new (getAssembler()) MCOrgFragment(*Offset, Value, getCurrentSectionData());
     return false;
   }
 
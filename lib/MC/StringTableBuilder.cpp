@@ -0,0 +1,93 @@
+//===-- StringTableBuilder.cpp - String table building utility ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/StringTableBuilder.h"
+#include <algorithm>
+
+using namespace llvm;
+
+StringRef StringTableBuilder::add(StringRef s) {
+  assert(!isFinalized());
+  if (s.empty())
+    return s;
+  StringMapEntry<size_t> &Entry = StringIndexMap.GetOrCreateValue(s, 0);
+  if (Entry.getValue() == 0) {
+    // Remember the insertion position (biased by one so that 0 still means
+    // "new") until finalize() replaces it with the real offset.
+    Strings.push_back(&Entry);
+    Entry.setValue(Strings.size());
+  }
+  return Entry.getKey();
+}
+
+/// compareBySuffix - Order strings by their reversed contents, with a string
+/// placed after every other string it is a suffix of. All the strings that
+/// end with a given string S then immediately precede S.
+static bool compareBySuffix(const StringMapEntry<size_t> *A,
+                            const StringMapEntry<size_t> *B) {
+  StringRef NameA = A->getKey();
+  StringRef NameB = B->getKey();
+  size_t SizeA = NameA.size();
+  size_t SizeB = NameB.size();
+  size_t Len = std::min(SizeA, SizeB);
+  for (size_t i = 0; i < Len; ++i) {
+    unsigned char CA = NameA[SizeA - i - 1];
+    unsigned char CB = NameB[SizeB - i - 1];
+    if (CA != CB)
+      return CA < CB;
+  }
+  return SizeA > SizeB;
+}
+
+void StringTableBuilder::finalize() {
+  assert(!isFinalized());
+  size_t NumStrings = Strings.size();
+
+  // Find, for every string, the longest added string it is a suffix of.
+  std::vector<StringMapEntry<size_t> *> Sorted(Strings);
+  std::sort(Sorted.begin(), Sorted.end(), compareBySuffix);
+
+  std::vector<size_t> Root(NumStrings);
+  for (size_t i = 0; i != NumStrings; ++i)
+    Root[i] = i;
+  for (size_t i = 1; i < NumStrings; ++i) {
+    StringMapEntry<size_t> *Prev = Sorted[i - 1];
+    StringMapEntry<size_t> *Cur = Sorted[i];
+    if (Prev->getKey().endswith(Cur->getKey()))
+      Root[Cur->getValue() - 1] = Root[Prev->getValue() - 1];
+  }
+
+  // Lay out the strings that are not a suffix of anything else in insertion
+  // order, then point the suffixes into them.
+  std::vector<size_t> Offsets(NumStrings);
+  StringTable += '\x00';
+  for (size_t i = 0; i != NumStrings; ++i) {
+    if (Root[i] != i)
+      continue;
+    StringRef Name = Strings[i]->getKey();
+    Offsets[i] = StringTable.size();
+    StringTable += Name;
+    StringTable += '\x00';
+  }
+  for (size_t i = 0; i != NumStrings; ++i) {
+    size_t R = Root[i];
+    if (R != i)
+      Offsets[i] = Offsets[R] + Strings[R]->getKey().size() -
+                   Strings[i]->getKey().size();
+  }
+
+  for (size_t i = 0; i != NumStrings; ++i)
+    Strings[i]->setValue(Offsets[i]);
+}
+
+void StringTableBuilder::clear() {
+  StringTable.clear();
+  StringIndexMap.clear();
+  Strings.clear();
+}
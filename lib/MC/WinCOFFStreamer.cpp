@@ -167,9 +167,11 @@ void WinCOFFStreamer::AddCommonSymbol(MCSymbol *Symbol, uint64_t Size,
   Symbol->setSection(*Section);
 
   if (ByteAlignment != 1)
-      new MCAlignFragment(ByteAlignment, 0, 0, ByteAlignment, &SectionData);
+      new (getAssembler()) MCAlignFragment(ByteAlignment, 0, 0, ByteAlignment,
+                                           &SectionData);
 
-  SymbolData.setFragment(new MCFillFragment(0, 0, Size, &SectionData));
+  SymbolData.setFragment(
+    new (getAssembler()) MCFillFragment(0, 0, Size, &SectionData));
 }
 
 // MCStreamer interface
@@ -106,6 +106,13 @@ void Option::addArgument() {
   MarkOptionsChanged();
 }
 
+// @LOCALMOD-BEGIN
+void cl::ResetAllOptionOccurrences() {
+  for (Option *O = RegisteredOptionList; O; O = O->getNextRegisteredOption())
+    O->NumOccurrences = 0;
+}
+// @LOCALMOD-END
+
 
 //===----------------------------------------------------------------------===//
 // Basic, shared command line option processing machinery.
@@ -243,6 +243,24 @@ void FoldingSetImpl::clear() {
   NumNodes = 0;
 }
 
+// @LOCALMOD-BEGIN
+void FoldingSetImpl::clearAndResize(unsigned EltCount) {
+  // Growth keeps at most two nodes per bucket; never go below the default
+  // initial size.
+  unsigned NewNumBuckets = 64;
+  if (EltCount > 2 * NewNumBuckets)
+    NewNumBuckets = unsigned(NextPowerOf2((EltCount - 1) / 2));
+  if (NewNumBuckets == NumBuckets) {
+    clear();
+    return;
+  }
+  free(Buckets);
+  NumBuckets = NewNumBuckets;
+  Buckets = AllocateBuckets(NumBuckets);
+  NumNodes = 0;
+}
+// @LOCALMOD-END
+
 /// GrowHashTable - Double the size of the hash table and rehash everything.
 ///
 void FoldingSetImpl::GrowHashTable() {
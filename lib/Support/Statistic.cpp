@@ -28,6 +28,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
@@ -44,14 +45,51 @@ Enabled("stats", cl::desc("Enable statistics output from program"));
 
 
 namespace {
+// @LOCALMOD-BEGIN
+/// StatisticShard - One copy of the counters, indexed by the slot of each
+/// statistic. Each thread is assigned a shard the first time it bumps a
+/// statistic, and the shards are shared round-robin once there are more
+/// threads than shards, so their memory does not grow with the number of
+/// threads a process has run. Chunks are allocated on first use and never
+/// move, so readers can sum them while other threads keep counting.
+struct StatisticShard {
+  enum { ChunkSize = 256, MaxChunks = 64 };
+  volatile sys::cas_flag *Chunks[MaxChunks];
+
+  StatisticShard() {
+    std::fill(Chunks, Chunks + MaxChunks, (volatile sys::cas_flag *)0);
+  }
+  ~StatisticShard() {
+    for (unsigned i = 0; i != MaxChunks; ++i)
+      delete[] Chunks[i];
+  }
+};
+// @LOCALMOD-END
+
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
 /// on demand (when the first statistic is bumped) and destroyed only when
 /// llvm_shutdown is called.  We print statistics from the destructor.
 class StatisticInfo {
   std::vector<const Statistic*> Stats;
+  // @LOCALMOD-BEGIN
+  std::vector<Statistic*> AllStats;
+  unsigned NumSlots;
+  // @LOCALMOD-END
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  // @LOCALMOD-BEGIN
+  friend class llvm::Statistic;
+  friend void llvm::GetStatistics(std::vector<StatisticSnapshot> &Values);
+  friend void llvm::ResetStatistics();
+  // @LOCALMOD-END
 public:
+  // @LOCALMOD-BEGIN
+  enum { NumShards = 16 };
+  StatisticShard Shards[NumShards];
+  volatile sys::cas_flag NextShard;
+
+  StatisticInfo() : NumSlots(0), NextShard(0) {}
+  // @LOCALMOD-END
   ~StatisticInfo();
 
   void addStatistic(const Statistic *S) {
@@ -62,6 +100,13 @@ public:
 
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
+// @LOCALMOD-BEGIN
+static ManagedStatic<sys::ThreadLocal<const StatisticShard> > CurrentShard;
+/// ShardKey - CurrentShard itself, set when the first statistic registers.
+/// Statistic::add goes through it so that bumping a counter does not pay for
+/// the fence in ManagedStatic's accessors.
+static sys::ThreadLocal<const StatisticShard> *ShardKey;
+// @LOCALMOD-END
 
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
@@ -73,6 +118,17 @@ void Statistic::RegisterStatistic() {
     if (Enabled)
       StatInfo->addStatistic(this);
 
+    // @LOCALMOD-BEGIN
+    // Track every statistic for GetStatistics and ResetStatistics, and give
+    // it a slot in the per-thread shards. If the shards are full, the
+    // statistic is counted atomically in Value instead.
+    StatInfo->AllStats.push_back(this);
+    ShardKey = &*CurrentShard;
+    if (StatInfo->NumSlots <
+        StatisticShard::ChunkSize * StatisticShard::MaxChunks)
+      Slot = ++StatInfo->NumSlots;
+    // @LOCALMOD-END
+
     TsanHappensBefore(this);
     sys::MemoryFence();
     // Remember we have been registered.
@@ -82,6 +138,98 @@ void Statistic::RegisterStatistic() {
   }
 }
 
+// @LOCALMOD-BEGIN
+/// takeCounter - Atomically clear a counter and return its old value.
+static sys::cas_flag takeCounter(volatile sys::cas_flag *Counter) {
+  sys::cas_flag Old;
+  do
+    Old = *Counter;
+  while (sys::CompareAndSwap(Counter, 0, Old) != Old);
+  return Old;
+}
+
+/// getCounter - Return the counter of the given slot in Shard, or null if its
+/// chunk has not been allocated and Create is false.
+static volatile sys::cas_flag *getCounter(StatisticShard &Shard, unsigned Slot,
+                                          bool Create) {
+  unsigned Index = Slot - 1;
+  volatile sys::cas_flag *volatile &Chunk =
+    Shard.Chunks[Index / StatisticShard::ChunkSize];
+  // No fence is needed on this path: the counters are only reached through
+  // the chunk pointer, which is published after they have been cleared.
+  volatile sys::cas_flag *C = Chunk;
+  if (!C) {
+    if (!Create)
+      return 0;
+    // Threads sharing this shard may race to allocate the chunk.
+    sys::SmartScopedLock<true> Writer(*StatLock);
+    C = Chunk;
+    if (!C) {
+      C = new sys::cas_flag[StatisticShard::ChunkSize]();
+      sys::MemoryFence();
+      Chunk = C;
+    }
+  }
+  return C + Index % StatisticShard::ChunkSize;
+}
+
+void Statistic::add(unsigned V) {
+  if (!Slot) {
+    sys::AtomicAdd(&Value, V);
+    return;
+  }
+
+  StatisticShard *Shard = const_cast<StatisticShard*>(ShardKey->get());
+  if (!Shard) {
+    StatisticInfo &Info = *StatInfo;
+    unsigned N = sys::AtomicIncrement(&Info.NextShard) - 1;
+    Shard = &Info.Shards[N % StatisticInfo::NumShards];
+    ShardKey->set(Shard);
+  }
+  sys::AtomicAdd(getCounter(*Shard, Slot, true), V);
+}
+
+sys::cas_flag Statistic::getValue() const {
+  sys::cas_flag Result = Value;
+  if (!Slot)
+    return Result;
+
+  StatisticInfo &Info = *StatInfo;
+  for (unsigned i = 0; i != StatisticInfo::NumShards; ++i)
+    if (volatile sys::cas_flag *Counter = getCounter(Info.Shards[i], Slot,
+                                                     false))
+      Result += *Counter;
+  return Result;
+}
+
+/// takeValue - Atomically clear every copy of S and return their sum. An
+/// update made by another thread meanwhile is either included in the sum or
+/// left in place for the next reader.
+static sys::cas_flag takeValue(Statistic &S) {
+  sys::cas_flag Result = takeCounter(&S.Value);
+  if (!S.Slot)
+    return Result;
+
+  StatisticInfo &Info = *StatInfo;
+  for (unsigned i = 0; i != StatisticInfo::NumShards; ++i)
+    if (volatile sys::cas_flag *Counter = getCounter(Info.Shards[i], S.Slot,
+                                                     false))
+      Result += takeCounter(Counter);
+  return Result;
+}
+
+void Statistic::set(unsigned V) {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  takeValue(*this);
+  sys::AtomicAdd(&Value, V);
+}
+
+void Statistic::scale(unsigned Mul, unsigned Div) {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  sys::AtomicAdd(&Value, takeValue(*this) * Mul / Div);
+}
+// @LOCALMOD-END
+
 namespace {
 
 struct NameCompare {
@@ -141,6 +289,34 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
 }
 
+// @LOCALMOD-BEGIN
+void llvm::GetStatistics(std::vector<StatisticSnapshot> &Values) {
+  std::vector<const Statistic*> Stats;
+  {
+    sys::SmartScopedLock<true> Reader(*StatLock);
+    Stats.assign(StatInfo->AllStats.begin(), StatInfo->AllStats.end());
+  }
+  std::stable_sort(Stats.begin(), Stats.end(), NameCompare());
+
+  Values.clear();
+  for (unsigned i = 0, e = Stats.size(); i != e; ++i) {
+    StatisticSnapshot S;
+    S.Name = Stats[i]->getName();
+    S.Desc = Stats[i]->getDesc();
+    S.Value = Stats[i]->getValue();
+    if (S.Value)
+      Values.push_back(S);
+  }
+}
+
+void llvm::ResetStatistics() {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  StatisticInfo &Info = *StatInfo;
+  for (unsigned i = 0, e = Info.AllStats.size(); i != e; ++i)
+    takeValue(*Info.AllStats[i]);
+}
+// @LOCALMOD-END
+
 void llvm::PrintStatistics() {
   StatisticInfo &Stats = *StatInfo;
 
@@ -102,6 +102,57 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
  error:
   ::pthread_attr_destroy(&Attr);
 }
+
+// @LOCALMOD-BEGIN
+namespace {
+struct WorkQueue {
+  void (*UserFn)(void *);
+  void *const *UserData;
+  unsigned NumItems;
+  volatile sys::cas_flag Next;
+};
+}
+static void *ExecuteWorkQueue_Dispatch(void *Arg) {
+  WorkQueue *WQ = reinterpret_cast<WorkQueue*>(Arg);
+  for (;;) {
+    unsigned Item = sys::AtomicIncrement(&WQ->Next) - 1;
+    if (Item >= WQ->NumItems)
+      break;
+    WQ->UserFn(WQ->UserData[Item]);
+  }
+  return 0;
+}
+
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void *const *UserData,
+                                   unsigned NumItems, unsigned NumThreads) {
+  if (NumThreads > NumItems)
+    NumThreads = NumItems;
+  WorkQueue WQ = { Fn, UserData, NumItems, 0 };
+  // The queue index is only safe to share with real atomics.
+  if (NumThreads <= 1 || LLVM_HAS_ATOMICS == 0) {
+    ExecuteWorkQueue_Dispatch(&WQ);
+    return;
+  }
+
+  // Locks such as the ones guarding statistics and the pass registry only
+  // take effect in multithreaded mode.
+  if (!llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  // The calling thread works on the queue too, so only start the others.
+  // If a thread cannot be created the remaining ones simply take more items.
+  pthread_t *Threads = new pthread_t[NumThreads - 1];
+  unsigned Started = 0;
+  for (; Started != NumThreads - 1; ++Started)
+    if (::pthread_create(&Threads[Started], 0, ExecuteWorkQueue_Dispatch,
+                         &WQ) != 0)
+      break;
+  ExecuteWorkQueue_Dispatch(&WQ);
+  for (unsigned i = 0; i != Started; ++i)
+    ::pthread_join(Threads[i], 0);
+  delete[] Threads;
+}
+// @LOCALMOD-END
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/Windows.h"
 #include <process.h>
@@ -136,6 +187,16 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+// @LOCALMOD-BEGIN
+// FIXME: Spread the items over several threads on Windows as well.
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void *const *UserData,
+                                   unsigned NumItems, unsigned NumThreads) {
+  (void) NumThreads;
+  for (unsigned i = 0; i != NumItems; ++i)
+    Fn(UserData[i]);
+}
+// @LOCALMOD-END
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -144,4 +205,13 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+// @LOCALMOD-BEGIN
+void llvm::llvm_execute_on_threads(void (*Fn)(void*), void *const *UserData,
+                                   unsigned NumItems, unsigned NumThreads) {
+  (void) NumThreads;
+  for (unsigned i = 0; i != NumItems; ++i)
+    Fn(UserData[i]);
+}
+// @LOCALMOD-END
+
 #endif
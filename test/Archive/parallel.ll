@@ -0,0 +1,39 @@
+; RUN: rm -rf %t && mkdir -p %t/in %t/out
+; RUN: llvm-as %s -o %t/in/a.bc
+; RUN: cp %t/in/a.bc %t/in/b.bc
+; RUN: cp %S/oddlen %t/in/oddlen
+; RUN: cd %t/in
+; RUN: llvm-ar rcs -j1 %t/j1.a a.bc oddlen b.bc
+; RUN: llvm-ar rcs -j4 %t/j4.a a.bc oddlen b.bc
+; RUN: llvm-ar tV %t/j1.a > %t/j1.txt
+; RUN: llvm-ar tV %t/j4.a > %t/j4.txt
+; RUN: diff %t/j1.txt %t/j4.txt
+; RUN: FileCheck %s < %t/j4.txt
+; RUN: cd %t/out
+; RUN: llvm-ar x -j4 %t/j4.a
+; RUN: cmp %t/in/a.bc a.bc
+; RUN: cmp %t/in/oddlen oddlen
+; RUN: cmp %t/in/b.bc b.bc
+; RUN: cd %t/in
+; RUN: echo first > dup
+; RUN: llvm-ar q %t/dup.a dup oddlen
+; RUN: echo second > dup
+; RUN: llvm-ar q %t/dup.a dup
+; RUN: rm -rf %t/out && mkdir %t/out && cd %t/out
+; RUN: llvm-ar x -j4 %t/dup.a
+; RUN: cmp %t/in/dup dup
+
+; With -j, bitcode members are scanned for symbols concurrently, but the
+; archive lists the same symbols as without it: a symbol defined by several
+; members refers to the first of them. When several members have the same
+; path, the last one is extracted, as without -j.
+
+; CHECK: Archive Symbol Table:
+; CHECK-NEXT: {{ +}}[[OFF:[0-9]+]]{{.}}defined
+; CHECK-NEXT: {{ +}}[[OFF]]{{.}}global
+
+@global = global i32 1
+
+define void @defined() {
+  ret void
+}
@@ -0,0 +1,37 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: rm -f %t.a
+; RUN: llvm-ar rcs %t.a %t.bc
+; RUN: FileCheck %s -check-prefix=RAW < %t.a
+; RUN: llvm-ar tV %t.a | FileCheck %s
+
+; llvm-ar s writes a hashed symbol index right after the symbol table, so that
+; readers that do not know the index still find the symbol table first. The
+; index is not listed as a member, and both list the externally visible
+; definitions.
+
+; RAW: #_LLVM_SYM_TAB_#
+; RAW: #_LLVM_SYM_IDX_#
+
+; CHECK-NOT: #_LLVM_SYM
+; CHECK: symbol-index.ll.tmp.bc
+; CHECK: Archive Symbol Table:
+; CHECK-NOT: internal
+; CHECK-NOT: external
+; CHECK: defined
+; CHECK: global
+; CHECK-NOT: internal
+; CHECK-NOT: external
+
+@global = global i32 1
+
+declare void @external()
+
+define internal void @internal() {
+  ret void
+}
+
+define void @defined() {
+  call void @internal()
+  call void @external()
+  ret void
+}
@@ -0,0 +1,54 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -enable-misched \
+; RUN:   -codegen-budget-exhausted -stats 2>&1 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -enable-misched \
+; RUN:   -codegen-budget-exhausted -o - | FileCheck %s -check-prefix=ASM
+; REQUIRES: asserts
+
+; Once a function's code generation budget is used up, isel selects blocks
+; like at -O0, the machine scheduler leaves regions alone and the greedy
+; allocator spills instead of splitting. The code is still complete.
+
+; CHECK: Number of functions that exceeded the code generation budget
+; CHECK: Number of blocks selected like at -O0 because of the code generation budget
+; CHECK: Number of regions left unscheduled because of the code generation budget
+; CHECK: Number of ranges spilled without splitting because of the code generation budget
+
+; ASM: pressure:
+; ASM: callq use
+; ASM: ret
+
+declare void @use(i32, i32, i32, i32, i32, i32)
+
+define i32 @pressure(i32* %p) {
+entry:
+  %p1 = getelementptr i32* %p, i32 1
+  %p2 = getelementptr i32* %p, i32 2
+  %p3 = getelementptr i32* %p, i32 3
+  %p4 = getelementptr i32* %p, i32 4
+  %p5 = getelementptr i32* %p, i32 5
+  %p6 = getelementptr i32* %p, i32 6
+  %p7 = getelementptr i32* %p, i32 7
+  %a0 = load i32* %p
+  %a1 = load i32* %p1
+  %a2 = load i32* %p2
+  %a3 = load i32* %p3
+  %a4 = load i32* %p4
+  %a5 = load i32* %p5
+  %a6 = load i32* %p6
+  %a7 = load i32* %p7
+  call void @use(i32 %a0, i32 %a1, i32 %a2, i32 %a3, i32 %a4, i32 %a5)
+  %s0 = add i32 %a0, %a1
+  %s1 = mul i32 %a2, %a3
+  %s2 = xor i32 %a4, %a5
+  %s3 = sub i32 %a6, %a7
+  br label %next
+
+next:
+  call void @use(i32 %s0, i32 %s1, i32 %s2, i32 %s3, i32 %a6, i32 %a7)
+  %t0 = add i32 %s0, %s1
+  %t1 = add i32 %s2, %s3
+  %t2 = mul i32 %t0, %t1
+  %t3 = add i32 %t2, %a0
+  %t4 = add i32 %t3, %a7
+  ret i32 %t4
+}
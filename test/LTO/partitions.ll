@@ -0,0 +1,89 @@
+; RUN: llvm-as %s -o %t.bc
+; RUN: llvm-lto -partitions=2 -exported-symbol=entry -exported-symbol=other \
+; RUN:   -exported-symbol=entry_alias -exported-symbol=table -o %t.a %t.bc
+; RUN: llvm-nm %t.a.0 | FileCheck -check-prefix=A0 %s
+; RUN: llvm-nm %t.a.1 | FileCheck -check-prefix=A1 %s
+; RUN: not ls %t.a.2
+; RUN: llvm-lto -partitions=4 -exported-symbol=entry -exported-symbol=other \
+; RUN:   -exported-symbol=entry_alias -exported-symbol=table -o %t.b %t.bc
+; RUN: llvm-nm %t.b.0 | FileCheck -check-prefix=B0 %s
+; RUN: llvm-nm %t.b.1 | FileCheck -check-prefix=B1 %s
+; RUN: llvm-nm %t.b.2 | FileCheck -check-prefix=B2 %s
+; RUN: llvm-nm %t.b.3 | FileCheck -check-prefix=B3 %s
+; RUN: llvm-lto -partitions=4 -exported-symbol=entry -exported-symbol=other \
+; RUN:   -exported-symbol=entry_alias -exported-symbol=table -o %t.c %t.bc
+; RUN: cmp %t.b.0 %t.c.0
+; RUN: cmp %t.b.1 %t.c.1
+; RUN: cmp %t.b.2 %t.c.2
+; RUN: cmp %t.b.3 %t.c.3
+
+; lto_codegen_compile_to_files generates one object per partition. Functions
+; follow their callers, globals go with their first user and aliases with
+; their aliasee. Local symbols used from another partition become global
+; ".lto_priv" symbols. The objects are the same from run to run.
+
+; A0: T bump.lto_priv
+; A0: b counter
+; A0: T entry
+; A0: T entry_alias
+; A0: t leaf1
+; A0: D table
+; A1: U bump.lto_priv
+; A1: t leaf2
+; A1: T other
+
+; B0: T bump.lto_priv
+; B0: T entry
+; B0: T entry_alias
+; B0: U leaf1.lto_priv
+; B1: T leaf1.lto_priv
+; B1: D table
+; B2: U bump.lto_priv
+; B2: U leaf2.lto_priv
+; B2: T other
+; B3: T leaf2.lto_priv
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+@counter = internal global i32 0
+@table = global [2 x i32] [i32 1, i32 2]
+
+@entry_alias = alias i32 (i32)* @entry
+
+define internal i32 @bump(i32 %x) noinline {
+  %c = load volatile i32* @counter
+  %n = add i32 %c, %x
+  store volatile i32 %n, i32* @counter
+  ret i32 %n
+}
+
+define i32 @entry(i32 %x) noinline {
+  %a = call i32 @bump(i32 %x)
+  %b = call i32 @leaf1(i32 %a)
+  ret i32 %b
+}
+
+define i32 @leaf1(i32 %x) noinline {
+  %p = getelementptr [2 x i32]* @table, i32 0, i32 1
+  %t = load volatile i32* %p
+  %r = mul i32 %x, %t
+  %s = add i32 %r, 7
+  %u = xor i32 %s, %x
+  ret i32 %u
+}
+
+define i32 @other(i32 %x) noinline {
+  %a = call i32 @bump(i32 %x)
+  %b = call i32 @leaf2(i32 %a)
+  %c = mul i32 %b, %b
+  %d = add i32 %c, %a
+  ret i32 %d
+}
+
+define i32 @leaf2(i32 %x) noinline {
+  %r = sub i32 %x, 3
+  %s = shl i32 %r, 2
+  %t = or i32 %s, 1
+  ret i32 %t
+}
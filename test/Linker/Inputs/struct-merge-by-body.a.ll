@@ -0,0 +1,2 @@
+%A = type { i32, i8* }
+@a = global %A* null
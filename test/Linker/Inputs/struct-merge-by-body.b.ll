@@ -0,0 +1,2 @@
+%B = type { i32, i8* }
+@b = global %B* null
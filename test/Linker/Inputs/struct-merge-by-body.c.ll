@@ -0,0 +1,4 @@
+%C = type { i32, i8* }
+%D = type { i32, i16 }
+@c = global %C* null
+@d = global %D* null
@@ -0,0 +1,30 @@
+; REQUIRES: asserts
+; RUN: llvm-as %p/lazy-load-b.ll -o %t.b.bc
+; RUN: llvm-link -lazy %s %t.b.bc -S -o - | FileCheck %s
+; RUN: llvm-link %s %t.b.bc -S -o %t.plain.ll
+; RUN: llvm-link -lazy %s %t.b.bc -S -o %t.lazy.ll
+; RUN: diff %t.plain.ll %t.lazy.ll
+; RUN: llvm-link -lazy %s %t.b.bc -o /dev/null -stats 2>&1 \
+; RUN:   | FileCheck -check-prefix=STATS %s
+
+; Bodies of the lazily loaded module are only read for the functions that
+; end up in the output: five of its seven bodies. @unused and @dead are never
+; read.
+
+; STATS: 5 linker - Number of function bodies read from lazily loaded modules
+
+; CHECK: define i32 @main()
+; CHECK: define i32 @entry(i32 %x)
+; CHECK: define linkonce_odr i32 @chain0(i32 %x)
+; CHECK: define linkonce_odr i32 @chain1(i32 %x)
+; CHECK: define internal i32 @chain2(i32 %x)
+; CHECK: define linkonce_odr i32 @viaconst()
+; CHECK-NOT: @unused
+; CHECK-NOT: @dead
+
+define i32 @main() {
+  %r = call i32 @entry(i32 1)
+  ret i32 %r
+}
+
+declare i32 @entry(i32)
@@ -0,0 +1,36 @@
+; This file is for use with lazy-load-a.ll
+; RUN: true
+
+define i32 @entry(i32 %x) {
+  %r = call i32 @chain0(i32 %x)
+  ret i32 %r
+}
+
+define linkonce_odr i32 @chain0(i32 %x) {
+  %r = call i32 @chain1(i32 %x)
+  ret i32 %r
+}
+
+define linkonce_odr i32 @chain1(i32 %x) {
+  %f = bitcast i32 ()* @viaconst to i32 (i32)*
+  %r = call i32 @chain2(i32 %x)
+  %s = call i32 %f(i32 %r)
+  ret i32 %s
+}
+
+define internal i32 @chain2(i32 %x) {
+  ret i32 %x
+}
+
+define linkonce_odr i32 @viaconst() {
+  ret i32 0
+}
+
+define linkonce_odr i32 @unused(i32 %x) {
+  %r = call i32 @dead(i32 %x)
+  ret i32 %r
+}
+
+define internal i32 @dead(i32 %x) {
+  ret i32 %x
+}
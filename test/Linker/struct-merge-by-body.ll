@@ -0,0 +1,14 @@
+; Identified structs with the same body are merged even when their names
+; differ, including when the destination was built by earlier links.
+; RUN: llvm-link %S/Inputs/struct-merge-by-body.a.ll \
+; RUN:   %S/Inputs/struct-merge-by-body.b.ll \
+; RUN:   %S/Inputs/struct-merge-by-body.c.ll -S | FileCheck %s
+
+; CHECK: %A = type { i32, i8* }
+; CHECK-NOT: type { i32, i8* }
+; CHECK: %D = type { i32, i16 }
+; CHECK-NOT: type
+; CHECK: @a = global %A* null
+; CHECK: @b = global %A* null
+; CHECK: @c = global %A* null
+; CHECK: @d = global %D* null
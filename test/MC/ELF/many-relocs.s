@@ -0,0 +1,20 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - | elf-dump | FileCheck %s
+
+// Test that a section with enough relocations to take the radix sort path
+// still gets them in increasing r_offset order.
+
+        .data
+        .rept 300
+        .long foo
+        .endr
+
+// CHECK:      # Relocation 0
+// CHECK-NEXT: (('r_offset', 0x0000000000000000)
+// CHECK:      # Relocation 1
+// CHECK-NEXT: (('r_offset', 0x0000000000000004)
+// CHECK:      # Relocation 255
+// CHECK-NEXT: (('r_offset', 0x00000000000003fc)
+// CHECK:      # Relocation 256
+// CHECK-NEXT: (('r_offset', 0x0000000000000400)
+// CHECK:      # Relocation 299
+// CHECK-NEXT: (('r_offset', 0x00000000000004ac)
@@ -82,7 +82,7 @@ foo:
 
 // Symbol number 2 is foo
 // CHECK:      # Symbol 2
-// CHECK-NEXT: (('st_name', 0x00000007) # 'foo'
+// CHECK-NEXT: (('st_name', 0x00000003) # 'foo'
 
 // Symbol number 6 is section 5
 // CHECK:        # Symbol 6
@@ -94,4 +94,4 @@ foo:
 
 // Symbol number 8 is zed
 // CHECK:        # Symbol 8
-// CHECK-NEXT:    (('st_name', 0x0000000b) # 'zed'
+// CHECK-NEXT:    (('st_name', 0x00000007) # 'zed'
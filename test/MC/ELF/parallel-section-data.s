@@ -0,0 +1,30 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.serial
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.parallel \
+// RUN:   -mc-section-threads=4
+// RUN: cmp %t.serial %t.parallel
+
+// Encoding the sections on several threads must not change the object.
+    .text
+f0:
+    movl $1, %eax
+    .align  16, 0x90
+f1:
+    callq f0
+    .bundle_align_mode 5
+    .bundle_lock
+    andl $-32, %eax
+    jmpq *%rax
+    .bundle_unlock
+
+    .data
+d0:
+    .long f0
+    .quad f1
+    .fill 12, 2, 0x1234
+    .align 8
+
+    .section .rodata,"a",@progbits
+    .asciz "hello"
+
+    .bss
+    .zero 64
@@ -0,0 +1,34 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+// RUN:   | llvm-objdump -d - | FileCheck %s
+
+// Fragments come from the assembler's arena. Switching sections splits the
+// text into several fragments; the jumps that do not fit in a byte must
+// still be relaxed and every later fragment moved accordingly.
+
+    .text
+a:
+    jmp c
+    .data
+    .quad a
+    .text
+b:
+    jne a
+    .fill 200, 1, 0x90
+    .align 16, 0x90
+c:
+    jmp b
+    .data
+    .quad c
+    .text
+    .org 0x100, 0xcc
+d:
+    jmp a
+    jmp d
+
+// CHECK:        0: e9 cb 00 00 00  jmpq 203
+// CHECK-NEXT:   5: 75 f9           jne -7
+// CHECK:       cf: 90              nop
+// CHECK-NEXT:  d0: e9 30 ff ff ff  jmpq -208
+// CHECK-NEXT:  d5: cc              int3
+// CHECK:      100: e9 fb fe ff ff  jmpq -261
+// CHECK-NEXT: 105: eb f9           jmp -7
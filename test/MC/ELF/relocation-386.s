@@ -182,7 +182,7 @@
 
 // Symbol 4 is zed
 // CHECK:      # Symbol 4
-// CHECK-NEXT: (('st_name', 0x00000035) # 'zed'
+// CHECK-NEXT: (('st_name', 0x00000031) # 'zed'
 // CHECK-NEXT:  ('st_value', 0x00000000)
 // CHECK-NEXT:  ('st_size', 0x00000000)
 // CHECK-NEXT:  ('st_bind', 0x0)
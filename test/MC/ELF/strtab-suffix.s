@@ -0,0 +1,19 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - | elf-dump --dump-section-data | FileCheck %s
+
+// Test that a symbol name that is a suffix of another one shares its tail in
+// .strtab instead of being stored again.
+
+        .globl  foobar
+        .globl  bar
+foobar:
+bar:
+        nop
+
+// CHECK:      ('_symbols', [
+// CHECK:      (('st_name', 0x00000004) # 'bar'
+// CHECK:      (('st_name', 0x00000001) # 'foobar'
+
+// CHECK:      ('sh_name', 0x{{[0-9a-f]+}}) # '.strtab'
+// CHECK-NEXT: ('sh_type', 0x00000003)
+// CHECK:      ('sh_size', 0x0000000000000008)
+// CHECK:      ('_section_data', '00666f6f 62617200')
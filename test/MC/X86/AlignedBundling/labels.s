@@ -0,0 +1,43 @@
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+# RUN:   | llvm-objdump -disassemble -no-show-raw-insn - | FileCheck %s
+# RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+# RUN:   | llvm-objdump -t - | FileCheck -check-prefix=SYM %s
+
+# Labels between bundled instructions resolve to the end of the preceding
+# instruction, before any padding of the next one. A label after an
+# alignment to the bundle size shares its fragment with the next instruction.
+
+  .text
+  .bundle_align_mode 4
+foo:
+  callq   bar
+after_call:
+  movl    %eax, %ebx
+after_mov:
+  callq   bar
+before_pad:
+  callq   bar
+# CHECK:       7: callq
+# CHECK-NEXT:  c: nop
+# CHECK:      10: callq
+  .align 16
+aligned:
+  movl    %ebx, %eax
+  callq   bar
+# CHECK:      20: movl
+# CHECK-NEXT: 22: callq
+  .align 16, 0x90, 4
+partly_aligned:
+  callq   bar
+  callq   bar
+# An alignment that may skip its padding does not let the instruction reuse
+# the label's fragment.
+# CHECK:      27: callq
+# CHECK-NEXT: 2c: nop
+# CHECK:      30: callq
+
+# SYM: 0000000000000005 {{.*}}.text {{.*}}after_call
+# SYM: 0000000000000007 {{.*}}.text {{.*}}after_mov
+# SYM: 0000000000000020 {{.*}}.text {{.*}}aligned
+# SYM: 000000000000000c {{.*}}.text {{.*}}before_pad
+# SYM: 0000000000000027 {{.*}}.text {{.*}}partly_aligned
@@ -0,0 +1,19 @@
+// REQUIRES: asserts
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t -stats \
+// RUN:   2>&1 | FileCheck %s
+
+// Relaxable fragments keep the encoding of their instruction, so layout
+// only runs the encoder again for the two jumps that have to grow. Every
+// other check of a relaxable fragment reuses the bytes it already has.
+
+// CHECK: 2 assembler - Number of instructions re-encoded after relaxation
+// CHECK: 10 assembler - Number of relaxation checks reusing the cached
+// CHECK: 2 assembler - Number of relaxed instructions
+
+a:
+    jmp b
+    jne a
+    .fill 200, 1, 0x90
+b:
+    jne a
+    jmp b
@@ -0,0 +1,37 @@
+# RUN: llvm-mc -triple=x86_64-linux-gnu -filetype=obj %s -o %t
+# RUN: llvm-objdump -d -r --nacl-bundle-check %t > %t.serial 2> %t.serial.err
+# RUN: llvm-objdump -d -r -j4 --nacl-bundle-check %t > %t.parallel \
+# RUN:   2> %t.parallel.err
+# RUN: cmp %t.serial %t.parallel
+# RUN: cmp %t.serial.err %t.parallel.err
+# RUN: FileCheck %s < %t.serial.err
+# RUN: FileCheck %s -check-prefix=DIS < %t.serial
+
+# The code is assembled without bundling, so the 10-byte movabsq
+# instructions cross bundle boundaries. The code after them is large enough
+# to be split between threads, and its instructions straddle many of the
+# split points.
+# CHECK: instruction at 0x1e crosses a 32-byte bundle boundary
+# CHECK-NEXT: instruction at 0x3c crosses a 32-byte bundle boundary
+
+# DIS: Disassembly of section .text:
+# DIS: 1e: 48 b8 f0 de bc 9a 78 56 34 12
+# DIS-NEXT: 28: 90
+# DIS: 3c: 48 b9 f0 de bc 9a 78 56 34 12
+# DIS-NEXT: 46: 81 c1 78 56 34 12
+# DIS-NEXT: 4c: 48 8d 15 00 00 00 00
+# DIS-NEXT: 4f: R_X86_64_PC32 ext-4-P
+
+        .text
+        .globl  f
+f:
+        .fill   30, 1, 0x90
+        movabsq $0x123456789abcdef0, %rax
+        .fill   20, 1, 0x90
+        movabsq $0x123456789abcdef0, %rcx
+        .rept   2000
+        addl    $(0x12345678), %ecx
+        leaq    ext(%rip), %rdx
+        pushq   %rbx
+        .endr
+        ret
@@ -0,0 +1,29 @@
+; RUN: echo "-mtriple=i386-unknown-nacl %s -o %t.32.s" > %t.cmds
+; RUN: echo "-mtriple=x86_64-unknown-nacl %s -o %t.64.s" >> %t.cmds
+; RUN: echo "-mtriple=x86_64-unknown-nacl %t.missing.ll -o %t.bad.s" >> %t.cmds
+; RUN: echo "-mtriple=x86_64-unknown-nacl -filetype=obj %s -o %t.64.o" >> %t.cmds
+; RUN: echo "-no-such-option %s -o %t.opt.s" >> %t.cmds
+; RUN: not pnacl-llc -server -server-jobs=2 -filetype=asm < %t.cmds \
+; RUN:   | sort | FileCheck -check-prefix=REPLY %s
+; RUN: pnacl-llc -mtriple=i386-unknown-nacl -filetype=asm %s -o %t.32.ref.s
+; RUN: pnacl-llc -mtriple=x86_64-unknown-nacl -filetype=asm %s -o %t.64.ref.s
+; RUN: diff %t.32.s %t.32.ref.s
+; RUN: diff %t.64.s %t.64.ref.s
+; RUN: pnacl-llc -mtriple=x86_64-unknown-nacl -filetype=obj %s -o %t.64.ref.o
+; RUN: cmp %t.64.o %t.64.ref.o
+
+; Each request line is translated with its own options and answered with its
+; sequence number and exit status. A request may override an option given on
+; the server's command line. A request with a bad option fails without the
+; child writing anything to the server's stdout.
+; REPLY: 1 0
+; REPLY: 2 0
+; REPLY: 3 1
+; REPLY: 4 0
+; REPLY-NEXT: 5 1
+; REPLY-NOT: {{.}}
+
+define i32 @add(i32 %a, i32 %b) {
+  %sum = add i32 %a, %b
+  ret i32 %sum
+}
@@ -0,0 +1,32 @@
+; REQUIRES: asserts
+; RUN: llvm-as < %s | pnacl-freeze > %t.pexe
+; RUN: pnacl-llc -mtriple=x86_64-unknown-nacl -bitcode-format=pnacl \
+; RUN:   -streaming-bitcode -reduce-memory-footprint -filetype=obj -stats \
+; RUN:   %t.pexe -o %t.streamed.o 2>&1 | FileCheck -check-prefix=STREAM %s
+; RUN: pnacl-llc -mtriple=x86_64-unknown-nacl -bitcode-format=pnacl \
+; RUN:   -filetype=obj -stats %t.pexe -o %t.eager.o 2>&1 \
+; RUN:   | FileCheck -check-prefix=EAGER %s
+; RUN: cmp %t.streamed.o %t.eager.o
+
+; A streaming translation releases the body of every function once it has
+; been translated; a translation of the fully loaded module keeps them all.
+
+; STREAM: 3 NaClBitcodeReader - Number of function bodies released after use
+
+; EAGER-NOT: Number of function bodies released
+
+define i32 @f0(i32 %x) {
+  %y = mul i32 %x, 3
+  ret i32 %y
+}
+
+define i32 @f1(i32 %x) {
+  %r = call i32 @f0(i32 %x)
+  %s = add i32 %r, 1
+  ret i32 %s
+}
+
+define i32 @f2(i32 %x) {
+  %r = call i32 @f1(i32 %x)
+  ret i32 %r
+}
@@ -0,0 +1,36 @@
+; RUN: llvm-as < %s | pnacl-freeze > %t.pexe
+; RUN: pnacl-llc -mtriple=i686-unknown-nacl -bitcode-format=pnacl \
+; RUN:   -filetype=asm %t.pexe -o %t.eager.s
+; RUN: pnacl-llc -mtriple=i686-unknown-nacl -bitcode-format=pnacl \
+; RUN:   -streaming-bitcode -filetype=asm %t.pexe -o %t.streamed.s
+; RUN: diff %t.eager.s %t.streamed.s
+; RUN: pnacl-llc -mtriple=i686-unknown-nacl -bitcode-format=pnacl \
+; RUN:   -streaming-bitcode -reduce-memory-footprint -filetype=asm %t.pexe \
+; RUN:   -o %t.released.s
+; RUN: diff %t.eager.s %t.released.s
+; RUN: FileCheck %s < %t.streamed.s
+
+; Streaming translation matches the translation of the fully loaded module,
+; also when -reduce-memory-footprint releases each function's IR once it is
+; translated and later functions still call the released ones.
+
+; CHECK: callee:
+define internal i32 @callee(i32 %x) {
+  %y = mul i32 %x, 3
+  ret i32 %y
+}
+
+; CHECK: caller:
+; CHECK: call callee
+define i32 @caller(i32 %x) {
+  %r = call i32 @callee(i32 %x)
+  %s = add i32 %r, 1
+  ret i32 %s
+}
+
+; CHECK: second_caller:
+; CHECK: call callee
+define i32 @second_caller(i32 %x) {
+  %r = call i32 @callee(i32 %x)
+  ret i32 %r
+}
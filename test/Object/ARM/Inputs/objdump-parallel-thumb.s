@@ -0,0 +1,16 @@
+@ Input for objdump-parallel-thumb.test. A Thumb function far larger than
+@ a disassembly piece, made of IT blocks that straddle every 4 KiB offset.
+
+        .syntax unified
+        .thumb
+        .text
+        .globl  f
+        .type   f,%function
+        .thumb_func
+f:
+        .rept   3000
+        ite     eq
+        moveq   r0, r1
+        addne   r0, r0, #1
+        .endr
+        bx      lr
@@ -0,0 +1,39 @@
+# Input for objdump-parallel.test. Several functions, one of them far
+# larger than a disassembly piece and made of instructions of different
+# lengths, so that the pieces cut inside it start mid-instruction.
+
+        .text
+        .globl  small1
+small1:
+        pushq   %rbp
+        movq    %rsp, %rbp
+        popq    %rbp
+        ret
+
+        .globl  big
+big:
+        .rept   3000
+        movabsq $(0x123456789abcdef0), %rax
+        addl    $(0x12345678), %ecx
+        leaq    ext(%rip), %rdx
+        pushq   %rbx
+        .endr
+        ret
+
+        .globl  small2
+small2:
+        xorl    %eax, %eax
+        ret
+
+        .globl  mid
+mid:
+        .rept   600
+        movl    $(0x12345678), %eax
+        incq    %rcx
+        .endr
+        ret
+
+        .globl  small3
+small3:
+        nop
+        ret
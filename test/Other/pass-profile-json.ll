@@ -0,0 +1,21 @@
+; RUN: opt < %s -instcombine -disable-output -pass-profile-json=%t.json
+; RUN: FileCheck %s < %t.json
+
+; Test that -pass-profile-json reports the IR instruction count before and
+; after each pass, in total and per function.
+
+; CHECK: "passes": [
+; CHECK: {"name": "Combine redundant instructions", "kind": "function", "runs": 2, {{.*}}"insts_before": 4, "insts_after": 2,
+; CHECK: "functions": [
+; CHECK: {"name": "f", "runs": 1, {{.*}}"insts_before": 2, "insts_after": 1}
+; CHECK: {"name": "g", "runs": 1, {{.*}}"insts_before": 2, "insts_after": 1}
+
+define i32 @f(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
+
+define i32 @g(i32 %x) {
+  %a = mul i32 %x, 1
+  ret i32 %a
+}
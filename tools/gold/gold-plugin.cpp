@@ -97,6 +97,7 @@ namespace options {
   enum generate_bc { BC_NO, BC_ALSO, BC_ONLY };
   static bool generate_api_file = false;
   static bool gather_then_link = true; // @LOCALMOD
+  static unsigned partitions = 1; // @LOCALMOD
   static generate_bc generate_bc_file = BC_NO;
   static std::string bc_path;
   static std::string obj_path;
@@ -129,6 +130,13 @@ namespace options {
       // @LOCALMOD-BEGIN
     } else if (opt == "no-gather-then-link") {
       gather_then_link = false;
+    } else if (opt.startswith("partitions=")) {
+      if (opt.substr(strlen("partitions=")).getAsInteger(10, partitions) ||
+          partitions == 0) {
+        (*message)(LDPL_WARNING, "Invalid number of partitions. "
+                   "Discarding %s", opt_);
+        partitions = 1;
+      }
       // @LOCALMOD-END
     } else if (opt == "emit-llvm") {
       generate_bc_file = BC_ONLY;
@@ -636,10 +644,20 @@ static ld_plugin_status all_symbols_read_hook(void) {
     if (options::generate_bc_file == options::BC_ONLY)
       exit(0);
   }
-  const char *objPath;
-  if (lto_codegen_compile_to_file(code_gen, &objPath)) {
+  // @LOCALMOD-BEGIN
+  // Generate one object per partition. The names are owned by code_gen, so
+  // copy them before disposing of it.
+  const char **objNames;
+  unsigned numObjs;
+  std::vector<std::string> objPaths;
+  lto_codegen_set_num_partitions(code_gen, options::partitions);
+  bool compileFailed =
+    lto_codegen_compile_to_files(code_gen, &objNames, &numObjs);
+  if (compileFailed)
     (*message)(LDPL_ERROR, "Could not produce a combined object file\n");
-  }
+  else
+    objPaths.assign(objNames, objNames + numObjs);
+  // @LOCALMOD-END
 
   lto_codegen_dispose(code_gen);
   for (std::list<claimed_file>::iterator I = Modules.begin(),
@@ -650,11 +668,19 @@ static ld_plugin_status all_symbols_read_hook(void) {
     }
   }
 
-  if ((*add_input_file)(objPath) != LDPS_OK) {
-    (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
-    (*message)(LDPL_ERROR, "File left behind in: %s", objPath);
+  // @LOCALMOD-BEGIN
+  if (compileFailed)
     return LDPS_ERR;
+
+  for (unsigned i = 0, e = objPaths.size(); i != e; ++i) {
+    const char *objPath = objPaths[i].c_str();
+    if ((*add_input_file)(objPath) != LDPS_OK) {
+      (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
+      (*message)(LDPL_ERROR, "File left behind in: %s", objPath);
+      return LDPS_ERR;
+    }
   }
+  // @LOCALMOD-END
 
   if (!options::extra_library_path.empty() &&
       set_extra_library_path(options::extra_library_path.c_str()) != LDPS_OK) {
@@ -663,7 +689,8 @@ static ld_plugin_status all_symbols_read_hook(void) {
   }
 
   if (options::obj_path.empty())
-    Cleanup.push_back(sys::Path(objPath));
+    for (unsigned i = 0, e = objPaths.size(); i != e; ++i) // @LOCALMOD
+      Cleanup.push_back(sys::Path(objPaths[i])); // @LOCALMOD
 
   return LDPS_OK;
 }
@@ -21,10 +21,12 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdlib>
 #include <fstream>
+#include <map> // @LOCALMOD
 #include <memory>
 using namespace llvm;
 
@@ -42,6 +44,14 @@ static cl::list<std::string>
 RestOfArgs(cl::Positional, cl::OneOrMore,
     cl::desc("[relpos] [count] <archive-file> [members]..."));
 
+// @LOCALMOD-BEGIN
+// Number of threads reading the symbols of bitcode members and extracting
+// members. The archive written does not depend on it.
+static cl::opt<unsigned>
+Threads("j", cl::Prefix, cl::init(1), cl::value_desc("N"),
+        cl::desc("Use N threads to scan and extract members"));
+// @LOCALMOD-END
+
 // MoreHelp - Provide additional help output explaining the operations and
 // modifiers of llvm-ar. This object instructs the CommandLine library
 // to print the text of the constructor when the --help option is given.
@@ -449,12 +459,41 @@ doDisplayTable(std::string* ErrMsg) {
   return false;
 }
 
+// @LOCALMOD-BEGIN
+// extractMember - Write one member's data to its file. Members are extracted
+// concurrently with -j, after their directories have been created.
+static void extractMember(void *Arg) {
+  const ArchiveMember &Member = *static_cast<const ArchiveMember*>(Arg);
+
+  // Open up a file stream for writing
+  std::ios::openmode io_mode = std::ios::out | std::ios::trunc |
+                               std::ios::binary;
+  std::ofstream file(Member.getPath().c_str(), io_mode);
+
+  // Get the data and its length
+  const char* data = reinterpret_cast<const char*>(Member.getData());
+  unsigned len = Member.getSize();
+
+  // Write the data.
+  file.write(data,len);
+  file.close();
+
+  // If we're supposed to retain the original modification times, etc. do so
+  // now.
+  if (OriginalDates)
+    Member.getPath().setStatusInfoOnDisk(Member.getFileStatus());
+}
+
 // doExtract - Implement the 'x' operation. This function extracts files back to
 // the file system.
 bool
 doExtract(std::string* ErrMsg) {
   if (buildPaths(false, ErrMsg))
     return true;
+  std::vector<void*> ToExtract;
+  // Members with the same path would be written to the same file at once.
+  // Extract only the last of them, which a serial extraction leaves behind.
+  std::map<std::string, unsigned> ExtractIndex;
   for (Archive::iterator I = TheArchive->begin(), E = TheArchive->end();
        I != E; ++I ) {
     if (Paths.empty() ||
@@ -468,27 +507,21 @@ doExtract(std::string* ErrMsg) {
           return true;
       }
 
-      // Open up a file stream for writing
-      std::ios::openmode io_mode = std::ios::out | std::ios::trunc |
-                                   std::ios::binary;
-      std::ofstream file(I->getPath().c_str(), io_mode);
-
-      // Get the data and its length
-      const char* data = reinterpret_cast<const char*>(I->getData());
-      unsigned len = I->getSize();
-
-      // Write the data.
-      file.write(data,len);
-      file.close();
-
-      // If we're supposed to retain the original modification times, etc. do so
-      // now.
-      if (OriginalDates)
-        I->getPath().setStatusInfoOnDisk(I->getFileStatus());
+      std::pair<std::map<std::string, unsigned>::iterator, bool> Ins =
+        ExtractIndex.insert(std::make_pair(I->getPath().str(),
+                                           (unsigned)ToExtract.size()));
+      if (!Ins.second)
+        ToExtract[Ins.first->second] = &*I;
+      else
+        ToExtract.push_back(&*I);
     }
   }
+  if (!ToExtract.empty())
+    llvm_execute_on_threads(extractMember, &ToExtract[0], ToExtract.size(),
+                            Threads);
   return false;
 }
+// @LOCALMOD-END
 
 // doDelete - Implement the delete operation. This function deletes zero or more
 // members from the archive. Note that if the count is specified, there should
@@ -516,7 +549,7 @@ doDelete(std::string* ErrMsg) {
   }
 
   // We're done editting, reconstruct the archive.
-  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg))
+  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg,Threads))
     return true;
   if (ReallyVerbose)
     printSymbolTable();
@@ -571,7 +604,7 @@ doMove(std::string* ErrMsg) {
   }
 
   // We're done editting, reconstruct the archive.
-  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg))
+  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg,Threads))
     return true;
   if (ReallyVerbose)
     printSymbolTable();
@@ -596,7 +629,7 @@ doQuickAppend(std::string* ErrMsg) {
   }
 
   // We're done editting, reconstruct the archive.
-  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg))
+  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg,Threads))
     return true;
   if (ReallyVerbose)
     printSymbolTable();
@@ -694,7 +727,7 @@ doReplaceOrInsert(std::string* ErrMsg) {
   }
 
   // We're done editting, reconstruct the archive.
-  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg))
+  if (TheArchive->writeToDisk(SymTable,TruncateNames,ErrMsg,Threads))
     return true;
   if (ReallyVerbose)
     printSymbolTable();
@@ -52,6 +52,17 @@ static cl::opt<bool>
 PrintInlining("inlining", cl::init(false),
               cl::desc("Print all inlined frames for a given address"));
 
+// @LOCALMOD-BEGIN
+static cl::opt<std::string>
+AddressIndex("address-index", cl::init(""),
+             cl::desc("Answer address queries from an index cached in the "
+                      "given file, creating it if needed"));
+
+static cl::opt<unsigned>
+Threads("j", cl::Prefix, cl::init(1), cl::value_desc("N"),
+        cl::desc("Use N threads to parse compile units"));
+// @LOCALMOD-END
+
 static cl::opt<DIDumpType>
 DumpType("debug-dump", cl::init(DIDT_All),
   cl::desc("Dump of debug sections:"),
@@ -94,6 +105,7 @@ static void DumpInput(const StringRef &Filename) {
   }
 
   OwningPtr<DIContext> DICtx(DIContext::getDWARFContext(Obj.get()));
+  DICtx->setNumThreads(Threads); // @LOCALMOD
 
   if (Address == -1ULL) {
     outs() << Filename
@@ -101,6 +113,12 @@ static void DumpInput(const StringRef &Filename) {
     // Dump the complete DWARF structure.
     DICtx->dump(outs(), DumpType);
   } else {
+    // @LOCALMOD-BEGIN
+    if (!AddressIndex.empty()) {
+      if (!DICtx->useAddressIndex(AddressIndex))
+        errs() << AddressIndex << ": could not create address index\n";
+    }
+    // @LOCALMOD-END
     // Print line info for the specified address.
     int SpecFlags = DILineInfoSpecifier::FileLineInfo |
                     DILineInfoSpecifier::AbsoluteFilePath;
@@ -49,12 +49,20 @@ Verbose("v", cl::desc("Print information about actions taken"));
 static cl::opt<bool>
 DumpAsm("d", cl::desc("Print assembly as linked"), cl::Hidden);
 
+// @LOCALMOD-BEGIN
+static cl::opt<bool>
+LazyLoad("lazy",
+         cl::desc("Read function bodies of the modules linked into the first "
+                  "one only when they are linked in"));
+// @LOCALMOD-END
+
 // LoadFile - Read the specified bitcode file in and return it.  This routine
 // searches the link path for the specified file to try to find it...
 //
 static inline std::auto_ptr<Module> LoadFile(const char *argv0,
                                              const std::string &FN, 
-                                             LLVMContext& Context) {
+                                             LLVMContext& Context,
+                                             bool Lazy = false) { // @LOCALMOD
   sys::Path Filename;
   if (!Filename.set(FN)) {
     errs() << "Invalid file name: '" << FN << "'\n";
@@ -66,7 +74,14 @@ static inline std::auto_ptr<Module> LoadFile(const char *argv0,
   Module* Result = 0;
   
   const std::string &FNStr = Filename.str();
-  Result = ParseIRFile(FNStr, Err, Context);
+  // @LOCALMOD-BEGIN
+  // A lazily loaded module keeps its file buffer and reads each function body
+  // when the linker materializes it.
+  if (Lazy)
+    Result = getLazyIRFileModule(FNStr, Err, Context);
+  else
+    Result = ParseIRFile(FNStr, Err, Context);
+  // @LOCALMOD-END
   if (Result) return std::auto_ptr<Module>(Result);   // Load successful!
 
   Err.print(argv0, errs());
@@ -93,9 +108,16 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // @LOCALMOD-BEGIN
+  // The Linker keeps the struct types of the composite across the links
+  // instead of collecting them again for every input.
+  Linker L(argv[0], Composite.release());
+  // @LOCALMOD-END
+
   for (unsigned i = BaseArg+1; i < InputFilenames.size(); ++i) {
     std::auto_ptr<Module> M(LoadFile(argv[0],
-                                     InputFilenames[i], Context));
+                                     InputFilenames[i], Context,
+                                     LazyLoad)); // @LOCALMOD
     if (M.get() == 0) {
       errs() << argv[0] << ": error loading file '" <<InputFilenames[i]<< "'\n";
       return 1;
@@ -103,14 +125,15 @@ int main(int argc, char **argv) {
 
     if (Verbose) errs() << "Linking in '" << InputFilenames[i] << "'\n";
 
-    if (Linker::LinkModules(Composite.get(), M.get(), Linker::DestroySource,
-                            &ErrorMessage)) {
+    if (L.LinkInModule(M.get(), &ErrorMessage)) { // @LOCALMOD
       errs() << argv[0] << ": link error in '" << InputFilenames[i]
              << "': " << ErrorMessage << "\n";
       return 1;
     }
   }
 
+  Composite.reset(L.releaseModule()); // @LOCALMOD
+
   // TODO: Iterate over the -l list and link in any modules containing
   // global symbols that have not been resolved so far.
 
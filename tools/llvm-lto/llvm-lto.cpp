@@ -0,0 +1,120 @@
+//===-- llvm-lto.cpp - Test driver for libLTO -----------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program links bitcode files through the libLTO C API, the way a linker
+// plugin does, and writes the resulting native object files. It exists to
+// test libLTO.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm-c/lto.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::OneOrMore, cl::desc("<input bitcode files>"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::Required, cl::value_desc("filename"),
+  cl::desc("Output object file; with -partitions, the objects are written "
+           "to <filename>.0, <filename>.1, ..."));
+
+static cl::list<std::string>
+ExportedSymbols("exported-symbol", cl::value_desc("name"),
+  cl::desc("Symbol to preserve from internalization"));
+
+static cl::opt<unsigned>
+Partitions("partitions", cl::init(0), cl::value_desc("N"),
+  cl::desc("Split code generation into N partitions "
+           "(lto_codegen_compile_to_files)"));
+
+// Copy the object file From, which is owned by libLTO, to To.
+static bool copyObject(const char *From, const std::string &To,
+                       const char *ProgName) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(From, Buffer)) {
+    errs() << ProgName << ": cannot read " << From << ": " << EC.message()
+           << '\n';
+    return true;
+  }
+  std::string ErrorInfo;
+  raw_fd_ostream Out(To.c_str(), ErrorInfo, raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty()) {
+    errs() << ProgName << ": " << ErrorInfo << '\n';
+    return true;
+  }
+  Out << Buffer->getBuffer();
+  bool Existed;
+  sys::fs::remove(From, Existed);
+  return false;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv, "libLTO test driver\n");
+
+  lto_code_gen_t CodeGen = lto_codegen_create();
+  lto_codegen_set_pic_model(CodeGen, LTO_CODEGEN_PIC_MODEL_STATIC);
+  for (unsigned i = 0, e = ExportedSymbols.size(); i != e; ++i)
+    lto_codegen_add_must_preserve_symbol(CodeGen, ExportedSymbols[i].c_str());
+
+  std::vector<lto_module_t> Modules;
+  int RetVal = 0;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e && !RetVal; ++i) {
+    lto_module_t M = lto_module_create(InputFilenames[i].c_str());
+    if (!M || lto_codegen_add_module(CodeGen, M)) {
+      errs() << argv[0] << ": " << lto_get_error_message() << '\n';
+      RetVal = 1;
+    }
+    if (M)
+      Modules.push_back(M);
+  }
+
+  if (!RetVal && !Partitions) {
+    const char *Name;
+    if (lto_codegen_compile_to_file(CodeGen, &Name)) {
+      errs() << argv[0] << ": " << lto_get_error_message() << '\n';
+      RetVal = 1;
+    } else if (copyObject(Name, OutputFilename, argv[0])) {
+      RetVal = 1;
+    }
+  } else if (!RetVal) {
+    const char **Names;
+    unsigned NumNames;
+    lto_codegen_set_num_partitions(CodeGen, Partitions);
+    if (lto_codegen_compile_to_files(CodeGen, &Names, &NumNames)) {
+      errs() << argv[0] << ": " << lto_get_error_message() << '\n';
+      RetVal = 1;
+    }
+    for (unsigned i = 0; !RetVal && i != NumNames; ++i) {
+      std::string Path = OutputFilename + "." + utostr(i);
+      if (copyObject(Names[i], Path, argv[0]))
+        RetVal = 1;
+    }
+  }
+
+  lto_codegen_dispose(CodeGen);
+  for (unsigned i = 0, e = Modules.size(); i != e; ++i)
+    lto_module_dispose(Modules[i]);
+  return RetVal;
+}
@@ -98,3 +98,49 @@ void llvm::printELFFileHeader(const object::ObjectFile *Obj) {
           dyn_cast<ELFObjectFile<ELFType<support::big, 8, true> > >(Obj))
     printProgramHeaders(ELFObj);
 }
+
+// @LOCALMOD-BEGIN
+template<class ELFT>
+static void getSymbolOffsets(const ELFObjectFile<ELFT> *o,
+                             const SectionRef &Section,
+                             std::vector<uint64_t> &Offsets) {
+  typedef ELFObjectFile<ELFT> ELFO;
+  const typename ELFO::Elf_Shdr *Shdr =
+    reinterpret_cast<const typename ELFO::Elf_Shdr *>(
+      Section.getRawDataRefImpl().p);
+  ArrayRef<typename ELFO::SymbolAddress> Symbols = o->getSymbolsByAddress();
+  for (unsigned i = 0, e = Symbols.size(); i != e; ++i) {
+    if (o->getSection(Symbols[i].SectionIndex) != Shdr)
+      continue;
+    uint64_t Offset = Symbols[i].Address - Shdr->sh_addr;
+    if (Offsets.empty() || Offsets.back() != Offset)
+      Offsets.push_back(Offset);
+  }
+}
+
+/// getELFSymbolOffsets - Append the section offsets of the symbols defined
+/// in Section to Offsets, in ascending order and without duplicates.
+void llvm::getELFSymbolOffsets(const object::ObjectFile *Obj,
+                               const SectionRef &Section,
+                               std::vector<uint64_t> &Offsets) {
+  // Little-endian 32-bit
+  if (const ELFObjectFile<ELFType<support::little, 4, false> > *ELFObj =
+          dyn_cast<ELFObjectFile<ELFType<support::little, 4, false> > >(Obj))
+    getSymbolOffsets(ELFObj, Section, Offsets);
+
+  // Big-endian 32-bit
+  if (const ELFObjectFile<ELFType<support::big, 4, false> > *ELFObj =
+          dyn_cast<ELFObjectFile<ELFType<support::big, 4, false> > >(Obj))
+    getSymbolOffsets(ELFObj, Section, Offsets);
+
+  // Little-endian 64-bit
+  if (const ELFObjectFile<ELFType<support::little, 8, true> > *ELFObj =
+          dyn_cast<ELFObjectFile<ELFType<support::little, 8, true> > >(Obj))
+    getSymbolOffsets(ELFObj, Section, Offsets);
+
+  // Big-endian 64-bit
+  if (const ELFObjectFile<ELFType<support::big, 8, true> > *ELFObj =
+          dyn_cast<ELFObjectFile<ELFType<support::big, 8, true> > >(Obj))
+    getSymbolOffsets(ELFObj, Section, Offsets);
+}
+// @LOCALMOD-END
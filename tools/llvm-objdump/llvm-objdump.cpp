@@ -42,12 +42,14 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MathExtras.h" // @LOCALMOD
 #include "llvm/Support/MemoryObject.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 #include <algorithm>
@@ -123,6 +125,21 @@ static cl::alias
 PrivateHeadersShort("p", cl::desc("Alias for --private-headers"),
                     cl::aliasopt(PrivateHeaders));
 
+// @LOCALMOD-BEGIN
+static cl::opt<unsigned>
+Threads("j", cl::Prefix, cl::init(1), cl::value_desc("N"),
+        cl::desc("Disassemble on N threads. The output is the same as "
+                 "with one thread. Targets whose disassembler keeps state "
+                 "between instructions, such as Thumb, use one thread"));
+
+static cl::opt<bool>
+NaClBundleCheck("nacl-bundle-check",
+  cl::desc("When disassembling, report instructions that cross a 32-byte "
+           "NaCl bundle boundary"));
+
+static const uint64_t NaClBundleSize = 32;
+// @LOCALMOD-END
+
 static StringRef ToolName;
 
 bool llvm::error(error_code ec) {
@@ -158,7 +175,13 @@ static const Target *getTarget(const ObjectFile *Obj = NULL) {
 
 void llvm::StringRefMemoryObject::anchor() { }
 
+// @LOCALMOD-BEGIN
 void llvm::DumpBytes(StringRef bytes) {
+  DumpBytes(bytes, outs());
+}
+
+void llvm::DumpBytes(StringRef bytes, raw_ostream &OS) {
+// @LOCALMOD-END
   static const char hex_rep[] = "0123456789abcdef";
   // FIXME: The real way to do this is to figure out the longest instruction
   //        and align to that size before printing. I'll fix this when I get
@@ -181,7 +204,7 @@ void llvm::DumpBytes(StringRef bytes) {
   }
 
   output[sizeof(output) - 1] = 0;
-  outs() << output;
+  OS << output; // @LOCALMOD
 }
 
 bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
@@ -191,6 +214,362 @@ bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
   return a_addr < b_addr;
 }
 
+// @LOCALMOD-BEGIN
+namespace {
+/// Disassembler - The MC objects that decode and print instructions. They
+/// keep decoding state, so each thread uses its own.
+struct Disassembler {
+  OwningPtr<const MCAsmInfo> AsmInfo;
+  OwningPtr<const MCSubtargetInfo> STI;
+  OwningPtr<const MCDisassembler> DisAsm;
+  OwningPtr<const MCRegisterInfo> MRI;
+  OwningPtr<const MCInstrInfo> MII;
+  OwningPtr<MCInstPrinter> IP;
+
+  /// init - Create the MC objects, reporting any that are missing.
+  bool init(const Target *TheTarget, const std::string &FeaturesStr);
+};
+}
+
+bool Disassembler::init(const Target *TheTarget,
+                        const std::string &FeaturesStr) {
+  AsmInfo.reset(TheTarget->createMCAsmInfo(TripleName));
+  if (!AsmInfo) {
+    errs() << "error: no assembly info for target " << TripleName << "\n";
+    return false;
+  }
+
+  STI.reset(TheTarget->createMCSubtargetInfo(TripleName, "", FeaturesStr));
+  if (!STI) {
+    errs() << "error: no subtarget info for target " << TripleName << "\n";
+    return false;
+  }
+
+  DisAsm.reset(TheTarget->createMCDisassembler(*STI));
+  if (!DisAsm) {
+    errs() << "error: no disassembler for target " << TripleName << "\n";
+    return false;
+  }
+
+  MRI.reset(TheTarget->createMCRegInfo(TripleName));
+  if (!MRI) {
+    errs() << "error: no register info for target " << TripleName << "\n";
+    return false;
+  }
+
+  MII.reset(TheTarget->createMCInstrInfo());
+  if (!MII) {
+    errs() << "error: no instruction info for target " << TripleName << "\n";
+    return false;
+  }
+
+  int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
+  IP.reset(TheTarget->createMCInstPrinter(AsmPrinterVariant, *AsmInfo, *MII,
+                                          *MRI, *STI));
+  if (!IP) {
+    errs() << "error: no instruction printer for target " << TripleName
+           << '\n';
+    return false;
+  }
+  return true;
+}
+
+/// PrintInlineRelocations - Print the relocations from rel_cur on that apply
+/// before Limit, the section offset following the current instruction.
+static void PrintInlineRelocations(
+    std::vector<RelocationRef>::const_iterator &rel_cur,
+    std::vector<RelocationRef>::const_iterator rel_end,
+    uint64_t Limit, uint64_t SectionAddr) {
+  while (rel_cur != rel_end) {
+    bool hidden = false;
+    uint64_t addr;
+    SmallString<16> name;
+    SmallString<32> val;
+
+    // If this relocation is hidden, skip it.
+    if (error(rel_cur->getHidden(hidden))) goto skip_print_rel;
+    if (hidden) goto skip_print_rel;
+
+    if (error(rel_cur->getAddress(addr))) goto skip_print_rel;
+    // Stop when rel_cur's address is past the current instruction.
+    if (addr >= Limit) break;
+    if (error(rel_cur->getTypeName(name))) goto skip_print_rel;
+    if (error(rel_cur->getValueString(val))) goto skip_print_rel;
+
+    outs() << format("\t\t\t%8" PRIx64 ": ", SectionAddr + addr) << name
+           << "\t" << val << "\n";
+
+  skip_print_rel:
+    ++rel_cur;
+  }
+}
+
+/// hasStatelessDisassembler - Whether the disassembler decodes an
+/// instruction the same wherever decoding started, so that a section can be
+/// cut into pieces decoded separately. The Thumb disassembler, for one,
+/// tracks IT blocks across instructions.
+static bool hasStatelessDisassembler() {
+  switch (Triple(TripleName).getArch()) {
+  case Triple::x86:
+  case Triple::x86_64:
+  case Triple::arm:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void CheckNaClBundle(uint64_t Address, uint64_t Size) {
+  if (Size == 0 ||
+      Address / NaClBundleSize == (Address + Size - 1) / NaClBundleSize)
+    return;
+  errs() << ToolName << ": warning: instruction at "
+         << format("0x%" PRIx64, Address) << " crosses a "
+         << NaClBundleSize << "-byte bundle boundary\n";
+}
+
+namespace {
+/// DisassembledInst - An instruction decoded ahead of printing.
+struct DisassembledInst {
+  uint64_t Index;  // Offset in the section.
+  uint64_t Size;
+  bool Valid;
+  size_t TextEnd;  // End of the instruction's text in its piece.
+};
+
+/// DisassemblyPiece - A part of a symbol that is decoded as a unit: from
+/// Start, one instruction after another, until an instruction reaches End.
+struct DisassemblyPiece {
+  uint64_t Start;
+  uint64_t End;
+  // The symbol name to print before the piece, if it starts a symbol.
+  // Otherwise decoding continues where the previous piece stopped.
+  StringRef Label;
+  bool StartsSymbol;
+  uint64_t Next;   // Offset following the last decoded instruction.
+  std::string Text;
+  std::vector<DisassembledInst> Insts;
+};
+
+/// SectionDisassembly - What the disassembly jobs of a section share.
+struct SectionDisassembly {
+  const Target *TheTarget;
+  const std::string *FeaturesStr;
+  StringRef Bytes;
+  uint64_t SectionAddr;
+};
+
+/// DisassemblyJob - A run of consecutive pieces decoded on one thread.
+struct DisassemblyJob {
+  const SectionDisassembly *Section;
+  DisassemblyPiece *Begin;
+  DisassemblyPiece *End;
+  bool Failed;
+};
+}
+
+/// DecodePiece - Decode Piece from offset Start, printing the instructions
+/// into Piece.Text. If Old is not null, it holds the instructions of the
+/// piece decoded from a different start; decoding stops as soon as it falls
+/// in step with them and the rest of Old is reused.
+static void DecodePiece(Disassembler &D, const SectionDisassembly &Section,
+                        DisassemblyPiece &Piece, uint64_t Start,
+                        const DisassemblyPiece *Old) {
+  StringRefMemoryObject memoryObject(Section.Bytes);
+  raw_string_ostream OS(Piece.Text);
+  std::vector<DisassembledInst>::const_iterator OldI;
+  if (Old)
+    OldI = Old->Insts.begin();
+  uint64_t Index, Size;
+  for (Index = Start; Index < Piece.End; Index += Size) {
+    if (Old) {
+      while (OldI != Old->Insts.end() && OldI->Index < Index)
+        ++OldI;
+      if (OldI != Old->Insts.end() && OldI->Index == Index) {
+        // Splice in the instructions decoded from here on.
+        size_t OldTextStart =
+          OldI == Old->Insts.begin() ? 0 : (OldI - 1)->TextEnd;
+        OS.flush();
+        size_t Delta = Piece.Text.size() - OldTextStart;
+        Piece.Text.append(Old->Text, OldTextStart, std::string::npos);
+        for (; OldI != Old->Insts.end(); ++OldI) {
+          DisassembledInst Inst = *OldI;
+          Inst.TextEnd += Delta;
+          Piece.Insts.push_back(Inst);
+        }
+        Piece.Next = Old->Next;
+        return;
+      }
+    }
+
+    MCInst Inst;
+    DisassembledInst Decoded;
+    Decoded.Index = Index;
+    Decoded.Valid = D.DisAsm->getInstruction(Inst, Size, memoryObject, Index,
+                                             nulls(), nulls());
+    if (Decoded.Valid) {
+      OS << format("%8" PRIx64 ":", Section.SectionAddr + Index);
+      if (!NoShowRawInsn) {
+        OS << "\t";
+        DumpBytes(StringRef(Section.Bytes.data() + Index, Size), OS);
+      }
+      D.IP->printInst(&Inst, OS, "");
+      OS << "\n";
+    } else if (Size == 0) {
+      Size = 1; // skip illegible bytes
+    }
+    Decoded.Size = Size;
+    OS.flush();
+    Decoded.TextEnd = Piece.Text.size();
+    Piece.Insts.push_back(Decoded);
+  }
+  Piece.Next = Index;
+}
+
+static void RunDisassemblyJob(void *Data) {
+  DisassemblyJob *Job = static_cast<DisassemblyJob *>(Data);
+  Disassembler D;
+  if (!D.init(Job->Section->TheTarget, *Job->Section->FeaturesStr)) {
+    Job->Failed = true;
+    return;
+  }
+  for (DisassemblyPiece *P = Job->Begin; P != Job->End; ++P)
+    DecodePiece(D, *Job->Section, *P, P->Start, 0);
+}
+
+/// SplitSymbol - Append the pieces of the symbol spanning [Start, End) to
+/// Pieces. A piece is at least MinSize and at most twice MinSize bytes long,
+/// unless the whole symbol is shorter. It ends at the first offset of
+/// SplitPoints, which must be sorted, that allows this, or else MinSize
+/// bytes after its start, possibly inside an instruction.
+static void SplitSymbol(uint64_t Start, uint64_t End, StringRef Label,
+                        const std::vector<uint64_t> &SplitPoints,
+                        uint64_t MinSize,
+                        std::vector<DisassemblyPiece> &Pieces) {
+  const uint64_t MaxSize = 2 * MinSize;
+  DisassemblyPiece Piece;
+  Piece.Start = Start;
+  Piece.Label = Label;
+  Piece.StartsSymbol = true;
+  Piece.Next = Start;
+  std::vector<uint64_t>::const_iterator I = SplitPoints.begin();
+  while (End - Piece.Start > MaxSize) {
+    I = std::lower_bound(I, SplitPoints.end(), Piece.Start + MinSize);
+    uint64_t Cut = Piece.Start + MinSize;
+    if (I != SplitPoints.end() && *I <= Piece.Start + MaxSize &&
+        End - *I >= MinSize)
+      Cut = *I;
+    Piece.End = Cut;
+    Pieces.push_back(Piece);
+    Piece.Start = Cut;
+    Piece.Label = StringRef();
+    Piece.StartsSymbol = false;
+  }
+  Piece.End = End;
+  Pieces.push_back(Piece);
+}
+
+/// DisassembleSymbolsInParallel - Decode the symbols of a section on
+/// several threads and print them as the sequential loop does. Symbols are
+/// split into pieces at SplitPoints where possible, see SplitSymbol(); a
+/// piece whose predecessor did not stop exactly at its start is decoded
+/// again on this thread from where the predecessor stopped.
+static void DisassembleSymbolsInParallel(
+    const SectionDisassembly &Section, Disassembler &D,
+    const std::vector<std::pair<uint64_t, StringRef> > &Symbols,
+    const std::vector<uint64_t> &SplitPoints, uint64_t SectSize,
+    std::vector<RelocationRef>::const_iterator rel_cur,
+    std::vector<RelocationRef>::const_iterator rel_end) {
+  // Aim for several pieces per thread so that the threads stay busy, but
+  // keep them small enough that the text buffered for a round of pieces
+  // stays modest: pieces are at most twice MinSize, 128 KiB.
+  uint64_t MinSize = std::min<uint64_t>(
+    std::max<uint64_t>(SectSize / (Threads * 8), 4096), 64 * 1024);
+
+  std::vector<DisassemblyPiece> Pieces;
+  for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
+    uint64_t Start = Symbols[si].first;
+    uint64_t End;
+    if (si == se - 1)
+      End = SectSize;
+    else if (Symbols[si + 1].first != Start)
+      End = Symbols[si + 1].first - 1;
+    else
+      continue;
+    SplitSymbol(Start, End, Symbols[si].second, SplitPoints, MinSize, Pieces);
+  }
+
+  // Decode and print a bounded number of pieces at a time, so that the
+  // buffered text stays a small multiple of what the threads work on.
+  const unsigned PiecesPerRound = Threads * 16;
+  uint64_t Next = 0;
+  for (unsigned Round = 0; Round < Pieces.size(); Round += PiecesPerRound) {
+    unsigned RoundEnd =
+      std::min<unsigned>(Round + PiecesPerRound, Pieces.size());
+
+    // Group the pieces into jobs of at least MinSize bytes, so that symbols
+    // much smaller than a piece do not each pay for setting up the MC
+    // objects.
+    std::vector<DisassemblyJob> Jobs;
+    for (unsigned i = Round; i != RoundEnd;) {
+      DisassemblyJob Job;
+      Job.Section = &Section;
+      Job.Begin = &Pieces[i];
+      Job.Failed = false;
+      uint64_t Bytes = 0;
+      do {
+        Bytes += Pieces[i].End - Pieces[i].Start;
+        ++i;
+      } while (i != RoundEnd && Bytes < MinSize);
+      Job.End = &Pieces[0] + i;
+      Jobs.push_back(Job);
+    }
+    std::vector<void *> JobPtrs;
+    for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+      JobPtrs.push_back(&Jobs[i]);
+    llvm_execute_on_threads(RunDisassemblyJob, &JobPtrs[0], JobPtrs.size(),
+                            Threads);
+    for (unsigned i = 0, e = Jobs.size(); i != e; ++i)
+      if (Jobs[i].Failed)
+        return;
+
+    for (unsigned i = Round; i != RoundEnd; ++i) {
+      DisassemblyPiece &Piece = Pieces[i];
+      if (Piece.StartsSymbol) {
+        outs() << '\n' << Piece.Label << ":\n";
+      } else if (Next != Piece.Start) {
+        DisassemblyPiece Old;
+        std::swap(Old, Piece);
+        Piece.Start = Old.Start;
+        Piece.End = Old.End;
+        Piece.StartsSymbol = false;
+        DecodePiece(D, Section, Piece, Next, &Old);
+      }
+
+      size_t TextStart = 0;
+      for (std::vector<DisassembledInst>::const_iterator
+             I = Piece.Insts.begin(), E = Piece.Insts.end(); I != E; ++I) {
+        if (I->Valid) {
+          outs() << StringRef(Piece.Text.data() + TextStart,
+                              I->TextEnd - TextStart);
+          if (NaClBundleCheck)
+            CheckNaClBundle(Section.SectionAddr + I->Index, I->Size);
+        } else {
+          errs() << ToolName << ": warning: invalid instruction encoding\n";
+        }
+        TextStart = I->TextEnd;
+        PrintInlineRelocations(rel_cur, rel_end, I->Index + I->Size,
+                               Section.SectionAddr);
+      }
+      Next = Piece.Next;
+      // Release the text of the piece as soon as it is printed.
+      std::string().swap(Piece.Text);
+      std::vector<DisassembledInst>().swap(Piece.Insts);
+    }
+  }
+}
+// @LOCALMOD-END
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   const Target *TheTarget = getTarget(Obj);
   // getTarget() will have already issued a diagnostic if necessary, so
@@ -272,48 +651,13 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       Symbols.push_back(std::make_pair(0, name));
 
     // Set up disassembler.
-    OwningPtr<const MCAsmInfo> AsmInfo(TheTarget->createMCAsmInfo(TripleName));
-
-    if (!AsmInfo) {
-      errs() << "error: no assembly info for target " << TripleName << "\n";
+    // @LOCALMOD-BEGIN
+    Disassembler D;
+    if (!D.init(TheTarget, FeaturesStr))
       return;
-    }
-
-    OwningPtr<const MCSubtargetInfo> STI(
-      TheTarget->createMCSubtargetInfo(TripleName, "", FeaturesStr));
-
-    if (!STI) {
-      errs() << "error: no subtarget info for target " << TripleName << "\n";
-      return;
-    }
-
-    OwningPtr<const MCDisassembler> DisAsm(
-      TheTarget->createMCDisassembler(*STI));
-    if (!DisAsm) {
-      errs() << "error: no disassembler for target " << TripleName << "\n";
-      return;
-    }
-
-    OwningPtr<const MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
-    if (!MRI) {
-      errs() << "error: no register info for target " << TripleName << "\n";
-      return;
-    }
-
-    OwningPtr<const MCInstrInfo> MII(TheTarget->createMCInstrInfo());
-    if (!MII) {
-      errs() << "error: no instruction info for target " << TripleName << "\n";
-      return;
-    }
-
-    int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
-    OwningPtr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
-                                AsmPrinterVariant, *AsmInfo, *MII, *MRI, *STI));
-    if (!IP) {
-      errs() << "error: no instruction printer for target " << TripleName
-             << '\n';
-      return;
-    }
+    const MCDisassembler *DisAsm = D.DisAsm.get();
+    MCInstPrinter *IP = D.IP.get();
+    // @LOCALMOD-END
 
     StringRef Bytes;
     if (error(i->getContents(Bytes))) break;
@@ -325,6 +669,26 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
 
     std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
     std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
+    // @LOCALMOD-BEGIN
+    if (Threads > 1 && hasStatelessDisassembler()) {
+      // Split the symbols at bundle boundaries for NaCl code. Otherwise use
+      // the ELF symbols, which containsSymbol() does not report above.
+      std::vector<uint64_t> SplitPoints;
+      if (NaClBundleCheck || Triple(TripleName).getOS() == Triple::NaCl) {
+        for (uint64_t Offset =
+               RoundUpToAlignment(SectionAddr, NaClBundleSize) - SectionAddr;
+             Offset < SectSize; Offset += NaClBundleSize)
+          SplitPoints.push_back(Offset);
+      } else if (Obj->isELF()) {
+        getELFSymbolOffsets(Obj, *i, SplitPoints);
+      }
+      SectionDisassembly Section = { TheTarget, &FeaturesStr, Bytes,
+                                     SectionAddr };
+      DisassembleSymbolsInParallel(Section, D, Symbols, SplitPoints, SectSize,
+                                   rel_cur, rel_end);
+      continue;
+    }
+    // @LOCALMOD-END
     // Disassemble symbol by symbol.
     for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
       uint64_t Start = Symbols[si].first;
@@ -360,6 +724,10 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
           }
           IP->printInst(&Inst, outs(), "");
           outs() << "\n";
+          // @LOCALMOD-BEGIN
+          if (NaClBundleCheck)
+            CheckNaClBundle(SectionAddr + Index, Size);
+          // @LOCALMOD-END
         } else {
           errs() << ToolName << ": warning: invalid instruction encoding\n";
           if (Size == 0)
@@ -367,28 +735,8 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         }
 
         // Print relocation for instruction.
-        while (rel_cur != rel_end) {
-          bool hidden = false;
-          uint64_t addr;
-          SmallString<16> name;
-          SmallString<32> val;
-
-          // If this relocation is hidden, skip it.
-          if (error(rel_cur->getHidden(hidden))) goto skip_print_rel;
-          if (hidden) goto skip_print_rel;
-
-          if (error(rel_cur->getAddress(addr))) goto skip_print_rel;
-          // Stop when rel_cur's address is past the current instruction.
-          if (addr >= Index + Size) break;
-          if (error(rel_cur->getTypeName(name))) goto skip_print_rel;
-          if (error(rel_cur->getValueString(val))) goto skip_print_rel;
-
-          outs() << format("\t\t\t%8" PRIx64 ": ", SectionAddr + addr) << name
-                 << "\t" << val << "\n";
-
-        skip_print_rel:
-          ++rel_cur;
-        }
+        PrintInlineRelocations(rel_cur, rel_end, Index + Size,
+                               SectionAddr); // @LOCALMOD
       }
     }
   }
@@ -14,6 +14,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryObject.h"
+#include <vector> // @LOCALMOD
 
 namespace llvm {
 
@@ -21,8 +22,10 @@ namespace object {
   class COFFObjectFile;
   class ObjectFile;
   class RelocationRef;
+  class SectionRef; // @LOCALMOD
 }
 class error_code;
+class raw_ostream; // @LOCALMOD
 
 extern cl::opt<std::string> TripleName;
 extern cl::opt<std::string> ArchName;
@@ -31,9 +34,15 @@ extern cl::opt<std::string> ArchName;
 bool error(error_code ec);
 bool RelocAddressLess(object::RelocationRef a, object::RelocationRef b);
 void DumpBytes(StringRef bytes);
+void DumpBytes(StringRef bytes, raw_ostream &OS); // @LOCALMOD
 void DisassembleInputMachO(StringRef Filename);
 void printCOFFUnwindInfo(const object::COFFObjectFile* o);
 void printELFFileHeader(const object::ObjectFile *o);
+// @LOCALMOD-BEGIN
+void getELFSymbolOffsets(const object::ObjectFile *o,
+                         const object::SectionRef &Section,
+                         std::vector<uint64_t> &Offsets);
+// @LOCALMOD-END
 
 class StringRefMemoryObject : public MemoryObject {
   virtual void anchor();
@@ -32,6 +32,12 @@ static cl::opt<bool>
 Verbose("verbose",cl::Optional,cl::init(false),
         cl::desc("Print the symbol table"));
 
+// @LOCALMOD-BEGIN
+static cl::opt<unsigned>
+Threads("j", cl::Prefix, cl::init(1), cl::value_desc("N"),
+        cl::desc("Use N threads to scan bitcode members for symbols"));
+// @LOCALMOD-END
+
 // printSymbolTable - print out the archive's symbol table.
 void printSymbolTable(Archive* TheArchive) {
   outs() << "\nArchive Symbol Table:\n";
@@ -86,7 +92,7 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  if (TheArchive->writeToDisk(true, false, &err_msg )) {
+  if (TheArchive->writeToDisk(true, false, &err_msg, Threads)) {
     errs() << argv[0] << ": " << err_msg << "\n";
     return 1;
   }
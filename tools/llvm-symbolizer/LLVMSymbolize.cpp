@@ -16,6 +16,7 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Path.h"
 
+#include <algorithm> // @LOCALMOD
 #include <sstream>
 
 namespace llvm {
@@ -44,8 +45,12 @@ static void patchFunctionNameInDILineInfo(const std::string &NewFunctionName,
                         LineInfo.getLine(), LineInfo.getColumn());
 }
 
-ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
-    : Module(Obj), DebugInfoContext(DICtx) {
+// @LOCALMOD-BEGIN
+ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx,
+                       ObjectFile *DebugObj, bool DebugInfoParsed)
+    : Module(Obj), DebugModule(DebugObj), DebugInfoParsed(DebugInfoParsed),
+      DebugInfoContext(DICtx) {
+// @LOCALMOD-END
   error_code ec;
   for (symbol_iterator si = Module->begin_symbols(), se = Module->end_symbols();
        si != se; si.increment(ec)) {
@@ -95,8 +100,14 @@ DILineInfo ModuleInfo::symbolizeCode(
     uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const {
   DILineInfo LineInfo;
   if (DebugInfoContext) {
+    // @LOCALMOD-BEGIN
+    if (!DebugInfoParsed)
+      DebugInfoLock.acquire();
     LineInfo = DebugInfoContext->getLineInfoForAddress(
         ModuleOffset, getDILineInfoSpecifierFlags(Opts));
+    if (!DebugInfoParsed)
+      DebugInfoLock.release();
+    // @LOCALMOD-END
   }
   // Override function name from symbol table if necessary.
   if (Opts.PrintFunctions && Opts.UseSymbolTable) {
@@ -110,12 +121,47 @@ DILineInfo ModuleInfo::symbolizeCode(
   return LineInfo;
 }
 
+// @LOCALMOD-BEGIN
+void ModuleInfo::symbolizeCode(ArrayRef<uint64_t> ModuleOffsets,
+                               const LLVMSymbolizer::Options &Opts,
+                               SmallVectorImpl<DILineInfo> &LineInfos) const {
+  unsigned First = LineInfos.size();
+  if (DebugInfoContext) {
+    if (!DebugInfoParsed)
+      DebugInfoLock.acquire();
+    DebugInfoContext->getLineInfoForAddresses(
+        ModuleOffsets, LineInfos, getDILineInfoSpecifierFlags(Opts));
+    if (!DebugInfoParsed)
+      DebugInfoLock.release();
+  } else {
+    LineInfos.append(ModuleOffsets.size(), DILineInfo());
+  }
+  // Override function names from symbol table if necessary.
+  if (Opts.PrintFunctions && Opts.UseSymbolTable) {
+    for (unsigned i = 0, e = ModuleOffsets.size(); i != e; ++i) {
+      std::string FunctionName;
+      uint64_t Start, Size;
+      if (getNameFromSymbolTable(SymbolRef::ST_Function, ModuleOffsets[i],
+                                 FunctionName, Start, Size)) {
+        patchFunctionNameInDILineInfo(FunctionName, LineInfos[First + i]);
+      }
+    }
+  }
+}
+// @LOCALMOD-END
+
 DIInliningInfo ModuleInfo::symbolizeInlinedCode(
     uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const {
   DIInliningInfo InlinedContext;
   if (DebugInfoContext) {
+    // @LOCALMOD-BEGIN
+    if (!DebugInfoParsed)
+      DebugInfoLock.acquire();
     InlinedContext = DebugInfoContext->getInliningInfoForAddress(
         ModuleOffset, getDILineInfoSpecifierFlags(Opts));
+    if (!DebugInfoParsed)
+      DebugInfoLock.release();
+    // @LOCALMOD-END
   }
   // Make sure there is at least one frame in context.
   if (InlinedContext.getNumberOfFrames() == 0) {
@@ -149,9 +195,75 @@ bool ModuleInfo::symbolizeData(uint64_t ModuleOffset, std::string &Name,
 
 const char LLVMSymbolizer::kBadString[] = "??";
 
+// @LOCALMOD-BEGIN
+struct LLVMSymbolizer::ModuleEntry {
+  ModuleMapTy::iterator MapPos;
+  std::list<ModuleEntry *>::iterator LRUPos;
+  ModuleInfo *Info;   // Null if the module is not a valid object file.
+  uint64_t Size;
+  unsigned Users;
+  // Held by the thread loading the module until the module is loaded.
+  sys::Mutex LoadLock;
+
+  ModuleEntry() : Info(0), Size(0), Users(0) {}
+  ~ModuleEntry() { delete Info; }
+};
+
+LLVMSymbolizer::ModuleRef::ModuleRef(LLVMSymbolizer &Symbolizer,
+                                     const std::string &ModuleName)
+    : Symbolizer(Symbolizer), Entry(Symbolizer.acquireModule(ModuleName)) {}
+
+LLVMSymbolizer::ModuleRef::~ModuleRef() {
+  Symbolizer.releaseModule(Entry);
+}
+
+ModuleInfo *LLVMSymbolizer::ModuleRef::get() const {
+  return Entry->Info;
+}
+
+LLVMSymbolizer::~LLVMSymbolizer() {
+  for (ModuleMapTy::iterator I = Modules.begin(), E = Modules.end(); I != E;
+       ++I)
+    delete I->second;
+}
+// @LOCALMOD-END
+
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
-  ModuleInfo *Info = getOrCreateModuleInfo(ModuleName);
+  // @LOCALMOD-BEGIN
+  ModuleRef Ref(*this, ModuleName);
+  return symbolizeCode(Ref.get(), ModuleOffset);
+}
+
+void LLVMSymbolizer::symbolizeCodeBatch(const std::string &ModuleName,
+                                        ArrayRef<uint64_t> ModuleOffsets,
+                                        std::vector<std::string> &Results) {
+  ModuleRef Ref(*this, ModuleName);
+  ModuleInfo *Info = Ref.get();
+  if (Info == 0 || Opts.PrintInlining) {
+    for (unsigned i = 0, e = ModuleOffsets.size(); i != e; ++i)
+      Results.push_back(symbolizeCode(Info, ModuleOffsets[i]));
+    return;
+  }
+  std::vector<std::pair<uint64_t, unsigned> > Sorted;
+  Sorted.reserve(ModuleOffsets.size());
+  for (unsigned i = 0, e = ModuleOffsets.size(); i != e; ++i)
+    Sorted.push_back(std::make_pair(ModuleOffsets[i], i));
+  std::sort(Sorted.begin(), Sorted.end());
+  SmallVector<uint64_t, 64> Addresses;
+  for (unsigned i = 0, e = Sorted.size(); i != e; ++i)
+    Addresses.push_back(Sorted[i].first);
+  SmallVector<DILineInfo, 64> LineInfos;
+  Info->symbolizeCode(Addresses, Opts, LineInfos);
+  unsigned First = Results.size();
+  Results.resize(First + Sorted.size());
+  for (unsigned i = 0, e = Sorted.size(); i != e; ++i)
+    Results[First + Sorted[i].second] = printDILineInfo(LineInfos[i]);
+}
+
+std::string LLVMSymbolizer::symbolizeCode(ModuleInfo *Info,
+                                          uint64_t ModuleOffset) const {
+  // @LOCALMOD-END
   if (Info == 0)
     return printDILineInfo(DILineInfo());
   if (Opts.PrintInlining) {
@@ -176,7 +288,8 @@ std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   uint64_t Start = 0;
   uint64_t Size = 0;
   if (Opts.UseSymbolTable) {
-    if (ModuleInfo *Info = getOrCreateModuleInfo(ModuleName)) {
+    ModuleRef Ref(*this, ModuleName); // @LOCALMOD
+    if (ModuleInfo *Info = Ref.get()) { // @LOCALMOD
       if (Info->symbolizeData(ModuleOffset, Name, Start, Size))
         DemangleName(Name);
     }
@@ -209,40 +322,109 @@ static std::string getDarwinDWARFResourceForModule(const std::string &Path) {
   return ResourceName.str();
 }
 
+// @LOCALMOD-BEGIN
 ModuleInfo *
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
-  ModuleMapTy::iterator I = Modules.find(ModuleName);
-  if (I != Modules.end())
-    return I->second;
-
+LLVMSymbolizer::createModuleInfo(const std::string &ModuleName,
+                                 uint64_t &Size) const {
+  // A module that failed to load still takes a cache entry.
+  Size = sizeof(ModuleEntry) + ModuleName.size();
   ObjectFile *Obj = getObjectFile(ModuleName);
   if (Obj == 0) {
     // Module name doesn't point to a valid object file.
-    Modules.insert(make_pair(ModuleName, (ModuleInfo *)0));
     return 0;
   }
+  Size += Obj->getData().size();
 
   DIContext *Context = 0;
+  ObjectFile *DbgObj = Obj;
+  bool DebugInfoParsed = false;
   bool IsLittleEndian;
   if (getObjectEndianness(Obj, IsLittleEndian)) {
     // On Darwin we may find DWARF in separate object file in
     // resource directory.
-    ObjectFile *DbgObj = Obj;
     if (isa<MachOObjectFile>(Obj)) {
       const std::string &ResourceName =
           getDarwinDWARFResourceForModule(ModuleName);
       ObjectFile *ResourceObj = getObjectFile(ResourceName);
-      if (ResourceObj != 0)
+      if (ResourceObj != 0) {
         DbgObj = ResourceObj;
+        Size += DbgObj->getData().size();
+      }
     }
     Context = DIContext::getDWARFContext(DbgObj);
     assert(Context);
+    // Answer queries from an address index cached next to the module.
+    if (Opts.UseAddressIndex)
+      Context->useAddressIndex(ModuleName + ".addrindex");
+    // Queries to a module whose debug info is all parsed do not need to
+    // lock each other out.
+    if (Opts.ParseDebugInfoOnLoad)
+      DebugInfoParsed = Context->parseAllDebugInfo();
+  }
+
+  return new ModuleInfo(Obj, Context, DbgObj != Obj ? DbgObj : 0,
+                        DebugInfoParsed);
+}
+
+LLVMSymbolizer::ModuleEntry *
+LLVMSymbolizer::acquireModule(const std::string &ModuleName) {
+  ModuleEntry *Entry;
+  bool Load = false;
+  {
+    sys::ScopedLock Guard(ModulesLock);
+    ModuleMapTy::iterator I = Modules.find(ModuleName);
+    if (I != Modules.end()) {
+      Entry = I->second;
+      ModuleLRU.splice(ModuleLRU.begin(), ModuleLRU, Entry->LRUPos);
+    } else {
+      Entry = new ModuleEntry();
+      // Other threads asking for the module wait on its lock until it is
+      // loaded. Modules that are already loaded can be used meanwhile.
+      Entry->LoadLock.acquire();
+      Entry->MapPos = Modules.insert(std::make_pair(ModuleName, Entry)).first;
+      ModuleLRU.push_front(Entry);
+      Entry->LRUPos = ModuleLRU.begin();
+      Load = true;
+    }
+    ++Entry->Users;
   }
 
-  ModuleInfo *Info = new ModuleInfo(Obj, Context);
-  Modules.insert(make_pair(ModuleName, Info));
-  return Info;
+  if (!Load) {
+    sys::ScopedLock Guard(Entry->LoadLock);
+    return Entry;
+  }
+
+  uint64_t Size;
+  Entry->Info = createModuleInfo(ModuleName, Size);
+  Entry->Size = Size;
+  Entry->LoadLock.release();
+  sys::ScopedLock Guard(ModulesLock);
+  CacheSize += Size;
+  evictModules();
+  return Entry;
+}
+
+void LLVMSymbolizer::releaseModule(ModuleEntry *Entry) {
+  sys::ScopedLock Guard(ModulesLock);
+  --Entry->Users;
+  evictModules();
+}
+
+void LLVMSymbolizer::evictModules() {
+  if (Opts.MaxCacheSize == 0)
+    return;
+  std::list<ModuleEntry *>::iterator I = ModuleLRU.end();
+  while (CacheSize > Opts.MaxCacheSize && I != ModuleLRU.begin()) {
+    ModuleEntry *Entry = *--I;
+    if (Entry->Users != 0)
+      continue;
+    CacheSize -= Entry->Size;
+    Modules.erase(Entry->MapPos);
+    I = ModuleLRU.erase(I);
+    delete Entry;
+  }
 }
+// @LOCALMOD-END
 
 std::string LLVMSymbolizer::printDILineInfo(DILineInfo LineInfo) const {
   // By default, DILineInfo contains "<invalid>" for function/filename it
@@ -17,8 +17,11 @@
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h" // @LOCALMOD
+#include <list> // @LOCALMOD
 #include <map>
 #include <string>
+#include <vector> // @LOCALMOD
 
 namespace llvm {
 
@@ -35,38 +38,102 @@ public:
     bool PrintFunctions : 1;
     bool PrintInlining : 1;
     bool Demangle : 1;
+    // @LOCALMOD-BEGIN
+    bool UseAddressIndex : 1;
+    // Modules that are not in use are evicted, least recently used first,
+    // while the cached modules take more than this many bytes. Zero means
+    // no limit.
+    uint64_t MaxCacheSize;
+    // Parse all debug info of a module when it is loaded. Queries to the
+    // module then run concurrently instead of one at a time.
+    bool ParseDebugInfoOnLoad;
     Options(bool UseSymbolTable = true, bool PrintFunctions = true,
-            bool PrintInlining = true, bool Demangle = true)
+            bool PrintInlining = true, bool Demangle = true,
+            bool UseAddressIndex = false, uint64_t MaxCacheSize = 0,
+            bool ParseDebugInfoOnLoad = false)
         : UseSymbolTable(UseSymbolTable), PrintFunctions(PrintFunctions),
-          PrintInlining(PrintInlining), Demangle(Demangle) {
+          PrintInlining(PrintInlining), Demangle(Demangle),
+          UseAddressIndex(UseAddressIndex), MaxCacheSize(MaxCacheSize),
+          ParseDebugInfoOnLoad(ParseDebugInfoOnLoad) {
     }
+    // @LOCALMOD-END
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
+  LLVMSymbolizer(const Options &Opts = Options())
+      : CacheSize(0), Opts(Opts) {} // @LOCALMOD
+  ~LLVMSymbolizer(); // @LOCALMOD
 
   // Returns the result of symbolization for module name/offset as
   // a string (possibly containing newlines).
+  // Both may be called from several threads at once. // @LOCALMOD
   std::string
   symbolizeCode(const std::string &ModuleName, uint64_t ModuleOffset);
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
+  // @LOCALMOD-BEGIN
+  // Appends the result of symbolizeCode for each of ModuleOffsets to
+  // Results. Without inlined frames the offsets are looked up in ascending
+  // order, so that the debug info answers them in one pass.
+  void symbolizeCodeBatch(const std::string &ModuleName,
+                          ArrayRef<uint64_t> ModuleOffsets,
+                          std::vector<std::string> &Results);
+  // @LOCALMOD-END
 private:
-  ModuleInfo *getOrCreateModuleInfo(const std::string &ModuleName);
+  // @LOCALMOD-BEGIN
+  std::string symbolizeCode(ModuleInfo *Info, uint64_t ModuleOffset) const;
+  struct ModuleEntry;
+  /// Returns the cache entry of a module, loading the module if needed. The
+  /// entry is not evicted until it is released.
+  ModuleEntry *acquireModule(const std::string &ModuleName);
+  void releaseModule(ModuleEntry *Entry);
+  /// Evicts unused modules until the cache fits in Opts.MaxCacheSize.
+  /// Requires ModulesLock.
+  void evictModules();
+  ModuleInfo *createModuleInfo(const std::string &ModuleName,
+                               uint64_t &Size) const;
+
+  /// ModuleRef - Keeps a module in the cache while a query uses it.
+  class ModuleRef {
+    LLVMSymbolizer &Symbolizer;
+    ModuleEntry *Entry;
+  public:
+    ModuleRef(LLVMSymbolizer &Symbolizer, const std::string &ModuleName);
+    ~ModuleRef();
+    /// Returns null if the module is not a valid object file.
+    ModuleInfo *get() const;
+  };
+  // @LOCALMOD-END
   std::string printDILineInfo(DILineInfo LineInfo) const;
   void DemangleName(std::string &Name) const;
 
-  typedef std::map<std::string, ModuleInfo *> ModuleMapTy;
+  // @LOCALMOD-BEGIN
+  typedef std::map<std::string, ModuleEntry *> ModuleMapTy;
   ModuleMapTy Modules;
+  // The entries of Modules, most recently used first.
+  std::list<ModuleEntry *> ModuleLRU;
+  // The total size of the loaded modules.
+  uint64_t CacheSize;
+  // Guards Modules, ModuleLRU, CacheSize and the use counts of the entries.
+  sys::Mutex ModulesLock;
+  // @LOCALMOD-END
   Options Opts;
   static const char kBadString[];
 };
 
 class ModuleInfo {
 public:
-  ModuleInfo(ObjectFile *Obj, DIContext *DICtx);
+  // @LOCALMOD-BEGIN
+  ModuleInfo(ObjectFile *Obj, DIContext *DICtx, ObjectFile *DebugObj = 0,
+             bool DebugInfoParsed = false);
+  // @LOCALMOD-END
 
   DILineInfo symbolizeCode(uint64_t ModuleOffset,
                            const LLVMSymbolizer::Options &Opts) const;
+  // @LOCALMOD-BEGIN
+  void symbolizeCode(ArrayRef<uint64_t> ModuleOffsets,
+                     const LLVMSymbolizer::Options &Opts,
+                     SmallVectorImpl<DILineInfo> &LineInfos) const;
+  // @LOCALMOD-END
   DIInliningInfo symbolizeInlinedCode(
       uint64_t ModuleOffset, const LLVMSymbolizer::Options &Opts) const;
   bool symbolizeData(uint64_t ModuleOffset, std::string &Name, uint64_t &Start,
@@ -77,6 +144,16 @@ private:
                               std::string &Name, uint64_t &Addr,
                               uint64_t &Size) const;
   OwningPtr<ObjectFile> Module;
+  // @LOCALMOD-BEGIN
+  // The object holding the debug info, if it is not Module.
+  OwningPtr<ObjectFile> DebugModule;
+  // Whether all debug info was parsed when the module was loaded, after
+  // which DebugInfoContext is not modified by queries.
+  bool DebugInfoParsed;
+  // DIContext parses debug info lazily, so queries are serialized unless
+  // DebugInfoParsed is set.
+  mutable sys::Mutex DebugInfoLock;
+  // @LOCALMOD-END
   OwningPtr<DIContext> DebugInfoContext;
 
   struct SymbolDesc {
@@ -22,10 +22,20 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/raw_ostream.h"
+#include <cerrno> // @LOCALMOD
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <vector> // @LOCALMOD
+// @LOCALMOD-BEGIN
+#if !defined(_MSC_VER) && !defined(__MINGW32__)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+// @LOCALMOD-END
 
 using namespace llvm;
 using namespace symbolize;
@@ -47,15 +57,64 @@ ClPrintInlining("inlining", cl::init(true),
 static cl::opt<bool>
 ClDemangle("demangle", cl::init(true), cl::desc("Demangle function names"));
 
-static bool parseCommand(bool &IsData, std::string &ModuleName,
-                         uint64_t &ModuleOffset) {
+// @LOCALMOD-BEGIN
+static cl::opt<bool>
+ClUseAddressIndex("address-index", cl::init(false),
+                  cl::desc("Answer queries from an address index cached in "
+                           "<module>.addrindex, creating it if needed"));
+
+static cl::opt<unsigned>
+ClThreads("j", cl::Prefix, cl::init(1), cl::value_desc("N"),
+          cl::desc("Answer up to N queries at once. Results are still "
+                   "printed in input order"));
+
+static cl::opt<unsigned>
+ClCacheSizeMB("cache-size-mb", cl::init(0), cl::value_desc("MB"),
+              cl::desc("Evict the least recently used modules while the "
+                       "loaded modules take more than MB megabytes "
+                       "(0 = no limit)"));
+
+namespace {
+/// SymbolizeQuery - One query read from the input.
+struct SymbolizeQuery {
+  bool IsData;
+  std::string ModuleName;
+  uint64_t ModuleOffset;
+};
+
+/// SymbolizeJob - Consecutive queries of a batch of the same kind and for
+/// the same module, answered together by one of the worker threads.
+struct SymbolizeJob {
+  LLVMSymbolizer *Symbolizer;
+  bool IsData;
+  std::string ModuleName;
+  std::vector<uint64_t> ModuleOffsets;
+  std::vector<std::string> Results;
+};
+}
+
+static void runSymbolizeJob(void *Data) {
+  SymbolizeJob *Job = static_cast<SymbolizeJob *>(Data);
+  Job->Results.clear();
+  if (!Job->IsData) {
+    Job->Symbolizer->symbolizeCodeBatch(Job->ModuleName, Job->ModuleOffsets,
+                                        Job->Results);
+    return;
+  }
+  for (unsigned i = 0, e = Job->ModuleOffsets.size(); i != e; ++i)
+    Job->Results.push_back(
+        Job->Symbolizer->symbolizeData(Job->ModuleName,
+                                       Job->ModuleOffsets[i]));
+}
+// @LOCALMOD-END
+
+// @LOCALMOD-BEGIN
+static bool parseCommand(char *InputString, bool &IsData,
+                         std::string &ModuleName, uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
   const char *kCodeCmd = "CODE ";
-  const int kMaxInputStringLength = 1024;
   const char kDelimiters[] = " \n";
-  char InputString[kMaxInputStringLength];
-  if (!fgets(InputString, sizeof(InputString), stdin))
-    return false;
+// @LOCALMOD-END
   IsData = false;
   ModuleName = "";
   std::string ModuleOffsetStr = "";
@@ -81,6 +140,76 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   return true;
 }
 
+// @LOCALMOD-BEGIN
+static bool parseCommand(bool &IsData, std::string &ModuleName,
+                         uint64_t &ModuleOffset) {
+  const int kMaxInputStringLength = 1024;
+  char InputString[kMaxInputStringLength];
+  if (!fgets(InputString, sizeof(InputString), stdin))
+    return false;
+  return parseCommand(InputString, IsData, ModuleName, ModuleOffset);
+}
+
+namespace {
+/// QueryReader - Reads queries from the standard input a chunk at a time,
+/// so that it can tell whether another query has already arrived.
+class QueryReader {
+  std::vector<char> Buffer;
+  size_t Begin, End;
+  bool AtEOF;
+public:
+  QueryReader() : Buffer(1 << 16), Begin(0), End(0), AtEOF(false) {}
+
+  /// Returns true if the next line can be read without waiting for input.
+  bool hasBufferedLine() const {
+    return memchr(&Buffer[0] + Begin, '\n', End - Begin) != 0 ||
+           (AtEOF && Begin != End);
+  }
+
+  /// Reads the next line into Line, waiting for input if needed. Returns
+  /// false at the end of the input.
+  bool readLine(std::vector<char> &Line);
+};
+}
+
+bool QueryReader::readLine(std::vector<char> &Line) {
+  while (true) {
+    const char *Start = &Buffer[0] + Begin;
+    const char *NewLine =
+        static_cast<const char *>(memchr(Start, '\n', End - Begin));
+    if (NewLine || (AtEOF && Begin != End)) {
+      const char *LineEnd = NewLine ? NewLine + 1 : &Buffer[0] + End;
+      Line.assign(Start, LineEnd);
+      Line.push_back('\0');
+      Begin += LineEnd - Start;
+      return true;
+    }
+    if (AtEOF)
+      return false;
+
+    // Move the partial line to the front and read more after it.
+    if (Begin != 0) {
+      memmove(&Buffer[0], &Buffer[0] + Begin, End - Begin);
+      End -= Begin;
+      Begin = 0;
+    }
+    if (End == Buffer.size())
+      Buffer.resize(Buffer.size() * 2);
+#if defined(_MSC_VER)
+    int NumRead = ::_read(0, &Buffer[End], unsigned(Buffer.size() - End));
+#else
+    ssize_t NumRead = ::read(0, &Buffer[End], Buffer.size() - End);
+#endif
+    if (NumRead < 0 && errno == EINTR)
+      continue;
+    if (NumRead <= 0)
+      AtEOF = true;
+    else
+      End += NumRead;
+  }
+}
+// @LOCALMOD-END
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -89,12 +218,76 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm symbolizer for compiler-rt\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle);
+                               ClPrintInlining, ClDemangle,
+                               ClUseAddressIndex,
+                               uint64_t(ClCacheSizeMB) << 20,
+                               ClThreads > 1); // @LOCALMOD
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
+  // @LOCALMOD-BEGIN
+  if (ClThreads > 1 || ClUseAddressIndex) {
+    // Read the queries in batches, answer each batch on the worker threads
+    // and print the results in input order. A batch ends early when no more
+    // queries have arrived, so that a client waiting for its results is not
+    // stalled.
+    const unsigned kBatchSize = 4096;
+    const unsigned NumThreads = ClThreads > 1 ? ClThreads : 1;
+    QueryReader Reader;
+    std::vector<char> Line;
+    std::vector<SymbolizeQuery> Queries(kBatchSize);
+    std::vector<SymbolizeJob> Jobs;
+    std::vector<void *> JobPtrs;
+    bool MoreInput = true;
+    while (MoreInput) {
+      unsigned NumQueries = 0;
+      while (NumQueries != kBatchSize) {
+        if (NumQueries != 0 && !Reader.hasBufferedLine())
+          break;
+        SymbolizeQuery &Query = Queries[NumQueries];
+        if (!Reader.readLine(Line) ||
+            !parseCommand(&Line[0], Query.IsData, Query.ModuleName,
+                          Query.ModuleOffset)) {
+          MoreInput = false;
+          break;
+        }
+        ++NumQueries;
+      }
+      // Queries for the same module are answered together, in one pass over
+      // its debug info, but each thread still gets a share of a batch that
+      // asks about a single module.
+      const unsigned MaxJobSize = (NumQueries + NumThreads - 1) / NumThreads;
+      unsigned NumJobs = 0;
+      for (unsigned i = 0; i != NumQueries; ++NumJobs) {
+        if (NumJobs == Jobs.size())
+          Jobs.push_back(SymbolizeJob());
+        SymbolizeJob &Job = Jobs[NumJobs];
+        Job.Symbolizer = &Symbolizer;
+        Job.IsData = Queries[i].IsData;
+        Job.ModuleName = Queries[i].ModuleName;
+        Job.ModuleOffsets.clear();
+        do
+          Job.ModuleOffsets.push_back(Queries[i++].ModuleOffset);
+        while (i != NumQueries && Job.ModuleOffsets.size() != MaxJobSize &&
+               Queries[i].IsData == Job.IsData &&
+               Queries[i].ModuleName == Job.ModuleName);
+      }
+      JobPtrs.clear();
+      for (unsigned i = 0; i != NumJobs; ++i)
+        JobPtrs.push_back(&Jobs[i]);
+      if (NumJobs != 0)
+        llvm_execute_on_threads(runSymbolizeJob, &JobPtrs[0], NumJobs,
+                                NumThreads);
+      for (unsigned i = 0; i != NumJobs; ++i)
+        for (unsigned j = 0, e = Jobs[i].Results.size(); j != e; ++j)
+          outs() << Jobs[i].Results[j] << "\n";
+      outs().flush();
+    }
+    return 0;
+  }
+  // @LOCALMOD-END
   while (parseCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
@@ -14,6 +14,8 @@
 
 #include "LTOCodeGenerator.h"
 #include "LTOModule.h"
+#include "LTOPartition.h" // @LOCALMOD
+#include "llvm/ADT/STLExtras.h" // @LOCALMOD
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/Verifier.h"
@@ -37,6 +39,7 @@
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h" // @LOCALMOD
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/Target/Mangler.h"
@@ -68,7 +71,7 @@ LTOCodeGenerator::LTOCodeGenerator()
     _linker("LinkTimeOptimizer", "ld-temp.o", _context), _target(NULL),
     _emitDwarfDebugInfo(false), _scopeRestrictionsDone(false),
     _codeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC),
-    _nativeObjectFile(NULL) {
+    _nativeObjectFile(NULL), _numPartitions(1) { // @LOCALMOD
   InitializeAllTargets();
   InitializeAllTargetMCs();
   InitializeAllAsmPrinters();
@@ -496,9 +499,9 @@ void LTOCodeGenerator::applyScopeRestrictions() {
   _scopeRestrictionsDone = true;
 }
 
+// @LOCALMOD-BEGIN
 /// Optimize merged modules using various IPO passes
-bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
-                                          std::string &errMsg) {
+bool LTOCodeGenerator::runOptimizationPasses(std::string &errMsg) {
   if (this->determineTarget(errMsg))
     return true;
 
@@ -533,6 +536,18 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   // Make sure everything is still good.
   passes.add(createVerifierPass());
 
+  // Run our queue of passes all at once now, efficiently.
+  passes.run(*mergedModule);
+  return false;
+}
+
+/// Optimize merged modules and generate one object file for them
+bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
+                                          std::string &errMsg) {
+  if (runOptimizationPasses(errMsg))
+    return true;
+
+  Module* mergedModule = _linker.getModule();
   FunctionPassManager *codeGenPasses = new FunctionPassManager(mergedModule);
 
   codeGenPasses->add(new DataLayout(*_target->getDataLayout()));
@@ -543,12 +558,10 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   if (_target->addPassesToEmitFile(*codeGenPasses, Out,
                                    TargetMachine::CGFT_ObjectFile)) {
     errMsg = "target file type not supported";
+    delete codeGenPasses;
     return true;
   }
 
-  // Run our queue of passes all at once now, efficiently.
-  passes.run(*mergedModule);
-
   // Run the code generator, and write assembly file
   codeGenPasses->doInitialization();
 
@@ -563,6 +576,171 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   return false; // success
 }
 
+/// Create another target machine like _target, for generating code on
+/// another thread.
+TargetMachine *LTOCodeGenerator::cloneTargetMachine() const {
+  return _target->getTarget().createTargetMachine(
+    _target->getTargetTriple(), _target->getTargetCPU(),
+    _target->getTargetFeatureString(), _target->Options,
+    _target->getRelocationModel(), _target->getCodeModel(),
+    _target->getOptLevel());
+}
+
+namespace {
+/// One partition of the merged module, compiled on a thread of its own.
+struct PartitionJob {
+  const LTOPartitioning *Partitioning;
+  unsigned Part;
+  StringRef Bitcode;
+  StringRef ModuleID;
+  TargetMachine *Target;
+  std::string Path;
+  std::string ErrMsg;
+};
+}
+
+/// Generate code for M into the object file Path.
+static bool emitObjectFile(Module &M, TargetMachine &Target,
+                           const std::string &Path, std::string &errMsg) {
+  tool_output_file objFile(Path.c_str(), errMsg, raw_fd_ostream::F_Binary);
+  if (!errMsg.empty())
+    return true;
+
+  {
+    formatted_raw_ostream Out(objFile.os());
+    FunctionPassManager codeGenPasses(&M);
+    codeGenPasses.add(new DataLayout(*Target.getDataLayout()));
+    Target.addAnalysisPasses(codeGenPasses);
+    if (Target.addPassesToEmitFile(codeGenPasses, Out,
+                                   TargetMachine::CGFT_ObjectFile)) {
+      errMsg = "target file type not supported";
+      return true;
+    }
+
+    codeGenPasses.doInitialization();
+    for (Module::iterator it = M.begin(), e = M.end(); it != e; ++it)
+      if (!it->isDeclaration())
+        codeGenPasses.run(*it);
+    codeGenPasses.doFinalization();
+  }
+
+  objFile.os().close();
+  if (objFile.os().has_error()) {
+    errMsg = "could not write object file: " + Path;
+    objFile.os().clear_error();
+    return true;
+  }
+  objFile.keep();
+  return false;
+}
+
+/// Read a copy of the merged module into a context of its own, reduce it to
+/// one partition and generate code for it. The copy is loaded lazily and only
+/// the partition's own function bodies are read, so the partitions together
+/// hold about one copy of the code rather than one copy each. Global
+/// variables and declarations are still read by every partition.
+static void generatePartition(void *Arg) {
+  PartitionJob &Job = *static_cast<PartitionJob*>(Arg);
+  LLVMContext Context;
+  MemoryBuffer *Buffer =
+    MemoryBuffer::getMemBuffer(Job.Bitcode, Job.ModuleID, false);
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, Context, &Job.ErrMsg));
+  if (!M) {
+    delete Buffer;
+    return;
+  }
+  if (Job.Partitioning->materialize(*M, Job.Part, Job.ErrMsg))
+    return;
+  Job.Partitioning->extract(*M, Job.Part);
+  emitObjectFile(*M, *Job.Target, Job.Path, Job.ErrMsg);
+}
+
+/// Optimize merged modules, split them into up to _numPartitions partitions
+/// and generate an object file for each partition on a thread of its own.
+/// The object files are the same for a given number of partitions.
+bool LTOCodeGenerator::generateObjectFiles(std::string &errMsg) {
+  if (runOptimizationPasses(errMsg))
+    return true;
+
+  Module* mergedModule = _linker.getModule();
+  LTOPartitioning Partitioning;
+  unsigned NumParts = 1;
+  if (_numPartitions > 1 && Partitioning.partition(*mergedModule,
+                                                   _numPartitions))
+    NumParts = Partitioning.getNumPartitions();
+
+  // make unique temp .o files to put generated object files
+  std::vector<PartitionJob> Jobs(NumParts);
+  for (unsigned i = 0; i != NumParts; ++i) {
+    sys::PathWithStatus uniqueObjPath("lto-llvm.o");
+    if (uniqueObjPath.createTemporaryFileOnDisk(false, &errMsg)) {
+      for (unsigned j = 0; j != i; ++j)
+        sys::Path(Jobs[j].Path).eraseFromDisk();
+      return true;
+    }
+    sys::RemoveFileOnSignal(uniqueObjPath);
+    Jobs[i].Path = uniqueObjPath.str();
+  }
+
+  if (NumParts == 1) {
+    if (emitObjectFile(*mergedModule, *_target, Jobs[0].Path, errMsg)) {
+      sys::Path(Jobs[0].Path).eraseFromDisk();
+      return true;
+    }
+  } else {
+    // Every partition starts from the same copy of the merged module.
+    std::string Bitcode;
+    raw_string_ostream OS(Bitcode);
+    WriteBitcodeToFile(mergedModule, OS);
+    OS.flush();
+
+    std::vector<TargetMachine*> Targets;
+    std::vector<void*> JobPtrs;
+    for (unsigned i = 0; i != NumParts; ++i) {
+      Targets.push_back(cloneTargetMachine());
+      Jobs[i].Partitioning = &Partitioning;
+      Jobs[i].Part = i;
+      Jobs[i].Bitcode = Bitcode;
+      Jobs[i].ModuleID = mergedModule->getModuleIdentifier();
+      Jobs[i].Target = Targets.back();
+      JobPtrs.push_back(&Jobs[i]);
+    }
+    llvm_execute_on_threads(generatePartition, &JobPtrs[0], NumParts,
+                            NumParts);
+    DeleteContainerPointers(Targets);
+
+    for (unsigned i = 0; i != NumParts; ++i) {
+      if (Jobs[i].ErrMsg.empty())
+        continue;
+      errMsg = Jobs[i].ErrMsg;
+      for (unsigned j = 0; j != NumParts; ++j)
+        sys::Path(Jobs[j].Path).eraseFromDisk();
+      return true;
+    }
+  }
+
+  _nativeObjectPaths.clear();
+  for (unsigned i = 0; i != NumParts; ++i)
+    _nativeObjectPaths.push_back(Jobs[i].Path);
+  return false;
+}
+
+/// Generate code for all added modules into one native object file for each
+/// partition. The names of the files are owned by this LTOCodeGenerator.
+bool LTOCodeGenerator::compile_to_files(const char ***names, unsigned *num,
+                                        std::string &errMsg) {
+  if (generateObjectFiles(errMsg))
+    return true;
+
+  _nativeObjectNames.clear();
+  for (unsigned i = 0, e = _nativeObjectPaths.size(); i != e; ++i)
+    _nativeObjectNames.push_back(_nativeObjectPaths[i].c_str());
+  *names = &_nativeObjectNames[0];
+  *num = _nativeObjectNames.size();
+  return false;
+}
+// @LOCALMOD-END
+
 /// setCodeGenDebugOptions - Set codegen debugging options to aid in debugging
 /// LTO problems.
 void LTOCodeGenerator::setCodeGenDebugOptions(const char *options) {
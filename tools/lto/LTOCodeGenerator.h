@@ -70,9 +70,19 @@ struct LTOCodeGenerator {
   bool compile_to_file(const char **name, std::string &errMsg);
   const void *compile(size_t *length, std::string &errMsg);
   void setCodeGenDebugOptions(const char *opts);
+  // @LOCALMOD-BEGIN
+  void setNumPartitions(unsigned num) { _numPartitions = num; }
+  bool compile_to_files(const char ***names, unsigned *num,
+                        std::string &errMsg);
+  // @LOCALMOD-END
 
 private:
   bool generateObjectFile(llvm::raw_ostream &out, std::string &errMsg);
+  // @LOCALMOD-BEGIN
+  bool runOptimizationPasses(std::string &errMsg);
+  bool generateObjectFiles(std::string &errMsg);
+  llvm::TargetMachine *cloneTargetMachine() const;
+  // @LOCALMOD-END
   void applyScopeRestrictions();
   void applyRestriction(llvm::GlobalValue &GV,
                         std::vector<const char*> &mustPreserveList,
@@ -95,8 +105,12 @@ private:
   std::string                 _mCpu;
   std::string                 _nativeObjectPath;
 
-  // @LOCALMOD
+  // @LOCALMOD-BEGIN
   std::vector<LTOModule*> _gatheredModules;
+  unsigned                    _numPartitions;
+  std::vector<std::string>    _nativeObjectPaths;
+  std::vector<const char*>    _nativeObjectNames;
+  // @LOCALMOD-END
 };
 
 #endif // LTO_CODE_GENERATOR_H
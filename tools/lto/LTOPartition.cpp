@@ -0,0 +1,308 @@
+//===-LTOPartition.cpp - LLVM Link Time Optimizer -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the LTOPartitioning class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LTOPartition.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CallSite.h"
+using namespace llvm;
+
+static const unsigned NoPartition = ~0U;
+
+typedef SmallVector<const GlobalValue*, 16> GlobalRefList;
+
+// Add the globals that C refers to, directly or through other constants, to
+// Refs, and the functions of the blockaddresses among them to BlockAddrRefs.
+static void collectConstantRefs(const Constant *C, GlobalRefList &Refs,
+                                GlobalRefList &BlockAddrRefs,
+                                SmallPtrSet<const Constant*, 32> &Visited) {
+  SmallVector<const Constant*, 8> Worklist(1, C);
+  while (!Worklist.empty()) {
+    C = Worklist.pop_back_val();
+    if (const GlobalValue *GV = dyn_cast<GlobalValue>(C)) {
+      Refs.push_back(GV);
+      continue;
+    }
+    if (!Visited.insert(C))
+      continue;
+    if (const BlockAddress *BA = dyn_cast<BlockAddress>(C))
+      BlockAddrRefs.push_back(BA->getFunction());
+    for (User::const_op_iterator I = C->op_begin(), E = C->op_end(); I != E;
+         ++I)
+      if (const Constant *Op = dyn_cast<Constant>(*I))
+        Worklist.push_back(Op);
+  }
+}
+
+// Collect the globals that the definition GV refers to, in the order in which
+// they appear in its body, initializer or aliasee.
+static void collectRefs(const GlobalValue &GV, GlobalRefList &Refs,
+                        GlobalRefList &BlockAddrRefs) {
+  SmallPtrSet<const Constant*, 32> Visited;
+  if (const Function *F = dyn_cast<Function>(&GV)) {
+    for (Function::const_iterator BB = F->begin(), BE = F->end(); BB != BE;
+         ++BB)
+      for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+           I != IE; ++I)
+        for (User::const_op_iterator OI = I->op_begin(), OE = I->op_end();
+             OI != OE; ++OI)
+          if (const Constant *C = dyn_cast<Constant>(*OI))
+            collectConstantRefs(C, Refs, BlockAddrRefs, Visited);
+  } else if (const GlobalVariable *V = dyn_cast<GlobalVariable>(&GV)) {
+    if (V->hasInitializer())
+      collectConstantRefs(V->getInitializer(), Refs, BlockAddrRefs, Visited);
+  } else if (const GlobalAlias *A = dyn_cast<GlobalAlias>(&GV)) {
+    collectConstantRefs(A->getAliasee(), Refs, BlockAddrRefs, Visited);
+  }
+}
+
+// Return the number of instructions in F, which stands for the time it takes
+// to generate code for it.
+static unsigned getFunctionWeight(const Function &F) {
+  unsigned Weight = 1;
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    Weight += BB->size();
+  return Weight;
+}
+
+bool LTOPartitioning::partition(Module &M, unsigned NumPartitions) {
+  DenseMap<const GlobalValue*, unsigned> Owners;
+
+  // Order the defined functions depth first along direct calls, starting
+  // from each function in module order, so that callees tend to share the
+  // partition of their first caller.
+  std::vector<const Function*> Order;
+  uint64_t TotalWeight = 0;
+  {
+    SmallPtrSet<const Function*, 64> Visited;
+    SmallVector<const Function*, 16> Stack;
+    SmallVector<const Function*, 16> Callees;
+    for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F) {
+      if (F->isDeclaration())
+        continue;
+      Stack.push_back(F);
+      while (!Stack.empty()) {
+        const Function *Fn = Stack.pop_back_val();
+        if (!Visited.insert(Fn))
+          continue;
+        Order.push_back(Fn);
+        TotalWeight += getFunctionWeight(*Fn);
+        Callees.clear();
+        for (Function::const_iterator BB = Fn->begin(), BE = Fn->end();
+             BB != BE; ++BB)
+          for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+               I != IE; ++I) {
+            ImmutableCallSite CS(I);
+            if (!CS)
+              continue;
+            const Function *Callee = CS.getCalledFunction();
+            if (Callee && !Callee->isDeclaration() && !Visited.count(Callee))
+              Callees.push_back(Callee);
+          }
+        // Visit the first callee next.
+        Stack.append(Callees.rbegin(), Callees.rend());
+      }
+    }
+  }
+
+  // Cut the order into pieces of about the same weight. A function heavier
+  // than a piece leaves the following pieces empty; they are dropped below.
+  if (NumPartitions > Order.size())
+    NumPartitions = Order.size();
+  if (NumPartitions < 2)
+    return false;
+  {
+    uint64_t Weight = 0;
+    for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+      Owners[Order[i]] = unsigned(Weight * NumPartitions / TotalWeight);
+      Weight += getFunctionWeight(*Order[i]);
+    }
+  }
+
+  // Global variables go with the first function that uses them, or with the
+  // first global variable that does. Appending variables like
+  // llvm.global_ctors, and variables nothing uses, go with the first
+  // partition.
+  std::vector<const GlobalValue*> Worklist(Order.begin(), Order.end());
+  for (Module::const_global_iterator V = M.global_begin(),
+       E = M.global_end(); V != E; ++V)
+    if (V->hasAppendingLinkage()) {
+      Owners[V] = 0;
+      Worklist.push_back(V);
+    }
+  for (unsigned i = 0; i != Worklist.size(); ++i) {
+    GlobalRefList Refs, BlockAddrRefs;
+    collectRefs(*Worklist[i], Refs, BlockAddrRefs);
+    unsigned Owner = Owners.lookup(Worklist[i]);
+    for (unsigned j = 0, e = Refs.size(); j != e; ++j) {
+      const GlobalVariable *V = dyn_cast<GlobalVariable>(Refs[j]);
+      if (V && !V->isDeclaration() && !Owners.count(V)) {
+        Owners[V] = Owner;
+        Worklist.push_back(V);
+      }
+    }
+  }
+  for (Module::const_global_iterator V = M.global_begin(),
+       E = M.global_end(); V != E; ++V)
+    if (!V->isDeclaration() && !Owners.count(V))
+      Owners[V] = 0;
+
+  // An alias must be defined with its aliasee.
+  for (Module::const_alias_iterator A = M.alias_begin(), E = M.alias_end();
+       A != E; ++A) {
+    const GlobalValue *Aliasee = A->resolveAliasedGlobal(false);
+    Owners[A] = Aliasee ? Owners.lookup(Aliasee) : 0;
+  }
+
+  // Renumber the partitions that received definitions.
+  std::vector<unsigned> Renumber(NumPartitions, NoPartition);
+  _numPartitions = 0;
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    unsigned &Part = Renumber[Owners[Order[i]]];
+    if (Part == NoPartition)
+      Part = _numPartitions++;
+  }
+  if (_numPartitions < 2)
+    return false;
+  for (DenseMap<const GlobalValue*, unsigned>::iterator I = Owners.begin(),
+       E = Owners.end(); I != E; ++I)
+    I->second = Renumber[I->second];
+
+  // Find the local symbols used outside of their partition. A blockaddress
+  // can not refer to a function in another module, so give up if one does.
+  SmallPtrSet<const GlobalValue*, 32> Promote;
+  for (DenseMap<const GlobalValue*, unsigned>::iterator I = Owners.begin(),
+       E = Owners.end(); I != E; ++I) {
+    GlobalRefList Refs, BlockAddrRefs;
+    collectRefs(*I->first, Refs, BlockAddrRefs);
+    for (unsigned j = 0, e = BlockAddrRefs.size(); j != e; ++j)
+      if (Owners.lookup(BlockAddrRefs[j]) != I->second)
+        return false;
+    for (unsigned j = 0, e = Refs.size(); j != e; ++j)
+      if (Refs[j]->hasLocalLinkage() && Owners.lookup(Refs[j]) != I->second)
+        Promote.insert(Refs[j]);
+  }
+
+  // Record the assignment by position and promote the local symbols, in
+  // module order so that the new names do not depend on the order above.
+  _functionOwners.clear();
+  _globalOwners.clear();
+  _aliasOwners.clear();
+  SmallVector<GlobalValue*, 16> ToPromote;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    _functionOwners.push_back(F->isDeclaration() ? NoPartition : Owners[F]);
+    if (Promote.count(F))
+      ToPromote.push_back(F);
+  }
+  for (Module::global_iterator V = M.global_begin(), E = M.global_end();
+       V != E; ++V) {
+    _globalOwners.push_back(V->isDeclaration() ? NoPartition : Owners[V]);
+    if (Promote.count(V))
+      ToPromote.push_back(V);
+  }
+  for (Module::alias_iterator A = M.alias_begin(), E = M.alias_end(); A != E;
+       ++A) {
+    _aliasOwners.push_back(Owners[A]);
+    if (Promote.count(A))
+      ToPromote.push_back(A);
+  }
+  for (unsigned i = 0, e = ToPromote.size(); i != e; ++i) {
+    GlobalValue *GV = ToPromote[i];
+    // Keep the symbol from clashing with globals of the same name in other
+    // objects; setName makes it unique within the module.
+    if (GV->hasName())
+      GV->setName(GV->getName() + ".lto_priv");
+    else
+      GV->setName("__lto_priv");
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+  }
+  return true;
+}
+
+bool LTOPartitioning::materialize(Module &M, unsigned Part,
+                                  std::string &ErrMsg) const {
+  unsigned i = 0;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F, ++i)
+    if (_functionOwners[i] == Part && F->Materialize(&ErrMsg))
+      return true;
+  return false;
+}
+
+void LTOPartitioning::extract(Module &M, unsigned Part) const {
+  std::vector<GlobalValue*> Dead;
+
+  unsigned i = 0;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F, ++i) {
+    if (_functionOwners[i] == NoPartition || _functionOwners[i] == Part)
+      continue;
+    if (F->hasLocalLinkage())
+      Dead.push_back(F);
+    F->deleteBody();
+  }
+
+  i = 0;
+  for (Module::global_iterator V = M.global_begin(), E = M.global_end();
+       V != E; ++V, ++i) {
+    if (_globalOwners[i] == NoPartition || _globalOwners[i] == Part)
+      continue;
+    V->setInitializer(0);
+    if (V->hasLocalLinkage() || V->hasAppendingLinkage())
+      Dead.push_back(V);
+    else
+      V->setLinkage(GlobalValue::ExternalLinkage);
+  }
+
+  // An alias can not be a declaration, so replace the aliases that code in
+  // this partition still uses with declarations of the same name.
+  i = 0;
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end(); I != E;
+       ++i) {
+    GlobalAlias *A = I++;
+    if (_aliasOwners[i] == Part)
+      continue;
+    A->removeDeadConstantUsers();
+    if (!A->use_empty()) {
+      PointerType *Ty = A->getType();
+      GlobalValue *Decl;
+      if (FunctionType *FTy = dyn_cast<FunctionType>(Ty->getElementType()))
+        Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", &M);
+      else
+        Decl = new GlobalVariable(M, Ty->getElementType(), false,
+                                  GlobalValue::ExternalLinkage, 0, "", 0,
+                                  GlobalVariable::NotThreadLocal,
+                                  Ty->getAddressSpace());
+      Decl->setVisibility(A->getVisibility());
+      Decl->takeName(A);
+      A->replaceAllUsesWith(Decl);
+    }
+    A->eraseFromParent();
+  }
+
+  // Nothing in this partition refers to the local symbols of other
+  // partitions any more, except through constants that are now dead.
+  for (unsigned i = 0, e = Dead.size(); i != e; ++i) {
+    GlobalValue *GV = Dead[i];
+    GV->removeDeadConstantUsers();
+    assert(GV->use_empty() && "Local symbol used outside of its partition");
+    GV->eraseFromParent();
+  }
+
+  if (Part != 0)
+    M.setModuleInlineAsm("");
+}
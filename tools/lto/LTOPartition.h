@@ -0,0 +1,67 @@
+//===-LTOPartition.h - LLVM Link Time Optimizer ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the LTOPartitioning class, which splits the optimized
+// merged module into pieces that are compiled in parallel.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LTO_PARTITION_H
+#define LTO_PARTITION_H
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Module;
+}
+
+//===----------------------------------------------------------------------===//
+/// LTOPartitioning - Assigns every definition of a module to one of several
+/// partitions. Functions are ordered so that callees follow their callers and
+/// the order is cut into pieces with about the same number of instructions.
+/// Global variables go with the first function that uses them and aliases go
+/// with their aliasee.
+///
+/// The assignment refers to globals by their position in the module, so it
+/// applies to copies of the module in other contexts, e.g. ones read back
+/// from bitcode.
+///
+struct LTOPartitioning {
+  LTOPartitioning() : _numPartitions(1) {}
+
+  /// partition - Assign the definitions in M to up to NumPartitions
+  /// partitions. Local symbols referenced from another partition than their
+  /// own are renamed and made hidden globals so that the partitions can be
+  /// linked together. Returns false and leaves M alone if M can not be
+  /// split, e.g. because a blockaddress refers to a function in another
+  /// partition. The assignment only depends on M and NumPartitions.
+  bool partition(llvm::Module &M, unsigned NumPartitions);
+
+  /// materialize - Read the function bodies of partition Part into M, a
+  /// lazily loaded copy of the module passed to partition(). The bodies of
+  /// other partitions are left unread, so each partition only holds its own
+  /// code in memory. Returns true and sets ErrMsg on error.
+  bool materialize(llvm::Module &M, unsigned Part, std::string &ErrMsg) const;
+
+  /// extract - Reduce M, a copy of the module passed to partition(), to the
+  /// definitions of partition Part. Definitions of other partitions become
+  /// declarations and unused local symbols are removed.
+  void extract(llvm::Module &M, unsigned Part) const;
+
+  unsigned getNumPartitions() const { return _numPartitions; }
+
+private:
+  unsigned                    _numPartitions;
+  std::vector<unsigned>       _functionOwners;
+  std::vector<unsigned>       _globalOwners;
+  std::vector<unsigned>       _aliasOwners;
+};
+
+#endif // LTO_PARTITION_H
@@ -347,6 +347,22 @@ bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
   return cg->compile_to_file(name, sLastErrorString);
 }
 
+// @LOCALMOD-BEGIN
+/// lto_codegen_set_num_partitions - Sets the number of partitions that
+/// lto_codegen_compile_to_files() splits the merged module into.
+void lto_codegen_set_num_partitions(lto_code_gen_t cg, unsigned num) {
+  cg->setNumPartitions(num);
+}
+
+/// lto_codegen_compile_to_files - Generates code for all added modules into
+/// one native object file per partition. The names of the files are written
+/// to names and their number to num. Returns true on error.
+bool lto_codegen_compile_to_files(lto_code_gen_t cg, const char ***names,
+                                  unsigned *num) {
+  return cg->compile_to_files(names, num, sLastErrorString);
+}
+// @LOCALMOD-END
+
 /// lto_codegen_debug_options - Used to pass extra options to the code
 /// generator.
 void lto_codegen_debug_options(lto_code_gen_t cg, const char *opt) {
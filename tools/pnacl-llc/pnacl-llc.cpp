@@ -42,6 +42,19 @@
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/NaCl.h"
 #include <memory>
+// @LOCALMOD-BEGIN
+#include "llvm/Config/config.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#if !defined(__native_client__) && defined(LLVM_ON_UNIX)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+// @LOCALMOD-END
 
 
 using namespace llvm;
@@ -143,6 +156,22 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
 
 static int compileModule(char**, LLVMContext&);
 
+// @LOCALMOD-BEGIN
+// Translator server mode. The server pays for target and pass registration
+// once, then reads one translation command line per line of stdin and runs
+// each in a child forked from the initialized process. Options given on the
+// server's own command line apply to every request.
+static cl::opt<bool>
+ServerMode("server",
+  cl::desc("Read translation command lines from stdin, one per line"),
+  cl::init(false));
+
+static cl::opt<unsigned>
+ServerJobs("server-jobs",
+  cl::desc("Number of translations the server runs concurrently"),
+  cl::value_desc("N"), cl::init(1u));
+// @LOCALMOD-END
+
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
 GetFileNameRoot(const std::string &InputFilename) {
@@ -221,6 +250,152 @@ static tool_output_file *GetOutputStream(const char *TargetName,
   return FDOut;
 }
 
+// @LOCALMOD-BEGIN
+// Compile the module TimeCompilations times to give better compile time
+// metrics.
+static int compileRepeatedly(char **argv, LLVMContext &Context) {
+  for (unsigned I = TimeCompilations; I; --I) {
+    if (int RetVal = compileModule(argv, Context))
+      return RetVal;
+    // The module is gone; keep the context's tables warm for the next one.
+    Context.resetModuleState();
+  }
+  return 0;
+}
+
+#if !defined(__native_client__) && defined(LLVM_ON_UNIX)
+// Read one line from the file descriptor FD into Line, without the newline.
+// Returns false at the end of the input. This reads the descriptor directly:
+// children inherit any stdio buffer and could move the shared offset of a
+// seekable stdin when they exit.
+static bool readRequestLine(int FD, std::string &Pending, std::string &Line) {
+  for (;;) {
+    std::string::size_type NL = Pending.find('\n');
+    if (NL != std::string::npos) {
+      Line = Pending.substr(0, NL);
+      Pending.erase(0, NL + 1);
+      return true;
+    }
+    char Buf[4096];
+    ssize_t N = read(FD, Buf, sizeof(Buf));
+    if (N < 0 && errno == EINTR)
+      continue;
+    if (N <= 0) {
+      Line.swap(Pending);
+      Pending.clear();
+      return !Line.empty();
+    }
+    Pending.append(Buf, N);
+  }
+}
+
+// Wait for one translation child and report "<request> <status>" on stdout.
+// Returns false if the translation failed.
+static bool reapTranslation(std::map<pid_t, unsigned> &Running) {
+  int Status = 0;
+  pid_t Pid;
+  do
+    Pid = waitpid(-1, &Status, 0);
+  while (Pid < 0 && errno == EINTR);
+  if (Pid < 0) {
+    Running.clear();
+    return false;
+  }
+  std::map<pid_t, unsigned>::iterator I = Running.find(Pid);
+  if (I == Running.end())
+    return true;
+  int Code = WIFEXITED(Status) ? WEXITSTATUS(Status)
+                               : 128 + WTERMSIG(Status);
+  outs() << I->second << ' ' << Code << '\n';
+  outs().flush();
+  Running.erase(I);
+  return Code == 0;
+}
+
+// Registered with atexit in each translation child. A child that leaves
+// through exit(), e.g. on a bad option in its request or a fatal error, ends
+// here with _exit before the server's atexit handlers and static destructors
+// can run or the stdio buffers it inherited are flushed a second time.
+static void exitTranslationChild() {
+  outs().flush();
+  errs().flush();
+  _exit(1);
+}
+
+// Each request is a whitespace-separated pnacl-llc command line without the
+// program name, e.g. "-mtriple=x86_64-unknown-nacl a.pexe -o a.o". Its output
+// file must be named since stdout carries the server's replies. The request's
+// options are parsed in the child only, so requests cannot affect each other;
+// options from the server's own command line serve as defaults.
+static int runServer(char **argv, LLVMContext &Context) {
+  std::map<pid_t, unsigned> Running;
+  unsigned Jobs = ServerJobs ? ServerJobs : 1;
+  unsigned RequestNo = 0;
+  bool Failed = false;
+  std::string Pending, Line;
+  while (readRequestLine(0, Pending, Line)) {
+    std::vector<std::string> Args;
+    std::string::size_type Pos = 0;
+    while ((Pos = Line.find_first_not_of(" \t\r", Pos)) != std::string::npos) {
+      std::string::size_type End = Line.find_first_of(" \t\r", Pos);
+      Args.push_back(Line.substr(Pos, End - Pos));
+      Pos = End;
+    }
+    if (Args.empty())
+      continue;
+    ++RequestNo;
+
+    while (Running.size() >= Jobs)
+      Failed |= !reapTranslation(Running);
+
+    outs().flush();
+    errs().flush();
+    pid_t Pid = fork();
+    if (Pid == 0) {
+      atexit(exitTranslationChild);
+      std::vector<char *> ChildArgv;
+      ChildArgv.push_back(argv[0]);
+      for (unsigned i = 0, e = Args.size(); i != e; ++i)
+        ChildArgv.push_back(const_cast<char *>(Args[i].c_str()));
+      ChildArgv.push_back(0);
+      close(0);
+      // The options given on the server's command line are defaults that the
+      // request may override.
+      cl::ResetAllOptionOccurrences();
+      cl::ParseCommandLineOptions(ChildArgv.size() - 1, &ChildArgv[0],
+                                  "llvm system compiler\n");
+      int RetVal = compileRepeatedly(&ChildArgv[0], Context);
+      // Do not return through main: the child must not run the server's
+      // static destructors or flush stdio buffers it inherited. Shutting
+      // LLVM down still prints this request's -stats and timers.
+      llvm_shutdown();
+      outs().flush();
+      errs().flush();
+      _exit(RetVal);
+    }
+    if (Pid < 0) {
+      errs() << argv[0] << ": cannot start translation: "
+             << strerror(errno) << '\n';
+      outs() << RequestNo << " 1\n";
+      outs().flush();
+      Failed = true;
+      continue;
+    }
+    Running[Pid] = RequestNo;
+  }
+
+  while (!Running.empty())
+    Failed |= !reapTranslation(Running);
+  return Failed ? 1 : 0;
+}
+#else
+static int runServer(char **argv, LLVMContext &Context) {
+  errs() << argv[0] << ": -server is not supported on this host\n";
+  return 1;
+}
+#endif
+// @LOCALMOD-END
+
 // main - Entry point for the llc compiler.
 //
 int llc_main(int argc, char **argv) {
@@ -266,12 +441,12 @@ int llc_main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
-  // Compile the module TimeCompilations times to give better compile time
-  // metrics.
-  for (unsigned I = TimeCompilations; I; --I)
-    if (int RetVal = compileModule(argv, Context))
-      return RetVal;
-  return 0;
+  // @LOCALMOD-BEGIN
+  if (ServerMode)
+    return runServer(argv, Context);
+
+  return compileRepeatedly(argv, Context);
+  // @LOCALMOD-END
 }
 
 // @LOCALMOD-BEGIN
@@ -317,7 +492,17 @@ static int compileModule(char **argv, LLVMContext &Context) {
       llvm_unreachable("native client SRPC only supports streaming");
     }
 #else
-    {
+    if (LazyBitcode && InputFileFormat == PNaClFormat) {
+      // Stream function bodies from the file as the sandboxed translator
+      // does, so that they can be released once they are translated.
+      std::string StrError;
+      DataStreamer *Streamer = getDataFileStreamer(InputFilename, &StrError);
+      if (Streamer)
+        M.reset(getNaClStreamedBitcodeModule(InputFilename, Streamer,
+                                             Context, &StrError));
+      if (!StrError.empty())
+        Err = SMDiagnostic(InputFilename, SourceMgr::DK_Error, StrError);
+    } else {
       // @LOCALMOD: timing is temporary, until it gets properly added upstream
       NamedRegionTimer T(TimeIRParsingName, TimeIRParsingGroupName,
                          TimeIRParsingIsEnabled);
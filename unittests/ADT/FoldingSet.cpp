@@ -14,6 +14,7 @@
 #include "gtest/gtest.h"
 #include "llvm/ADT/FoldingSet.h"
 #include <string>
+#include <vector> // @LOCALMOD
 
 using namespace llvm;
 
@@ -35,5 +36,43 @@ TEST(FoldingSetTest, UnalignedStringTest) {
   EXPECT_EQ(a.ComputeHash(), b.ComputeHash());
 }
 
+// @LOCALMOD-BEGIN
+struct TrivialPair : public FoldingSetNode {
+  unsigned Key;
+  explicit TrivialPair(unsigned K) : Key(K) {}
+  void Profile(FoldingSetNodeID &ID) const { ID.AddInteger(Key); }
+};
+
+TEST(FoldingSetTest, ClearAndResize) {
+  FoldingSet<TrivialPair> Set;
+  std::vector<TrivialPair> Nodes;
+  for (unsigned i = 0; i != 5000; ++i)
+    Nodes.push_back(TrivialPair(i));
+  for (unsigned i = 0; i != 5000; ++i)
+    Set.InsertNode(&Nodes[i]);
+  EXPECT_EQ(5000u, Set.size());
+  EXPECT_LE(5000u, Set.capacity());
+
+  // Shrink the table, then check that it is empty and still grows as needed.
+  Set.clearAndResize(100);
+  EXPECT_TRUE(Set.empty());
+  EXPECT_EQ(128u, Set.capacity());
+  for (unsigned i = 0; i != 1000; ++i) {
+    Nodes[i].SetNextInBucket(0);
+    Set.InsertNode(&Nodes[i]);
+  }
+  EXPECT_EQ(1000u, Set.size());
+  FoldingSetNodeID ID;
+  ID.AddInteger(999u);
+  void *InsertPos;
+  EXPECT_EQ(&Nodes[999], Set.FindNodeOrInsertPos(ID, InsertPos));
+
+  // Sizing for more nodes than currently fit grows the table up front.
+  Set.clearAndResize(3000);
+  EXPECT_TRUE(Set.empty());
+  EXPECT_LE(3000u, Set.capacity());
+}
+// @LOCALMOD-END
+
 }
 
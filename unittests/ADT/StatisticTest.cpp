@@ -0,0 +1,96 @@
+//===- StatisticTest.cpp - Statistic unit tests ---------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "unittest"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Threading.h"
+#include "gtest/gtest.h"
+#include <cstring>
+using namespace llvm;
+
+STATISTIC(Counter, "Counts things");
+STATISTIC(Other, "Counts other things");
+
+namespace {
+
+unsigned lookup(const std::vector<StatisticSnapshot> &Values,
+                const char *Desc) {
+  for (unsigned i = 0, e = Values.size(); i != e; ++i)
+    if (std::strcmp(Values[i].Desc, Desc) == 0)
+      return Values[i].Value;
+  return 0;
+}
+
+void bumpCounter(void *Arg) {
+  unsigned N = *static_cast<unsigned*>(Arg);
+  for (unsigned i = 0; i != N; ++i)
+    ++Counter;
+}
+
+TEST(StatisticTest, Count) {
+  ResetStatistics();
+  EXPECT_EQ(0u, Counter);
+
+  ++Counter;
+  Counter += 4;
+  --Counter;
+  EXPECT_EQ(4u, Counter);
+
+  Counter = 10;
+  EXPECT_EQ(10u, Counter);
+  Counter *= 3;
+  EXPECT_EQ(30u, Counter);
+  Counter /= 5;
+  EXPECT_EQ(6u, Counter);
+}
+
+TEST(StatisticTest, SnapshotAndReset) {
+  ResetStatistics();
+  Counter += 2;
+  Other += 3;
+
+  std::vector<StatisticSnapshot> Values;
+  GetStatistics(Values);
+  EXPECT_EQ(2u, lookup(Values, "Counts things"));
+  EXPECT_EQ(3u, lookup(Values, "Counts other things"));
+
+  ResetStatistics();
+  EXPECT_EQ(0u, Counter);
+  EXPECT_EQ(0u, Other);
+  GetStatistics(Values);
+  EXPECT_EQ(0u, lookup(Values, "Counts things"));
+}
+
+TEST(StatisticTest, Threads) {
+  ResetStatistics();
+  unsigned N = 1000;
+  void *Items[8];
+  for (unsigned i = 0; i != 8; ++i)
+    Items[i] = &N;
+  llvm_execute_on_threads(bumpCounter, Items, 8, 4);
+  EXPECT_EQ(8000u, Counter);
+}
+
+TEST(StatisticTest, MoreThreadsThanShards) {
+  // Threads beyond the number of shards share one; no update may be lost.
+  ResetStatistics();
+  unsigned N = 1000;
+  void *Items[40];
+  for (unsigned i = 0; i != 40; ++i)
+    Items[i] = &N;
+  llvm_execute_on_threads(bumpCounter, Items, 40, 40);
+  EXPECT_EQ(40000u, Counter);
+
+  Counter++;
+  Counter--;
+  Counter /= 1000;
+  EXPECT_EQ(40u, Counter);
+}
+
+}
@@ -0,0 +1,247 @@
+//===- llvm/unittest/Bitcode/ArchiveTest.cpp - Tests for Archive ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Bitcode/Archive.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace llvm {
+namespace {
+
+static void addFunction(Module *Mod, const Twine &Name) {
+  FunctionType *FuncTy =
+    FunctionType::get(Type::getVoidTy(Mod->getContext()), false);
+  Function *Func = Function::Create(FuncTy, GlobalValue::ExternalLinkage,
+                                    Name, Mod);
+  BasicBlock *Entry = BasicBlock::Create(Mod->getContext(), "entry", Func);
+  new UnreachableInst(Mod->getContext(), Entry);
+}
+
+static std::string writeModuleToTempFile(Module *Mod) {
+  int FD;
+  SmallString<128> Path;
+  EXPECT_FALSE(sys::fs::unique_file("archive-test-%%%%%%.bc", FD, Path));
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  WriteBitcodeToFile(Mod, OS);
+  return Path.str();
+}
+
+// Find the member named Name, which must be one of the symbol tables with a
+// name that fits the header, and return the offset of its data and its size.
+static bool findRawMember(StringRef Archive, StringRef Name, size_t &Offset,
+                          size_t &Size) {
+  const size_t HeaderSize = 60;
+  size_t At = 8;
+  while (At + HeaderSize <= Archive.size()) {
+    StringRef Header = Archive.substr(At, HeaderSize);
+    Size = strtoul(Header.substr(48, 10).str().c_str(), 0, 10);
+    Offset = At + HeaderSize;
+    if (Header.startswith(Name))
+      return true;
+    At = (Offset + Size + 1) & ~size_t(1);
+  }
+  return false;
+}
+
+// Read one VBR encoded integer of the LLVM symbol table.
+static unsigned readVBR(const char *&At) {
+  unsigned Result = 0;
+  for (unsigned Shift = 0; ; Shift += 7) {
+    unsigned char C = *At++;
+    Result |= unsigned(C & 0x7f) << Shift;
+    if (!(C & 0x80))
+      return Result;
+  }
+}
+
+class ArchiveTest : public ::testing::Test {
+protected:
+  LLVMContext Context;
+  SmallVector<std::string, 3> Files;
+  sys::Path ArchivePath;
+
+  virtual void SetUp() {
+    // One member with many symbols, so that some of them collide in the
+    // index, and one with a single function.
+    OwningPtr<Module> Big(new Module("big", Context));
+    for (unsigned i = 0; i != 200; ++i)
+      addFunction(Big.get(), "f" + Twine(i));
+    Files.push_back(writeModuleToTempFile(Big.get()));
+
+    OwningPtr<Module> Small(new Module("small", Context));
+    addFunction(Small.get(), "bar");
+    Files.push_back(writeModuleToTempFile(Small.get()));
+
+    int FD;
+    SmallString<128> Path;
+    ASSERT_FALSE(sys::fs::unique_file("archive-test-%%%%%%.a", FD, Path));
+    ::close(FD);
+    Files.push_back(Path.str());
+    ArchivePath = sys::Path(Path.str());
+
+    std::string ErrMsg;
+    OwningPtr<Archive> Writer(Archive::CreateEmpty(ArchivePath, Context));
+    ASSERT_FALSE(Writer->addFileBefore(sys::Path(Files[0]), Writer->end(),
+                                       &ErrMsg));
+    ASSERT_FALSE(Writer->addFileBefore(sys::Path(Files[1]), Writer->end(),
+                                       &ErrMsg));
+    ASSERT_FALSE(Writer->writeToDisk(true, false, &ErrMsg)) << ErrMsg;
+  }
+
+  virtual void TearDown() {
+    for (unsigned i = 0, e = Files.size(); i != e; ++i) {
+      bool Existed;
+      sys::fs::remove(Files[i], Existed);
+    }
+  }
+};
+
+TEST_F(ArchiveTest, FindModuleDefiningSymbol) {
+  std::string ErrMsg;
+  OwningPtr<Archive> A(Archive::OpenAndLoadSymbols(ArchivePath, Context,
+                                                   &ErrMsg));
+  ASSERT_TRUE(A.get() != 0) << ErrMsg;
+
+  for (unsigned i = 0; i != 200; ++i) {
+    std::string Name = ("f" + Twine(i)).str();
+    Module *M = A->findModuleDefiningSymbol(Name, &ErrMsg);
+    ASSERT_TRUE(M != 0) << Name;
+    EXPECT_TRUE(M->getFunction(Name) != 0);
+  }
+  Module *M = A->findModuleDefiningSymbol("bar", &ErrMsg);
+  ASSERT_TRUE(M != 0);
+  EXPECT_TRUE(M->getFunction("bar") != 0);
+
+  EXPECT_TRUE(A->findModuleDefiningSymbol("f200", &ErrMsg) == 0);
+  EXPECT_TRUE(A->findModuleDefiningSymbol("ba", &ErrMsg) == 0);
+
+  // The symbol table is still available after the lookups.
+  EXPECT_EQ(201u, A->getSymbolTable().size());
+}
+
+TEST_F(ArchiveTest, FindModulesDefiningSymbols) {
+  std::string ErrMsg;
+  OwningPtr<Archive> A(Archive::OpenAndLoadSymbols(ArchivePath, Context,
+                                                   &ErrMsg));
+  ASSERT_TRUE(A.get() != 0) << ErrMsg;
+
+  std::set<std::string> Symbols;
+  Symbols.insert("bar");
+  Symbols.insert("missing");
+  SmallVector<Module*, 2> Modules;
+  ASSERT_TRUE(A->findModulesDefiningSymbols(Symbols, Modules, &ErrMsg));
+  ASSERT_EQ(1u, Modules.size());
+  EXPECT_TRUE(Modules[0]->getFunction("bar") != 0);
+  ASSERT_EQ(1u, Symbols.size());
+  EXPECT_EQ("missing", *Symbols.begin());
+}
+
+TEST_F(ArchiveTest, LoadArchiveSkipsSymbolIndex) {
+  std::string ErrMsg;
+  OwningPtr<Archive> A(Archive::OpenAndLoad(ArchivePath, Context, &ErrMsg));
+  ASSERT_TRUE(A.get() != 0) << ErrMsg;
+  EXPECT_EQ(2u, A->size());
+  EXPECT_EQ(201u, A->getSymbolTable().size());
+  EXPECT_TRUE(A->findModuleDefiningSymbol("f42", &ErrMsg) != 0);
+}
+
+TEST_F(ArchiveTest, OlderReaderFindsMembers) {
+  // A reader that does not know the symbol index counts member offsets from
+  // the end of the symbol table, where the index starts.
+  OwningPtr<MemoryBuffer> Buffer;
+  ASSERT_FALSE(MemoryBuffer::getFile(ArchivePath.str(), Buffer));
+  StringRef Raw = Buffer->getBuffer();
+  size_t TableOffset, TableSize, IndexOffset, IndexSize;
+  ASSERT_TRUE(findRawMember(Raw, "#_LLVM_SYM_TAB_#", TableOffset, TableSize));
+  ASSERT_TRUE(findRawMember(Raw, "#_LLVM_SYM_IDX_#", IndexOffset, IndexSize));
+  // The symbol table comes first, where older readers look for it.
+  EXPECT_EQ(8u + 60, TableOffset);
+  size_t FirstFile = (TableOffset + TableSize + 1) & ~size_t(1);
+  EXPECT_EQ(FirstFile + 60, IndexOffset);
+
+  const char *At = Raw.data() + TableOffset;
+  const char *End = At + TableSize;
+  unsigned Found = 0;
+  while (At < End) {
+    unsigned Offset = readVBR(At);
+    unsigned Length = readVBR(At);
+    StringRef Name(At, Length);
+    At += Length;
+    if (Name != "bar" && Name != "f7")
+      continue;
+    ++Found;
+    size_t Member = FirstFile + Offset;
+    ASSERT_LT(Member + 60, Raw.size());
+    size_t Size = strtoul(Raw.substr(Member + 48, 10).str().c_str(), 0, 10);
+    // Skip a BSD style long name stored in front of the data.
+    size_t Data = Member + 60;
+    if (Raw.substr(Member, 3) == "#1/") {
+      size_t NameLength = strtoul(Raw.substr(Member + 3, 13).str().c_str(),
+                                  0, 10);
+      Data += NameLength;
+      Size -= NameLength;
+    }
+    OwningPtr<MemoryBuffer> MemberBuffer(
+        MemoryBuffer::getMemBuffer(Raw.substr(Data, Size), "", false));
+    OwningPtr<Module> M(ParseBitcodeFile(MemberBuffer.get(), Context));
+    ASSERT_TRUE(M.get() != 0) << Name.str();
+    EXPECT_TRUE(M->getFunction(Name) != 0) << Name.str();
+  }
+  EXPECT_EQ(2u, Found);
+}
+
+TEST_F(ArchiveTest, StaleSymbolIndexIsIgnored) {
+  // Make the index look as if it was built for another symbol table and
+  // point all of its entries at the index itself. The symbol table must be
+  // used instead.
+  std::string Raw;
+  {
+    OwningPtr<MemoryBuffer> Buffer;
+    ASSERT_FALSE(MemoryBuffer::getFile(ArchivePath.str(), Buffer));
+    Raw = Buffer->getBuffer();
+  }
+  size_t IndexOffset, IndexSize;
+  ASSERT_TRUE(findRawMember(Raw, "#_LLVM_SYM_IDX_#", IndexOffset, IndexSize));
+  Raw[IndexOffset + 4] ^= 1;
+  unsigned char *P = (unsigned char *)&Raw[IndexOffset];
+  unsigned NumBuckets = P[0] | (P[1] << 8) | (P[2] << 16) | (P[3] << 24);
+  for (unsigned i = 0; i != NumBuckets; ++i)
+    memset(&Raw[IndexOffset + 8 + i * 16 + 12], 0, 4);
+  {
+    std::string ErrMsg;
+    raw_fd_ostream OS(ArchivePath.c_str(), ErrMsg, raw_fd_ostream::F_Binary);
+    ASSERT_TRUE(ErrMsg.empty()) << ErrMsg;
+    OS << Raw;
+  }
+
+  std::string ErrMsg;
+  OwningPtr<Archive> A(Archive::OpenAndLoadSymbols(ArchivePath, Context,
+                                                   &ErrMsg));
+  ASSERT_TRUE(A.get() != 0) << ErrMsg;
+  Module *M = A->findModuleDefiningSymbol("bar", &ErrMsg);
+  ASSERT_TRUE(M != 0) << ErrMsg;
+  EXPECT_TRUE(M->getFunction("bar") != 0);
+  M = A->findModuleDefiningSymbol("f42", &ErrMsg);
+  ASSERT_TRUE(M != 0) << ErrMsg;
+  EXPECT_TRUE(M->getFunction("f42") != 0);
+}
+
+}
+}
@@ -0,0 +1,59 @@
+//===- llvm/unittest/IR/LLVMContextTest.cpp - LLVMContext unit tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+// Build a module that uses a named struct type, aggregate and expression
+// constants, and metadata.
+static Module *buildModule(LLVMContext &C) {
+  Module *M = new Module("m", C);
+  StructType *S = StructType::create(C, "S");
+  Type *I32 = Type::getInt32Ty(C);
+  Type *Elts[] = { I32, I32 };
+  S->setBody(Elts);
+  Constant *Fields[] = { ConstantInt::get(I32, 1), ConstantInt::get(I32, 2) };
+  GlobalVariable *G =
+    new GlobalVariable(*M, S, false, GlobalValue::InternalLinkage,
+                       ConstantStruct::get(S, Fields), "g");
+  new GlobalVariable(*M, I32->getPointerTo(), false,
+                     GlobalValue::InternalLinkage,
+                     ConstantExpr::getBitCast(G, I32->getPointerTo()), "p");
+  Value *Ops[] = { ConstantInt::getTrue(C), MDString::get(C, "x") };
+  M->getOrInsertNamedMetadata("md")->addOperand(MDNode::get(C, Ops));
+  return M;
+}
+
+TEST(LLVMContextTest, ResetModuleState) {
+  LLVMContext C;
+  Type *I32 = Type::getInt32Ty(C);
+
+  delete buildModule(C);
+  C.resetModuleState();
+
+  // Types survive, while struct names and constants start over.
+  EXPECT_EQ(I32, Type::getInt32Ty(C));
+  Module *M = buildModule(C);
+  Type *GTy = M->getNamedGlobal("g")->getType()->getElementType();
+  EXPECT_EQ("S", GTy->getStructName());
+  EXPECT_TRUE(ConstantInt::getTrue(C)->isOne());
+  EXPECT_EQ(ConstantInt::get(I32, 7), ConstantInt::get(I32, 7));
+  delete M;
+  C.resetModuleState();
+}
+
+}  // end anonymous namespace
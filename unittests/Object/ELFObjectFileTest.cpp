@@ -0,0 +1,245 @@
+//===- llvm/unittest/Object/ELFObjectFileTest.cpp - ELF object tests ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/ELF.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+#include <cstring>
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+typedef ELFType<support::little, 8, true> ELF64LE;
+typedef ELFObjectFile<ELF64LE> ELF64LEObjectFile;
+typedef Elf_Ehdr_Impl<ELF64LE> Ehdr;
+typedef Elf_Shdr_Impl<ELF64LE> Shdr;
+typedef Elf_Sym_Impl<ELF64LE> Sym;
+
+struct SymbolDesc {
+  const char *Name;
+  unsigned char Type;
+  uint16_t SectionIndex;
+  uint64_t Value;
+};
+
+// The section indices of the object buildObject() writes.
+enum {
+  TextIndex = 1,
+  DynSymIndex,
+  DynStrIndex,
+  SymTabIndex,
+  StrTabIndex,
+  ShStrTabIndex,
+  NumSections
+};
+
+// .text is at 0x1000. a and a_alias share an address; the section symbol,
+// the undefined symbol and the absolute symbol are not in the address
+// index.
+const SymbolDesc StaticSymbols[] = {
+  { "a", ELF::STT_FUNC, TextIndex, 0x1000 },
+  { "a_alias", ELF::STT_FUNC, TextIndex, 0x1000 },
+  { "", ELF::STT_SECTION, TextIndex, 0x1000 },
+  { "undef", ELF::STT_NOTYPE, ELF::SHN_UNDEF, 0 },
+  { "b", ELF::STT_OBJECT, TextIndex, 0x1040 },
+  { "abs", ELF::STT_NOTYPE, ELF::SHN_ABS, 0x1020 },
+  { "c", ELF::STT_NOTYPE, TextIndex, 0x1080 }
+};
+
+// Dynamic symbols are not in the address index either.
+const SymbolDesc DynamicSymbols[] = {
+  { "dyn_a", ELF::STT_FUNC, TextIndex, 0x1010 },
+  { "dyn_b", ELF::STT_OBJECT, TextIndex, 0x1040 }
+};
+
+uint32_t addString(std::string &Table, const char *S) {
+  if (!*S)
+    return 0;
+  uint32_t Offset = Table.size();
+  Table += S;
+  Table += '\0';
+  return Offset;
+}
+
+// Append a symbol table holding a null symbol and Symbols to Data, and
+// their names to Strings.
+void addSymbolTable(std::string &Data, std::string &Strings,
+                    const SymbolDesc *Symbols, unsigned NumSymbols) {
+  Strings.assign(1, '\0');
+  Data.append(sizeof(Sym), '\0');
+  for (unsigned i = 0; i != NumSymbols; ++i) {
+    Sym S;
+    memset(&S, 0, sizeof(S));
+    S.st_name = addString(Strings, Symbols[i].Name);
+    S.setBindingAndType(Symbols[i].Type == ELF::STT_SECTION ? ELF::STB_LOCAL
+                                                            : ELF::STB_GLOBAL,
+                        Symbols[i].Type);
+    S.st_shndx = Symbols[i].SectionIndex;
+    S.st_value = Symbols[i].Value;
+    Data.append(reinterpret_cast<const char *>(&S), sizeof(S));
+  }
+}
+
+// Build a shared object with a .text section and both a .dynsym and a
+// .symtab.
+std::string buildObject() {
+  Shdr Sections[NumSections];
+  memset(Sections, 0, sizeof(Sections));
+  std::string SectionNames(1, '\0');
+  const char *Names[NumSections] = {
+    "", ".text", ".dynsym", ".dynstr", ".symtab", ".strtab", ".shstrtab"
+  };
+  for (unsigned i = 1; i != NumSections; ++i)
+    Sections[i].sh_name = addString(SectionNames, Names[i]);
+
+  std::string Data(sizeof(Ehdr), '\0');
+  Sections[TextIndex].sh_type = ELF::SHT_PROGBITS;
+  Sections[TextIndex].sh_addr = 0x1000;
+  Sections[TextIndex].sh_offset = Data.size();
+  Sections[TextIndex].sh_size = 0x100;
+  Data.append(0x100, '\0');
+
+  std::string DynStr, StrTab;
+  Sections[DynSymIndex].sh_type = ELF::SHT_DYNSYM;
+  Sections[DynSymIndex].sh_offset = Data.size();
+  addSymbolTable(Data, DynStr, DynamicSymbols,
+                 array_lengthof(DynamicSymbols));
+  Sections[DynSymIndex].sh_size = Data.size() -
+                                  Sections[DynSymIndex].sh_offset;
+  Sections[DynSymIndex].sh_link = DynStrIndex;
+  Sections[DynSymIndex].sh_entsize = sizeof(Sym);
+
+  Sections[SymTabIndex].sh_type = ELF::SHT_SYMTAB;
+  Sections[SymTabIndex].sh_offset = Data.size();
+  addSymbolTable(Data, StrTab, StaticSymbols, array_lengthof(StaticSymbols));
+  Sections[SymTabIndex].sh_size = Data.size() -
+                                  Sections[SymTabIndex].sh_offset;
+  Sections[SymTabIndex].sh_link = StrTabIndex;
+  Sections[SymTabIndex].sh_entsize = sizeof(Sym);
+
+  const unsigned StringIndices[] = { DynStrIndex, StrTabIndex, ShStrTabIndex };
+  const std::string *StringTables[] = { &DynStr, &StrTab, &SectionNames };
+  for (unsigned i = 0; i != array_lengthof(StringIndices); ++i) {
+    Shdr &S = Sections[StringIndices[i]];
+    S.sh_type = ELF::SHT_STRTAB;
+    S.sh_offset = Data.size();
+    S.sh_size = StringTables[i]->size();
+    Data += *StringTables[i];
+  }
+
+  Ehdr H;
+  memset(&H, 0, sizeof(H));
+  memcpy(H.e_ident, ELF::ElfMagic, strlen(ELF::ElfMagic));
+  H.e_ident[ELF::EI_CLASS] = ELF::ELFCLASS64;
+  H.e_ident[ELF::EI_DATA] = ELF::ELFDATA2LSB;
+  H.e_ident[ELF::EI_VERSION] = ELF::EV_CURRENT;
+  H.e_type = ELF::ET_DYN;
+  H.e_machine = ELF::EM_X86_64;
+  H.e_version = ELF::EV_CURRENT;
+  H.e_shoff = Data.size();
+  H.e_ehsize = sizeof(Ehdr);
+  H.e_shentsize = sizeof(Shdr);
+  H.e_shnum = NumSections;
+  H.e_shstrndx = ShStrTabIndex;
+  Data.replace(0, sizeof(H), reinterpret_cast<const char *>(&H), sizeof(H));
+  Data.append(reinterpret_cast<const char *>(Sections), sizeof(Sections));
+  return Data;
+}
+
+class ELFObjectFileTest : public testing::Test {
+protected:
+  OwningPtr<ELF64LEObjectFile> Obj;
+
+  virtual void SetUp() {
+    error_code ec;
+    Obj.reset(new ELF64LEObjectFile(
+        MemoryBuffer::getMemBufferCopy(buildObject(), "test.so"), ec));
+    ASSERT_FALSE(ec);
+  }
+
+  std::string getName(const SymbolRef &Symbol) {
+    StringRef Name;
+    if (Symbol.getName(Name))
+      return "<error>";
+    return Name;
+  }
+
+  std::string findName(uint64_t Address) {
+    symbol_iterator I = Obj->end_symbols();
+    if (Obj->findSymbolByAddress(Address, I))
+      return "<error>";
+    if (I == Obj->end_symbols())
+      return "<none>";
+    return getName(*I);
+  }
+};
+
+TEST_F(ELFObjectFileTest, SymbolNames) {
+  error_code ec;
+  std::vector<std::string> Names;
+  for (symbol_iterator I = Obj->begin_symbols(), E = Obj->end_symbols();
+       I != E; I.increment(ec)) {
+    ASSERT_FALSE(ec);
+    Names.push_back(getName(*I));
+  }
+  ASSERT_EQ(array_lengthof(StaticSymbols), Names.size());
+  for (unsigned i = 0; i != Names.size(); ++i) {
+    // A section symbol is named after its section.
+    if (StaticSymbols[i].Type == ELF::STT_SECTION)
+      EXPECT_EQ(".text", Names[i]);
+    else
+      EXPECT_EQ(StaticSymbols[i].Name, Names[i]);
+  }
+
+  Names.clear();
+  for (symbol_iterator I = Obj->begin_dynamic_symbols(),
+                       E = Obj->end_dynamic_symbols();
+       I != E; I.increment(ec)) {
+    ASSERT_FALSE(ec);
+    Names.push_back(getName(*I));
+  }
+  ASSERT_EQ(array_lengthof(DynamicSymbols), Names.size());
+  for (unsigned i = 0; i != Names.size(); ++i)
+    EXPECT_EQ(DynamicSymbols[i].Name, Names[i]);
+}
+
+TEST_F(ELFObjectFileTest, SymbolsByAddress) {
+  ArrayRef<ELF64LEObjectFile::SymbolAddress> Symbols =
+    Obj->getSymbolsByAddress();
+  const char *Expected[] = { "a", "a_alias", "b", "c" };
+  ASSERT_EQ(array_lengthof(Expected), Symbols.size());
+  for (unsigned i = 0; i != Symbols.size(); ++i) {
+    EXPECT_EQ(Expected[i], getName(Obj->getSymbolRef(Symbols[i])));
+    EXPECT_EQ(unsigned(TextIndex), Symbols[i].SectionIndex);
+    if (i != 0)
+      EXPECT_LE(Symbols[i - 1].Address, Symbols[i].Address);
+  }
+  EXPECT_EQ(0x1000u, Symbols[0].Address);
+  EXPECT_EQ(0x1080u, Symbols[3].Address);
+}
+
+TEST_F(ELFObjectFileTest, FindSymbolByAddress) {
+  EXPECT_EQ("<none>", findName(0xfff));
+  // Of two symbols at one address the first in the symbol table is found.
+  EXPECT_EQ("a", findName(0x1000));
+  // An address between two symbols belongs to the lower one. Neither the
+  // absolute symbol nor the dynamic symbol in between is considered.
+  EXPECT_EQ("a", findName(0x1010));
+  EXPECT_EQ("a", findName(0x103f));
+  EXPECT_EQ("b", findName(0x1040));
+  EXPECT_EQ("b", findName(0x107f));
+  EXPECT_EQ("c", findName(0x1080));
+  EXPECT_EQ("c", findName(0x2000));
+}
+
+}
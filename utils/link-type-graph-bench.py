@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+
+# Benchmarks the IR linker on many modules that share a large struct type
+# graph, the way the modules of a big C++ program share the class hierarchy
+# declared in common headers.
+#
+# Every module declares the same chain of named struct types. Each type embeds
+# the previous one and points to an earlier one, and a self-referencing list
+# node ties the graph into cycles. Each module also has a few types of its own
+# and functions that use the shared types in their bodies. The modules are
+# assembled with llvm-as and linked with a single llvm-link run, whose wall
+# time and peak memory are reported.
+#
+# Usage: link-type-graph-bench.py [-n 500] [--types 200] [--bindir DIR]
+
+# This script runs with Python 2.7 and 3.2+
+
+from __future__ import print_function
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+def shared_types(num_types):
+  lines = ['%struct.Node = type { %struct.Node*, %struct.T0* }',
+           '%struct.T0 = type { i32, i8* }']
+  for i in range(1, num_types):
+    lines.append('%%struct.T%d = type { %%struct.T%d, i32, %%struct.T%d*, '
+                 '%%struct.Node* }' % (i, i - 1, i // 2))
+  return lines
+
+def module_source(index, num_types, num_functions):
+  top = num_types - 1
+  lines = shared_types(num_types)
+  lines.append('%%struct.Local%d = type { %%struct.T%d*, i64 }' % (index, top))
+  lines.append('')
+  lines.append('@list = linkonce_odr global %struct.Node zeroinitializer')
+  lines.append('@local%d = global %%struct.Local%d zeroinitializer' %
+               (index, index))
+  lines.append('')
+  lines.append('declare void @use(%%struct.T%d*)' % top)
+  for f in range(num_functions):
+    # Spread the functions over the type chain so that most types are only
+    # referenced from function bodies.
+    t = (index + f * 7) % num_types
+    lines.append('''
+define void @f%d_%d(%%struct.T%d* %%p) {
+  %%q = getelementptr %%struct.T%d* %%p, i32 0, i32 0
+  %%r = bitcast %%struct.T%d* %%p to %%struct.T%d*
+  call void @use(%%struct.T%d* %%r)
+  ret void
+}''' % (index, f, t, t, t, top, top))
+  return '\n'.join(lines) + '\n'
+
+def find_tool(bindir, name):
+  if bindir:
+    return os.path.join(bindir, name)
+  return name
+
+def main():
+  parser = argparse.ArgumentParser()
+  parser.add_argument('-n', dest='num_modules', type=int, default=500,
+                      help='number of modules to link')
+  parser.add_argument('--types', dest='num_types', type=int, default=200,
+                      help='number of shared struct types')
+  parser.add_argument('--functions', dest='num_functions', type=int,
+                      default=20, help='number of functions per module')
+  parser.add_argument('--bindir', help='directory holding llvm-as and '
+                      'llvm-link (default: search PATH)')
+  parser.add_argument('--keep', action='store_true',
+                      help='keep the generated modules')
+  args = parser.parse_args()
+
+  llvm_as = find_tool(args.bindir, 'llvm-as')
+  llvm_link = find_tool(args.bindir, 'llvm-link')
+
+  workdir = tempfile.mkdtemp(prefix='link-type-graph-')
+  try:
+    inputs = []
+    for i in range(args.num_modules):
+      bc = os.path.join(workdir, 'm%d.bc' % i)
+      p = subprocess.Popen([llvm_as, '-o', bc], stdin=subprocess.PIPE)
+      p.communicate(module_source(i, args.num_types,
+                                  args.num_functions).encode('ascii'))
+      if p.returncode != 0:
+        sys.exit('llvm-as failed on module %d' % i)
+      inputs.append(bc)
+
+    output = os.path.join(workdir, 'linked.bc')
+    start = time.time()
+    p = subprocess.Popen([llvm_link, '-o', output] + inputs)
+    _, status, usage = os.wait4(p.pid, 0)
+    elapsed = time.time() - start
+    if status != 0:
+      sys.exit('llvm-link failed')
+
+    print('linked %d modules sharing %d struct types' %
+          (args.num_modules, args.num_types))
+    print('llvm-link time: %.2f s' % elapsed)
+    # ru_maxrss is in kilobytes on Linux.
+    print('llvm-link peak RSS: %d KB' % usage.ru_maxrss)
+  finally:
+    if args.keep:
+      print('modules kept in %s' % workdir)
+    else:
+      shutil.rmtree(workdir)
+
+if __name__ == '__main__':
+  main()